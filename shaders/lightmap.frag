@@ -0,0 +1,20 @@
+#version 130
+
+uniform vec4 Ambient_uniform;
+uniform sampler2D TextureMap_uniform;
+uniform sampler2D Lightmap_uniform;         // Baked diffuse light, ambient occlusion in alpha
+
+varying vec2 uv;
+varying vec2 lightmapUv;
+
+
+
+void main()
+{
+    vec4 fvTexture  = texture2D(TextureMap_uniform, uv);
+    vec4 fvLightmap = texture2D(Lightmap_uniform, lightmapUv);
+
+    vec3 fvColour = Ambient_uniform.rgb * fvLightmap.a + fvLightmap.rgb * fvTexture.rgb;
+
+    gl_FragColor = vec4(fvColour, 1.0);
+}
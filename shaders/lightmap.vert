@@ -0,0 +1,23 @@
+#version 130
+
+// Attributes
+attribute vec3 aVertexPosition;
+attribute vec2 aVertexTexCoord;
+attribute vec2 aLightmapTexCoord;
+
+// Uniforms
+uniform mat4x4 ModelViewMatrix_uniform;
+uniform mat4x4 ProjectionMatrix_uniform;
+
+varying vec2 uv;
+varying vec2 lightmapUv;
+
+
+
+void main()
+{
+	uv = aVertexTexCoord;
+	lightmapUv = aLightmapTexCoord;
+
+	gl_Position = ProjectionMatrix_uniform * ModelViewMatrix_uniform * vec4(aVertexPosition, 1.0);
+}
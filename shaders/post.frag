@@ -0,0 +1,41 @@
+#version 120
+
+// Uniforms
+uniform int Mode_uniform;				// 0 bright pass, 1 blur, 2 composite
+uniform sampler2D Source_uniform;
+uniform sampler2D Bloom_uniform;
+uniform vec2 TexelStep_uniform;			// Blur direction, one texel of the source
+uniform float Threshold_uniform;
+uniform float Intensity_uniform;
+
+varying vec2 uv;
+
+
+
+void main()
+{
+	vec3 colour = texture2D(Source_uniform, uv).rgb;
+
+	// Keep Only what is Brighter than the Threshold
+	if (Mode_uniform == 0)
+	{
+		float brightness = max(colour.r, max(colour.g, colour.b));
+		colour *= max(brightness - Threshold_uniform, 0.0) / max(1.0 - Threshold_uniform, 0.0001);
+	}
+
+	// Nine Tap Gaussian along One Axis
+	else if (Mode_uniform == 1)
+	{
+		colour *= 0.2270270270;
+		colour += texture2D(Source_uniform, uv + TexelStep_uniform * 1.3846153846).rgb * 0.3162162162;
+		colour += texture2D(Source_uniform, uv - TexelStep_uniform * 1.3846153846).rgb * 0.3162162162;
+		colour += texture2D(Source_uniform, uv + TexelStep_uniform * 3.2307692308).rgb * 0.0702702703;
+		colour += texture2D(Source_uniform, uv - TexelStep_uniform * 3.2307692308).rgb * 0.0702702703;
+	}
+
+	// Scene plus Bloom
+	else
+		colour += texture2D(Bloom_uniform, uv).rgb * Intensity_uniform;
+
+	gl_FragColor = vec4(colour, 1.0);
+}
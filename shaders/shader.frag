@@ -1,10 +1,18 @@
-#version 120
+#version 130
 
 uniform vec4 Ambient_uniform;
 uniform vec4 Specular_uniform;
 uniform float SpecularPower_uniform;
 uniform sampler2D TextureMap_uniform;
 
+// Clustered Point Lights
+uniform sampler2D LightData_uniform;        // Two texels per light: view position and radius, colour
+uniform sampler2D ClusterData_uniform;      // Offset and count of each cluster's light list
+uniform sampler2D LightIndices_uniform;     // Light lists of every cluster, 1024 per row
+uniform vec4 ClusterScale_uniform;          // Tiles per pixel in x and y, slice scale, depth of the first slice
+uniform ivec3 ClusterCount_uniform;         // Tiles in x and y, depth slices
+uniform int PointLightCount_uniform;
+
 varying vec3 ViewDirection;
 varying vec3 LightDirection;
 varying vec3 Normal;
@@ -23,9 +31,47 @@ void main()
     vec3 fvViewDirection  = normalize(ViewDirection);
     float fRDotV           = max( 0.0, dot( fvReflection, fvViewDirection ) );
    
-    vec4 fvTotalDiffuse   = fNDotL * texture2D(TextureMap_uniform, uv);
+    vec4 fvTexture        = texture2D(TextureMap_uniform, uv);
+    vec4 fvTotalDiffuse   = fNDotL * fvTexture;
     vec4 fvTotalSpecular  = Specular_uniform * ( pow(fRDotV, SpecularPower_uniform) );
     
-    gl_FragColor = vec4((Ambient_uniform.rgb + fvTotalDiffuse.rgb + fvTotalSpecular.rgb), 1.0);
+    vec3 fvColour = Ambient_uniform.rgb + fvTotalDiffuse.rgb + fvTotalSpecular.rgb;
+
+    // Point Lights of the Cluster Containing this Fragment
+    if (PointLightCount_uniform > 0)
+    {
+        float fDepth = ViewDirection.z;
+        ivec2 ivTile = clamp(ivec2(gl_FragCoord.xy * ClusterScale_uniform.xy), ivec2(0), ClusterCount_uniform.xy - 1);
+        int iSlice = 0;
+        if (fDepth > ClusterScale_uniform.w)
+            iSlice = min(1 + int(log(fDepth / ClusterScale_uniform.w) * ClusterScale_uniform.z), ClusterCount_uniform.z - 1);
+
+        vec2 fvCluster = texelFetch(ClusterData_uniform, ivec2(ivTile.x + ivTile.y * ClusterCount_uniform.x, iSlice), 0).rg;
+        int iOffset = int(fvCluster.r);
+        int iCount = int(fvCluster.g);
+
+        vec3 fvPosition = -ViewDirection;
+        for (int i = 0; i < iCount; i++)
+        {
+            int iIndex = iOffset + i;
+            int iLight = int(texelFetch(LightIndices_uniform, ivec2(iIndex % 1024, iIndex / 1024), 0).r);
+            vec4 fvLightPosition = texelFetch(LightData_uniform, ivec2(0, iLight), 0);
+            vec3 fvLightColour = texelFetch(LightData_uniform, ivec2(1, iLight), 0).rgb;
+
+            vec3 fvToLight = fvLightPosition.xyz - fvPosition;
+            float fDistance = length(fvToLight);
+            float fFalloff = clamp(1.0 - fDistance / fvLightPosition.w, 0.0, 1.0);
+            vec3 fvPointDirection = fvToLight / max(fDistance, 0.0001);
+
+            float fPointNDotL = max(0.0, dot(fvNormal, fvPointDirection));
+            vec3 fvPointReflection = reflect(-fvPointDirection, fvNormal);
+            float fPointRDotV = max(0.0, dot(fvPointReflection, fvViewDirection));
+
+            fvColour += fFalloff * fFalloff * fvLightColour *
+                (fPointNDotL * fvTexture.rgb + Specular_uniform.rgb * pow(fPointRDotV, SpecularPower_uniform));
+        }
+    }
+
+    gl_FragColor = vec4(fvColour, 1.0);
 }
 
@@ -1,14 +1,17 @@
-#version 120
+#version 130
 
 // Attributes
 attribute vec3 aVertexPosition;
 attribute vec3 aVertexNormal;
 attribute vec2 aVertexTexCoord;
+attribute vec4 aInstance;					// Position and scale, when drawn instanced
 
 // Uniforms
 uniform mat4x4 ModelViewMatrix_uniform;
 uniform mat4x4 ProjectionMatrix_uniform;
 uniform vec3 LightPosition_uniform;
+uniform int Instanced_uniform;				// ModelViewMatrix is the view alone when set
+uniform float InstanceRotation_uniform;		// Radians about y, the same for every instance
 
 varying vec3 ViewDirection;
 varying vec3 LightDirection;
@@ -20,11 +23,22 @@ varying vec2 uv;
 void main()
 {	
 	uv = aVertexTexCoord;
+
+	// Instances are Rotated, Scaled and then Placed in the World
+	vec3 position = aVertexPosition;
+	vec3 normal = aVertexNormal;
+	if (Instanced_uniform != 0)
+	{
+		float c = cos(InstanceRotation_uniform);
+		float s = sin(InstanceRotation_uniform);
+		position = aInstance.xyz + aInstance.w * vec3(c * position.x + s * position.z, position.y, c * position.z - s * position.x);
+		normal = vec3(c * normal.x + s * normal.z, normal.y, c * normal.z - s * normal.x);
+	}
 	
-	ViewDirection = -vec3(ModelViewMatrix_uniform * vec4(aVertexPosition, 1.0));
+	ViewDirection = -vec3(ModelViewMatrix_uniform * vec4(position, 1.0));
 	LightDirection = LightPosition_uniform;
-	Normal = (ModelViewMatrix_uniform * vec4(aVertexNormal, 0.0)).xyz;
+	Normal = (ModelViewMatrix_uniform * vec4(normal, 0.0)).xyz;
 
-	gl_Position = ProjectionMatrix_uniform * ModelViewMatrix_uniform  * vec4(aVertexPosition,1.0);
+	gl_Position = ProjectionMatrix_uniform * ModelViewMatrix_uniform  * vec4(position,1.0);
 }
 
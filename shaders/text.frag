@@ -0,0 +1,13 @@
+#version 120
+
+uniform sampler2D Atlas_uniform;
+
+varying vec2 uv;
+varying vec3 colour;
+
+
+
+void main()
+{
+    gl_FragColor = vec4(colour, texture2D(Atlas_uniform, uv).r);
+}
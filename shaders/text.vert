@@ -0,0 +1,19 @@
+#version 120
+
+// Attributes
+attribute vec2 aPosition;
+attribute vec2 aTexCoord;
+attribute vec3 aColour;
+
+varying vec2 uv;
+varying vec3 colour;
+
+
+
+void main()
+{
+	uv = aTexCoord;
+	colour = aColour;
+
+	gl_Position = vec4(aPosition, 0.0, 1.0);
+}
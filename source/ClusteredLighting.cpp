@@ -0,0 +1,173 @@
+#include "ClusteredLighting.h"
+#include "Profiler.h"
+
+#include <math.h>
+
+const float ClusteredLighting::clusterNear = 5.0f;
+
+
+ClusteredLighting::ClusteredLighting(JobSystem& jobSystem, int tilesX, int tilesY, int slices) :
+	jobSystem(jobSystem), tilesX(tilesX), tilesY(tilesY), slices(slices), sliceScale(1.0f), projectionX(1.0f), projectionY(1.0f)
+{
+	clusterCounts.resize(tilesX * tilesY * slices);
+	clusterLights.resize(clusterCounts.size() * maxLightsPerCluster);
+	clusterData.resize(clusterCounts.size() * 2);
+}
+
+
+void ClusteredLighting::setLights(const std::vector<PointLight>& lights)
+{
+	this->lights = lights;
+
+	// Light Indices are Stored as 16 Bits per Cluster
+	if (this->lights.size() > 65535)
+		this->lights.resize(65535);
+}
+
+
+void ClusteredLighting::update(Matrix4x4 view, Matrix4x4 projection, float farPlane)
+{
+	double started = Profiler::now();
+
+	const float* v = view.getPtr();
+	const float* p = projection.getPtr();
+	projectionX = p[0];
+	projectionY = p[5];
+
+	// Slice 0 Covers up to clusterNear and the Rest Split Exponentially to the Far Plane
+	sliceScale = (slices - 1) / log(farPlane / clusterNear);
+
+	// Move Lights into View Space, Depth Positive in Front of the Camera
+	int lightCount = (int)lights.size();
+	viewLights.resize(lightCount * 4);
+	lightData.resize(lightCount > 0 ? lightCount * 8 : 8, 0.0f);
+	for (int i = 0; i < lightCount; i++)
+	{
+		const PointLight& light = lights[i];
+		float x = v[0] * light.position.x + v[4] * light.position.y + v[8] * light.position.z + v[12];
+		float y = v[1] * light.position.x + v[5] * light.position.y + v[9] * light.position.z + v[13];
+		float z = v[2] * light.position.x + v[6] * light.position.y + v[10] * light.position.z + v[14];
+
+		viewLights[i * 4 + 0] = x;
+		viewLights[i * 4 + 1] = y;
+		viewLights[i * 4 + 2] = -z;
+		viewLights[i * 4 + 3] = light.radius;
+
+		float* data = &lightData[i * 8];
+		data[0] = x;
+		data[1] = y;
+		data[2] = z;
+		data[3] = light.radius;
+		data[4] = light.colour.x;
+		data[5] = light.colour.y;
+		data[6] = light.colour.z;
+		data[7] = 1.0f;
+	}
+
+	// Assign Lights One Slice per Task
+	jobSystem.parallelFor(slices, [this](int begin, int end) {
+		for (int slice = begin; slice < end; slice++)
+			assignSlice(slice);
+	});
+
+	// Compact the Lists into One Index Array
+	int total = 0;
+	int dropped = 0;
+	for (int cluster = 0; cluster < (int)clusterCounts.size(); cluster++)
+	{
+		int count = clusterCounts[cluster];
+		if (count > maxLightsPerCluster)
+		{
+			dropped += count - maxLightsPerCluster;
+			count = maxLightsPerCluster;
+		}
+		clusterData[cluster * 2 + 0] = (float)total;
+		clusterData[cluster * 2 + 1] = (float)count;
+		total += count;
+	}
+
+	lightIndices.resize((total / indexRowLength + 1) * indexRowLength, 0.0f);
+	for (int cluster = 0; cluster < (int)clusterCounts.size(); cluster++)
+	{
+		int offset = (int)clusterData[cluster * 2 + 0];
+		int count = (int)clusterData[cluster * 2 + 1];
+		const unsigned short* list = &clusterLights[cluster * maxLightsPerCluster];
+		for (int i = 0; i < count; i++)
+			lightIndices[offset + i] = (float)list[i];
+	}
+
+	Profiler::addTime("Light Assignment", Profiler::now() - started);
+	Profiler::addCounter("Point Lights", lightCount);
+	Profiler::addCounter("Cluster Light Indices", total);
+	if (dropped > 0)
+		Profiler::addCounter("Cluster Lights Dropped", dropped);
+}
+
+
+float ClusteredLighting::sliceDepth(int slice) const
+{
+	if (slice <= 0)
+		return 0.0f;
+	return clusterNear * exp((slice - 1) / sliceScale);
+}
+
+
+void ClusteredLighting::assignSlice(int slice)
+{
+	float nearDepth = sliceDepth(slice);
+	float farDepth = slice == slices - 1 ? 1e30f : sliceDepth(slice + 1);
+
+	// Lights Overlapping the Depth Range of the Slice
+	std::vector<int> candidates;
+	for (int i = 0; i < (int)lights.size(); i++)
+	{
+		float depth = viewLights[i * 4 + 2];
+		float radius = viewLights[i * 4 + 3];
+		if (depth + radius >= nearDepth && depth - radius <= farDepth)
+			candidates.push_back(i);
+	}
+
+	// Far Plane of the Last Slice Bounded by the Furthest Candidate
+	if (slice == slices - 1)
+	{
+		farDepth = nearDepth;
+		for (int c = 0; c < (int)candidates.size(); c++)
+			farDepth = fmax(farDepth, viewLights[candidates[c] * 4 + 2] + viewLights[candidates[c] * 4 + 3]);
+	}
+
+	for (int tileY = 0; tileY < tilesY; tileY++)
+	{
+		float ndcY0 = -1.0f + 2.0f * tileY / tilesY;
+		float ndcY1 = -1.0f + 2.0f * (tileY + 1) / tilesY;
+		float minY = fmin(ndcY0 * nearDepth, ndcY0 * farDepth) / projectionY;
+		float maxY = fmax(ndcY1 * nearDepth, ndcY1 * farDepth) / projectionY;
+
+		for (int tileX = 0; tileX < tilesX; tileX++)
+		{
+			float ndcX0 = -1.0f + 2.0f * tileX / tilesX;
+			float ndcX1 = -1.0f + 2.0f * (tileX + 1) / tilesX;
+			float minX = fmin(ndcX0 * nearDepth, ndcX0 * farDepth) / projectionX;
+			float maxX = fmax(ndcX1 * nearDepth, ndcX1 * farDepth) / projectionX;
+
+			int cluster = (slice * tilesY + tileY) * tilesX + tileX;
+			unsigned short* list = &clusterLights[cluster * maxLightsPerCluster];
+			int count = 0;
+
+			// Sphere against the Bounding Box of the Cluster
+			for (int c = 0; c < (int)candidates.size(); c++)
+			{
+				const float* light = &viewLights[candidates[c] * 4];
+				float dx = light[0] < minX ? minX - light[0] : (light[0] > maxX ? light[0] - maxX : 0.0f);
+				float dy = light[1] < minY ? minY - light[1] : (light[1] > maxY ? light[1] - maxY : 0.0f);
+				float dz = light[2] < nearDepth ? nearDepth - light[2] : (light[2] > farDepth ? light[2] - farDepth : 0.0f);
+				if (dx * dx + dy * dy + dz * dz > light[3] * light[3])
+					continue;
+
+				if (count < maxLightsPerCluster)
+					list[count] = (unsigned short)candidates[c];
+				count++;
+			}
+			clusterCounts[cluster] = count;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef CLUSTEREDLIGHTING_H_
+#define CLUSTEREDLIGHTING_H_
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "JobSystem.h"
+
+/* Point Light in World Space, Fading to Nothing at its Radius */
+struct PointLight
+{
+	Vector3f position;
+	Vector3f colour;
+	float radius;
+};
+
+/*
+ * Clustered Light Assignment
+ * The view frustum is split into screen tiles and exponential depth slices. Each frame the lights
+ * are moved into view space and every cluster is given the list of lights whose sphere touches
+ * it, as jobs, one depth slice at a time. The fragment shader finds its cluster from
+ * gl_FragCoord and its view depth and only shades the lights in that cluster's list, so the cost
+ * per pixel follows the number of lights nearby rather than the total.
+ */
+class ClusteredLighting {
+public:
+	ClusteredLighting(JobSystem& jobSystem, int tilesX = 16, int tilesY = 16, int slices = 24);
+	~ClusteredLighting(){};
+
+	void setLights(const std::vector<PointLight>& lights);		// World space lights, up to 65535, kept until changed
+
+	// Assigns Lights to Clusters for a View and Perspective Projection
+	void update(Matrix4x4 view, Matrix4x4 projection, float farPlane);
+
+	// Data for the Shader, Rebuilt by update
+	const std::vector<float>& getLightData() const { return lightData; }		// Two RGBA texels per light: view position and radius, colour
+	const std::vector<float>& getClusterData() const { return clusterData; }	// Offset and count per cluster, x fastest then y then slice
+	const std::vector<float>& getLightIndices() const { return lightIndices; }	// Light index lists of all clusters back to back, padded to whole rows
+
+	int getLightCount() const { return (int)lights.size(); }
+	int getTilesX() const { return tilesX; }
+	int getTilesY() const { return tilesY; }
+	int getSlices() const { return slices; }
+
+	float getSliceScale() const { return sliceScale; }		// Slice = 1 + floor(log(depth / clusterNear) * scale)
+	static const float clusterNear;						// View depth covered by the first slice
+	static const int maxLightsPerCluster = 64;
+	static const int indexRowLength = 1024;				// Light indices per row of the index texture
+
+private:
+	void assignSlice(int slice);
+	float sliceDepth(int slice) const;
+
+	JobSystem& jobSystem;
+
+	int tilesX, tilesY, slices;
+	float sliceScale;
+
+	std::vector<PointLight> lights;
+	std::vector<float> viewLights;		// x, y, depth, radius per light in view space
+
+	// Light Lists per Cluster before Compaction
+	std::vector<int> clusterCounts;
+	std::vector<unsigned short> clusterLights;
+
+	std::vector<float> lightData;
+	std::vector<float> clusterData;
+	std::vector<float> lightIndices;
+
+	float projectionX, projectionY;		// Projection scale along x and y
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "EntityWorld.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+EntityWorld::EntityWorld(JobSystem& jobSystem)
+	: jobSystem(jobSystem), entityCount(0), gridWidth(0), gridDepth(0), gridCellSize(1.0)
+{
+}
+
+
+Entity EntityWorld::create()
+{
+	unsigned int index;
+	if (!freeIndices.empty())
+	{
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)generations.size();
+		generations.push_back(1);		// Generation 0 is Never Used, so Entity 0 is Never Alive
+	}
+
+	entityCount++;
+	return ((Entity)generations[index] << 24) | index;
+}
+
+
+void EntityWorld::destroy(Entity entity)
+{
+	if (!isAlive(entity))
+		return;
+
+	if (pickups.has(entity))
+	{
+		Pickup& pickup = pickups.get(entity);
+		pickupCells[pickup.z * gridWidth + pickup.x] = 0;
+		pickups.remove(entity);
+	}
+	if (transforms.has(entity))
+		transforms.remove(entity);
+	if (velocities.has(entity))
+		velocities.remove(entity);
+	if (bodies.has(entity))
+		bodies.remove(entity);
+	if (tanks.has(entity))
+		tanks.remove(entity);
+	if (balls.has(entity))
+		balls.remove(entity);
+	if (colliders.has(entity))
+		colliders.remove(entity);
+	if (renderables.has(entity))
+		renderables.remove(entity);
+
+	unsigned int index = entity & ComponentArray<Transform>::indexMask;
+	generations[index] = generations[index] == 255 ? 1 : generations[index] + 1;
+	freeIndices.push_back(index);
+	entityCount--;
+}
+
+
+void EntityWorld::clear()
+{
+	transforms.clear();
+	velocities.clear();
+	bodies.clear();
+	tanks.clear();
+	balls.clear();
+	colliders.clear();
+	renderables.clear();
+	pickups.clear();
+	generations.clear();
+	freeIndices.clear();
+	entityCount = 0;
+	std::fill(pickupCells.begin(), pickupCells.end(), 0);
+}
+
+
+void EntityWorld::setPickupGrid(int width, int depth, float cellSize)
+{
+	gridWidth = width;
+	gridDepth = depth;
+	gridCellSize = cellSize;
+	pickupCells.assign(width * depth, 0);
+}
+
+
+Entity EntityWorld::addPickup(int x, int z, Vector3f position, Vector3f min, Vector3f max)
+{
+	Entity entity = create();
+	transforms.add(entity, { position, 0.0 });
+	pickups.add(entity, { x, z, min + position, max + position });
+	pickupCells[z * gridWidth + x] = entity;
+	return entity;
+}
+
+
+void EntityWorld::integrate(float deltaTime)
+{
+	jobSystem.parallelFor(velocities.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (bodies.has(velocities.ownerAt(i)))
+				continue;
+
+			Vector3f& position = transforms.get(velocities.ownerAt(i)).position;
+			Vector3f& velocity = velocities.at(i).linear;
+			position.x += velocity.x * deltaTime;
+			position.y += velocity.y * deltaTime;
+			position.z += velocity.z * deltaTime;
+		}
+	}, entitiesPerJob);
+}
+
+
+void EntityWorld::bounce(Vector3f min, Vector3f max)
+{
+	jobSystem.parallelFor(velocities.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (bodies.has(velocities.ownerAt(i)))
+				continue;
+
+			Vector3f& position = transforms.get(velocities.ownerAt(i)).position;
+			Vector3f& velocity = velocities.at(i).linear;
+			if ((position.x < min.x && velocity.x < 0.0) || (position.x > max.x && velocity.x > 0.0))
+				velocity.x = -velocity.x;
+			if ((position.z < min.z && velocity.z < 0.0) || (position.z > max.z && velocity.z > 0.0))
+				velocity.z = -velocity.z;
+		}
+	}, entitiesPerJob);
+}
+
+
+void EntityWorld::collectPickups(std::vector<Collection>& collected, bool (*touches)(Entity collector, const Pickup& pickup))
+{
+	collected.clear();
+	if (pickups.size() == 0)
+		return;
+
+	// Find the Pickups Each Block of Colliders Touches, Reading Only
+	int blocks = (colliders.size() + entitiesPerJob - 1) / entitiesPerJob;
+	if (touched.size() < blocks)
+		touched.resize(blocks);
+
+	float half = gridCellSize * 0.5f;
+	jobSystem.parallelFor(colliders.size(), [&](int begin, int end)
+	{
+		std::vector<Collection>& found = touched[begin / entitiesPerJob];
+		found.clear();
+		for (int i = begin; i < end; i++)
+		{
+			Entity collector = colliders.ownerAt(i);
+			Vector3f position = transforms.get(collector).position;
+			Vector3f min = colliders.at(i).min + position;
+			Vector3f max = colliders.at(i).max + position;
+
+			// Cells whose Squares the Box Reaches, as a Pickup Stays in its Cell
+			int x0 = std::max(0, (int)ceilf((min.x - half) / gridCellSize));
+			int x1 = std::min(gridWidth - 1, (int)floorf((max.x + half) / gridCellSize));
+			int z0 = std::max(0, (int)ceilf((min.z - half) / gridCellSize));
+			int z1 = std::min(gridDepth - 1, (int)floorf((max.z + half) / gridCellSize));
+			for (int z = z0; z <= z1; z++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					Entity entity = pickupCells[z * gridWidth + x];
+					if (entity == 0)
+						continue;
+
+					const Pickup& pickup = pickups.get(entity);
+					if (min.x <= pickup.max.x && max.x >= pickup.min.x &&
+						min.y <= pickup.max.y && max.y >= pickup.min.y &&
+						min.z <= pickup.max.z && max.z >= pickup.min.z && (!touches || touches(collector, pickup)))
+						found.push_back({ collector, x, z });
+				}
+			}
+		}
+	}, entitiesPerJob);
+
+	// Take them in Collider Order, Skipping Any an Earlier Collider Took
+	for (int block = 0; block < blocks; block++)
+	{
+		for (int i = 0; i < touched[block].size(); i++)
+		{
+			const Collection& touch = touched[block][i];
+			Entity entity = pickupCells[touch.z * gridWidth + touch.x];
+			if (entity == 0)
+				continue;
+
+			collected.push_back(touch);
+			destroy(entity);
+		}
+	}
+}
+
+
+void EntityWorld::gatherPositions(int mesh, std::vector<Vector3f>& positions)
+{
+	positions.clear();
+	for (int i = 0; i < renderables.size(); i++)
+		if (renderables.at(i).mesh == mesh)
+			positions.push_back(transforms.get(renderables.ownerAt(i)).position);
+}
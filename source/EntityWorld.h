@@ -0,0 +1,191 @@
+#ifndef ENTITYWORLD_H_
+#define ENTITYWORLD_H_
+
+#include <vector>
+
+#include "Vector.h"
+#include "JobSystem.h"
+
+// Index in the Low 24 Bits, Generation Above, so a Destroyed Entity's Handle Stops Matching
+typedef unsigned int Entity;
+
+// Where an Entity is
+struct Transform
+{
+	Vector3f position;
+	float rotationDegrees;
+};
+
+// Units per Millisecond - for a Tank, Speed along its Heading in x and z
+struct Velocity
+{
+	Vector3f linear;
+};
+
+// Pushed by Forces, which are Cleared after Each Update
+struct Body
+{
+	Vector3f force;
+	float mass;
+};
+
+// Drives along its Heading, with a Turret that Turns Apart from it
+struct Tank
+{
+	float turretRotationDegrees;
+	bool falling;
+};
+
+// Rolls the Way its Tank's Turret Faces while Launched
+struct Ball
+{
+	Entity tank;
+	bool launched;
+};
+
+// Box about the Position that Collects Pickups it Touches
+struct Collider
+{
+	Vector3f min;
+	Vector3f max;
+};
+
+// Drawn from the Entities, rather than by the Maze
+struct Renderable
+{
+	int mesh;
+	float scale;
+};
+
+// Collected when a Collider Touches its Box, which Lies within Cell (x, z)
+struct Pickup
+{
+	int x, z;
+	Vector3f min;
+	Vector3f max;
+};
+
+/*
+ * Components of One Kind, Packed
+ * A sparse set: the components sit together in a dense array, in no particular order, with the
+ * entity owning each beside it, and a sparse array indexed by entity finds an entity's slot.
+ * Adding appends and removing moves the last component into the gap, so the dense array never
+ * has holes and systems walk it straight through.
+ */
+template <typename T>
+class ComponentArray {
+public:
+	void add(Entity entity, const T& component)
+	{
+		unsigned int index = entity & indexMask;
+		if (index >= sparse.size())
+			sparse.resize(index + 1, -1);
+		sparse[index] = (int)dense.size();
+		dense.push_back(component);
+		owners.push_back(entity);
+	}
+
+	void remove(Entity entity)
+	{
+		int slot = sparse[entity & indexMask];
+		dense[slot] = dense.back();
+		owners[slot] = owners.back();
+		sparse[owners[slot] & indexMask] = slot;
+		sparse[entity & indexMask] = -1;
+		dense.pop_back();
+		owners.pop_back();
+	}
+
+	bool has(Entity entity) const
+	{
+		unsigned int index = entity & indexMask;
+		return index < sparse.size() && sparse[index] >= 0 && owners[sparse[index]] == entity;
+	}
+
+	T& get(Entity entity) { return dense[sparse[entity & indexMask]]; }
+
+	// Dense Order
+	int size() const { return (int)dense.size(); }
+	T& at(int slot) { return dense[slot]; }
+	Entity ownerAt(int slot) const { return owners[slot]; }
+
+	void clear()
+	{
+		dense.clear();
+		owners.clear();
+		sparse.clear();
+	}
+
+	static const unsigned int indexMask = 0xFFFFFF;
+
+private:
+	std::vector<T> dense;
+	std::vector<Entity> owners;
+	std::vector<int> sparse;		// Slot of each entity index, -1 for none
+};
+
+/*
+ * Entities of the Game and the Systems that Update them
+ * An entity is only a handle; what it is comes from the components added to it. Each kind of
+ * component is its own ComponentArray, and each system walks the dense array of the component
+ * it is driven by, looking up the few others it needs by entity. Entities made one after another
+ * keep their components in the same order in every array, so those lookups also move forward
+ * through memory. Pickups are also filed by the cell they are in, so a collider only looks at
+ * the cells under its box and collecting costs the same however many pickups are left. Systems
+ * run as jobs over blocks of their array; collecting finds what each collider touches in jobs,
+ * then takes the pickups on one thread in collider order, so the first to touch one gets it.
+ * Anything with a body is left to the game to move, as what steers it depends on the maze.
+ */
+class EntityWorld {
+public:
+	EntityWorld(JobSystem& jobSystem);
+	~EntityWorld(){};
+
+	Entity create();
+	void destroy(Entity entity);		// Removes all its components
+	bool isAlive(Entity entity) const { return (entity & ComponentArray<Transform>::indexMask) < generations.size() && generations[entity & ComponentArray<Transform>::indexMask] == entity >> 24; }
+	void clear();
+	int getEntityCount() const { return entityCount; }
+
+	void setPickupGrid(int width, int depth, float cellSize);		// Clears any pickups filed
+	Entity addPickup(int x, int z, Vector3f position, Vector3f min, Vector3f max);	// Box relative to the position
+	Entity getPickup(int x, int z) const { return pickupCells[z * gridWidth + x]; }	// 0 for none
+
+	// Pickup Collected by a Collider in the Last Pass
+	struct Collection
+	{
+		Entity collector;
+		int x, z;
+	};
+
+	// Systems
+	void integrate(float deltaTime);						// Moves everything with a velocity and no body
+	void bounce(Vector3f min, Vector3f max);				// Turns back anything without a body moving out of the box, in x and z
+	void collectPickups(std::vector<Collection>& collected, bool (*touches)(Entity collector, const Pickup& pickup) = 0);	// Destroys pickups colliders touch, if touches agrees - called from jobs
+	void gatherPositions(int mesh, std::vector<Vector3f>& positions);	// Of everything drawn with the mesh
+
+	static const int entitiesPerJob = 4096;
+
+	ComponentArray<Transform> transforms;
+	ComponentArray<Velocity> velocities;
+	ComponentArray<Body> bodies;
+	ComponentArray<Tank> tanks;
+	ComponentArray<Ball> balls;
+	ComponentArray<Collider> colliders;
+	ComponentArray<Renderable> renderables;
+	ComponentArray<Pickup> pickups;
+
+private:
+	JobSystem& jobSystem;
+
+	std::vector<unsigned char> generations;		// Per entity index
+	std::vector<unsigned int> freeIndices;
+	int entityCount;
+
+	int gridWidth, gridDepth;
+	float gridCellSize;
+	std::vector<Entity> pickupCells;			// Pickup in each cell, x fastest, 0 for none
+	std::vector<std::vector<Collection>> touched;	// Per block of colliders, reused each pass
+};
+
+#endif
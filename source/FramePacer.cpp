@@ -0,0 +1,222 @@
+#include "FramePacer.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <iostream>
+#include <math.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#else
+#include <GL/glx.h>
+#include <time.h>
+#endif
+
+const double FramePacer::spinThreshold = 2.0;
+const double FramePacer::maxSleep = 4.0;
+
+
+FramePacer::FramePacer(double targetFps) :
+	limiter(true), vsync(false), redisplayPending(true), redisplayPosted(false), nextFrameTime(0), lastFrameTime(-1),
+	reportInterval(300), frames(0), requests(0), intervalStarted(-1), cpuStarted(0),
+	intervalSum(0), intervalSquaredSum(0), intervalMin(0), intervalMax(0), sleepTotal(0), spinTotal(0)
+{
+	setTargetFps(targetFps);
+	lastStats = Stats();
+
+#ifdef _WIN32
+	// Sleep Granularity of 1 Millisecond Instead of the Default 15.6
+	timeBeginPeriod(1);
+#endif
+}
+
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+
+void FramePacer::setTargetFps(double fps)
+{
+	targetInterval = fps > 0.0 ? 1000.0 / fps : 0.0;
+}
+
+
+bool FramePacer::setVsync(bool enabled)
+{
+	int interval = enabled ? 1 : 0;
+
+#ifdef _WIN32
+	typedef BOOL (WINAPI *SwapIntervalProc)(int);
+	SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+	if (swapInterval == NULL || !swapInterval(interval))
+		return false;
+#else
+	typedef int (*SwapIntervalProc)(unsigned int);
+	SwapIntervalProc swapInterval = (SwapIntervalProc)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+	if (swapInterval == NULL)
+		swapInterval = (SwapIntervalProc)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalSGI");
+	if (swapInterval == NULL || swapInterval(interval) != 0)
+		return false;
+#endif
+
+	vsync = enabled;
+	return true;
+}
+
+
+void FramePacer::setLimiter(bool enabled)
+{
+	limiter = enabled;
+	if (!limiter)
+		glutPostRedisplay();
+}
+
+
+void FramePacer::requestRedisplay()
+{
+	requests++;
+	redisplayPending = true;
+
+	// Frames are Posted Back to Back without the Limiter
+	if (!limiter)
+		glutPostRedisplay();
+}
+
+
+void FramePacer::idle()
+{
+	if (!limiter)
+		return;
+
+	double time = Profiler::now();
+
+	// Nothing to Draw, Wait for the Next Request
+	if (!redisplayPending || redisplayPosted)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		sleepTotal += Profiler::now() - time;
+		return;
+	}
+
+	// Sleep while the Frame is Far Off, Returning so GLUT Handles Input and Timers in Between
+	double remaining = nextFrameTime - time;
+	if (remaining > spinThreshold)
+	{
+		double sleep = fmin(remaining - spinThreshold, maxSleep);
+		std::this_thread::sleep_for(std::chrono::microseconds((long long)(sleep * 1000.0)));
+		sleepTotal += Profiler::now() - time;
+		return;
+	}
+
+	// Spin for the Last Moment as Sleeps Overshoot
+	while (Profiler::now() < nextFrameTime)
+		std::this_thread::yield();
+	spinTotal += Profiler::now() - time;
+
+	redisplayPending = false;
+	redisplayPosted = true;
+	glutPostRedisplay();
+}
+
+
+void FramePacer::frameDrawn()
+{
+	double time = Profiler::now();
+	redisplayPosted = false;
+
+	if (intervalStarted < 0.0)
+	{
+		intervalStarted = time;
+		cpuStarted = processCpuTime();
+	}
+
+	// Frame Interval
+	if (lastFrameTime >= 0.0)
+	{
+		double interval = time - lastFrameTime;
+		intervalSum += interval;
+		intervalSquaredSum += interval * interval;
+		if (frames == 0 || interval < intervalMin)
+			intervalMin = interval;
+		if (frames == 0 || interval > intervalMax)
+			intervalMax = interval;
+		frames++;
+	}
+	lastFrameTime = time;
+
+	// Schedule the Next Frame, Resynchronising if a Whole Frame Behind
+	nextFrameTime += targetInterval;
+	if (nextFrameTime < time - targetInterval || targetInterval == 0.0)
+		nextFrameTime = time;
+
+	if (!limiter)
+		glutPostRedisplay();
+
+	if (reportInterval > 0 && frames >= reportInterval)
+		report(time);
+}
+
+
+void FramePacer::report(double time)
+{
+	double wall = time - intervalStarted;
+	double cpu = processCpuTime() - cpuStarted;
+
+	Stats& stats = lastStats;
+	stats.frames = frames;
+	stats.requests = requests;
+	stats.fps = wall > 0.0 ? frames * 1000.0 / wall : 0.0;
+	stats.cpuUtilisation = wall > 0.0 ? cpu / wall : 0.0;
+	stats.meanIntervalMs = intervalSum / frames;
+	stats.jitterMs = sqrt(fmax(intervalSquaredSum / frames - stats.meanIntervalMs * stats.meanIntervalMs, 0.0));
+	stats.maxJitterMs = fmax(intervalMax - stats.meanIntervalMs, stats.meanIntervalMs - intervalMin);
+	stats.sleepMs = sleepTotal / frames;
+	stats.spinMs = spinTotal / frames;
+
+	std::cout << "Frame pacing: " << (limiter ? "limiter" : "busy loop")
+		<< (vsync ? ", vsync" : "")
+		<< ", " << stats.fps << " fps"
+		<< ", CPU " << stats.cpuUtilisation * 100.0 << "%"
+		<< ", interval " << stats.meanIntervalMs << " ms"
+		<< ", jitter " << stats.jitterMs << " ms (max " << stats.maxJitterMs << " ms)"
+		<< ", sleep " << stats.sleepMs << " ms, spin " << stats.spinMs << " ms per frame"
+		<< ", " << stats.requests << " requests into " << stats.frames << " frames" << std::endl;
+
+	// Start the Next Interval
+	frames = 0;
+	requests = 0;
+	intervalStarted = time;
+	cpuStarted = processCpuTime();
+	intervalSum = 0.0;
+	intervalSquaredSum = 0.0;
+	sleepTotal = 0.0;
+	spinTotal = 0.0;
+}
+
+
+double FramePacer::processCpuTime()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+
+	// 100 Nanosecond Units
+	ULARGE_INTEGER kernelTime, userTime;
+	kernelTime.LowPart = kernel.dwLowDateTime;
+	kernelTime.HighPart = kernel.dwHighDateTime;
+	userTime.LowPart = user.dwLowDateTime;
+	userTime.HighPart = user.dwHighDateTime;
+	return (kernelTime.QuadPart + userTime.QuadPart) / 10000.0;
+#else
+	timespec time;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+	return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#endif
+}
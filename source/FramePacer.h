@@ -0,0 +1,77 @@
+#ifndef FRAMEPACER_H_
+#define FRAMEPACER_H_
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+
+/*
+ * Main Loop Scheduler Driving GLUT Redisplays
+ * Input and timer callbacks request a redisplay instead of posting one, and all requests made
+ * before the next frame is due are coalesced into a single frame. The idle callback sleeps until
+ * shortly before the frame is due and spins for the rest so frames start on time without burning
+ * a core. Reports CPU utilisation and frame interval jitter every report interval.
+ */
+class FramePacer {
+public:
+	FramePacer(double targetFps = 60.0);
+	~FramePacer();
+
+	void setTargetFps(double fps);		// 0 draws as soon as a redisplay is requested
+	bool setVsync(bool enabled);		// Sets the swap interval, false if the driver has no swap control
+	void setLimiter(bool enabled);		// false posts a redisplay after every frame, unpaced
+
+	void requestRedisplay();			// Coalesced into the next paced frame
+	void idle();						// Installed as the GLUT idle function
+	void frameDrawn();					// Called after the buffers are swapped
+
+	// Statistics over the Last Report Interval
+	struct Stats
+	{
+		int frames;
+		int requests;				// Redisplays requested, including coalesced ones
+		double fps;
+		double cpuUtilisation;		// Process CPU time over wall time, 1.0 is one core busy
+		double meanIntervalMs;
+		double jitterMs;			// Standard deviation of the frame interval
+		double maxJitterMs;			// Largest deviation from the mean interval
+		double sleepMs;				// Time given back to the OS per frame
+		double spinMs;				// Time spent spinning per frame
+	};
+
+	Stats getStats() const { return lastStats; }
+	void setReportInterval(int frames) { reportInterval = frames; }		// 0 disables reporting
+
+	static double processCpuTime();		// Milliseconds of CPU time used by the process
+
+private:
+	void report(double time);
+
+	static const double spinThreshold;		// Milliseconds before a frame is due to stop sleeping
+	static const double maxSleep;			// Longest sleep before returning to the GLUT loop
+
+	double targetInterval;
+	bool limiter;
+	bool vsync;
+
+	bool redisplayPending;
+	bool redisplayPosted;
+	double nextFrameTime;
+	double lastFrameTime;
+
+	// Current Report Interval
+	int reportInterval;
+	int frames;
+	int requests;
+	double intervalStarted;
+	double cpuStarted;
+	double intervalSum;
+	double intervalSquaredSum;
+	double intervalMin;
+	double intervalMax;
+	double sleepTotal;
+	double spinTotal;
+
+	Stats lastStats;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "FrameReadback.h"
+#include "Profiler.h"
+#include "GLState.h"
+
+#include <string.h>
+
+
+FrameReadback::FrameReadback()
+	: head(0), tail(0), count(0), width(0), height(0), stalls(0)
+{
+}
+
+
+FrameReadback::~FrameReadback()
+{
+	// GL objects belong to the context, which is gone by the time globals are destroyed
+}
+
+
+bool FrameReadback::init(int width, int height, int bufferCount)
+{
+	this->width = width;
+	this->height = height;
+
+	buffers.resize(bufferCount);
+	for (int i = 0; i < bufferCount; i++)
+	{
+		glGenBuffers(1, &buffers[i].buffer);
+		GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, buffers[i].buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, NULL, GL_STREAM_READ);
+		buffers[i].fence = 0;
+		buffers[i].frame = -1;
+	}
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+
+bool FrameReadback::read(int frame)
+{
+	if (buffers.empty() || isFull())
+		return false;
+
+	// With a Pack Buffer Bound glReadPixels Returns at Once and the Copy Happens on the GPU
+	PendingFrame& pending = buffers[head];
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, pending.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pending.frame = frame;
+
+	head = (head + 1) % buffers.size();
+	count++;
+	return true;
+}
+
+
+bool FrameReadback::retrieve(int& frame, std::vector<unsigned char>& pixels, bool wait)
+{
+	if (isEmpty())
+		return false;
+
+	PendingFrame& pending = buffers[tail];
+	GLenum result = glClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		if (!wait)
+			return false;
+
+		double started = Profiler::now();
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		stalls++;
+		Profiler::addTime("Readback Stall", Profiler::now() - started);
+	}
+	glDeleteSync(pending.fence);
+	pending.fence = 0;
+
+	size_t size = (size_t)width * height * 4;
+	pixels.resize(size);
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, pending.buffer);
+	const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (mapped != NULL)
+	{
+		memcpy(&pixels[0], mapped, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	frame = pending.frame;
+	tail = (tail + 1) % buffers.size();
+	count--;
+	return mapped != NULL;
+}
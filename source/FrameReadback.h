@@ -0,0 +1,46 @@
+#ifndef FRAMEREADBACK_H_
+#define FRAMEREADBACK_H_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/*
+ * Reads Rendered Frames Back without Waiting for the GPU
+ * Each read copies the framebuffer into one of a ring of pixel pack buffers and places a fence.
+ * The pixels are only mapped once the fence has signalled, usually a couple of frames later,
+ * so glReadPixels never stalls the pipeline. Frames come out in the order they were read.
+ */
+class FrameReadback {
+public:
+	FrameReadback();
+	~FrameReadback();
+
+	bool init(int width, int height, int bufferCount = 3);		// Needs a current GL context
+
+	bool read(int frame);		// Starts copying the bound read framebuffer, false if every buffer is in use
+	bool retrieve(int& frame, std::vector<unsigned char>& pixels, bool wait);		// Oldest frame, RGBA bottom row first
+
+	bool isFull() const { return count == (int)buffers.size(); }
+	bool isEmpty() const { return count == 0; }
+	int getStalls() const { return stalls; }		// Retrieves that had to wait for the GPU
+
+private:
+	struct PendingFrame
+	{
+		GLuint buffer;
+		GLsync fence;
+		int frame;
+	};
+
+	std::vector<PendingFrame> buffers;
+	int head;		// Next buffer to read into
+	int tail;		// Oldest frame not yet retrieved
+	int count;
+
+	int width;
+	int height;
+	int stalls;
+};
+
+#endif
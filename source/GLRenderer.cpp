@@ -0,0 +1,305 @@
+#include "GLRenderer.h"
+#include "GLState.h"
+
+#include <string.h>
+
+
+GLRenderer::GLRenderer() : shaderProgramID(0), viewportWidth(1), viewportHeight(1), streamBuffer(NULL), instanceBuffer(0), lightmapProgramID(0), lightDataTexture(0), clusterDataTexture(0), lightIndicesTexture(0)
+{
+	lightDataSize[0] = lightDataSize[1] = 0;
+	clusterDataSize[0] = clusterDataSize[1] = 0;
+	lightIndicesSize[0] = lightIndicesSize[1] = 0;
+}
+
+
+GLRenderer::~GLRenderer()
+{
+}
+
+
+bool GLRenderer::init()
+{
+	// Create Shader
+	shaderProgramID = Shader::LoadFromFile("shaders/shader.vert", "shaders/shader.frag");
+	if (shaderProgramID == 0)
+		return false;
+
+	// Attribute Locations
+	vertexPositionAttribute = glGetAttribLocation(shaderProgramID, "aVertexPosition");
+	vertexNormalAttribute = glGetAttribLocation(shaderProgramID, "aVertexNormal");
+	vertexTexCoordAttribute = glGetAttribLocation(shaderProgramID, "aVertexTexCoord");
+	instanceAttribute = glGetAttribLocation(shaderProgramID, "aInstance");
+
+	// Uniform Locations
+	ModelViewMatrixUniformLocation = glGetUniformLocation(shaderProgramID, "ModelViewMatrix_uniform");
+	ProjectionMatrixUniformLocation = glGetUniformLocation(shaderProgramID, "ProjectionMatrix_uniform");
+	InstancedUniformLocation = glGetUniformLocation(shaderProgramID, "Instanced_uniform");
+	InstanceRotationUniformLocation = glGetUniformLocation(shaderProgramID, "InstanceRotation_uniform");
+
+	TextureMapUniformLocation = glGetUniformLocation(shaderProgramID, "TextureMap_uniform");
+
+	LightPositionUniformLocation = glGetUniformLocation(shaderProgramID, "LightPosition_uniform");
+
+	AmbientUniformLocation = glGetUniformLocation(shaderProgramID, "Ambient_uniform");
+	SpecularUniformLocation = glGetUniformLocation(shaderProgramID, "Specular_uniform");
+	SpecularPowerUniformLocation = glGetUniformLocation(shaderProgramID, "SpecularPower_uniform");
+
+	LightDataUniformLocation = glGetUniformLocation(shaderProgramID, "LightData_uniform");
+	ClusterDataUniformLocation = glGetUniformLocation(shaderProgramID, "ClusterData_uniform");
+	LightIndicesUniformLocation = glGetUniformLocation(shaderProgramID, "LightIndices_uniform");
+	ClusterScaleUniformLocation = glGetUniformLocation(shaderProgramID, "ClusterScale_uniform");
+	ClusterCountUniformLocation = glGetUniformLocation(shaderProgramID, "ClusterCount_uniform");
+	PointLightCountUniformLocation = glGetUniformLocation(shaderProgramID, "PointLightCount_uniform");
+
+	// Cluster Textures, Read with texelFetch
+	GLuint textures[3];
+	glGenTextures(3, textures);
+	lightDataTexture = textures[0];
+	clusterDataTexture = textures[1];
+	lightIndicesTexture = textures[2];
+	for (int i = 0; i < 3; i++)
+	{
+		GLState::bindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	GLState::useProgram(shaderProgramID);
+	GLState::uniform1i(PointLightCountUniformLocation, 0);
+	GLState::uniform1i(InstancedUniformLocation, 0);
+
+	return true;
+}
+
+
+bool GLRenderer::initLightmapped()
+{
+	lightmapProgramID = Shader::LoadFromFile("shaders/lightmap.vert", "shaders/lightmap.frag");
+	if (lightmapProgramID == 0)
+		return false;
+
+	lightmapPositionAttribute = glGetAttribLocation(lightmapProgramID, "aVertexPosition");
+	lightmapTexCoordAttribute = glGetAttribLocation(lightmapProgramID, "aVertexTexCoord");
+	lightmapAttribute = glGetAttribLocation(lightmapProgramID, "aLightmapTexCoord");
+
+	LightmapModelViewMatrixUniformLocation = glGetUniformLocation(lightmapProgramID, "ModelViewMatrix_uniform");
+	LightmapProjectionMatrixUniformLocation = glGetUniformLocation(lightmapProgramID, "ProjectionMatrix_uniform");
+	LightmapAmbientUniformLocation = glGetUniformLocation(lightmapProgramID, "Ambient_uniform");
+	LightmapTextureMapUniformLocation = glGetUniformLocation(lightmapProgramID, "TextureMap_uniform");
+	LightmapUniformLocation = glGetUniformLocation(lightmapProgramID, "Lightmap_uniform");
+
+	return true;
+}
+
+
+void GLRenderer::beginFrame(int width, int height, Vector3f clearColour)
+{
+	// Set Viewport
+	glViewport(0, 0, width, height);
+	viewportWidth = width;
+	viewportHeight = height;
+
+	// Set Background Colour and Clear the Screen
+	glClearColor(clearColour.x, clearColour.y, clearColour.z, 1.0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Use Shader
+	GLState::useProgram(shaderProgramID);
+}
+
+
+void GLRenderer::endFrame()
+{
+	// Buffers are swapped by GLUT
+}
+
+
+void GLRenderer::setProjection(Matrix4x4 projection)
+{
+	this->projection = projection;
+	GLState::uniformMatrix4fv(ProjectionMatrixUniformLocation, projection.getPtr());
+}
+
+
+void GLRenderer::setLight(Vector3f lightPosition)
+{
+	GLState::uniform3f(LightPositionUniformLocation, lightPosition.x, lightPosition.y, lightPosition.z);
+}
+
+
+void GLRenderer::setMaterial(const Material& material)
+{
+	GLState::uniform4f(AmbientUniformLocation, material.ambient[0], material.ambient[1], material.ambient[2], material.ambient[3]);
+	GLState::uniform4f(SpecularUniformLocation, material.specular[0], material.specular[1], material.specular[2], material.specular[3]);
+	GLState::uniform1f(SpecularPowerUniformLocation, material.specularPower);
+}
+
+
+void GLRenderer::setTexture(unsigned int texture)
+{
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
+	GLState::uniform1i(TextureMapUniformLocation, 0);
+}
+
+
+void GLRenderer::setPointLights(const ClusteredLighting& lighting)
+{
+	int clusters = lighting.getTilesX() * lighting.getTilesY();
+
+	GLState::activeTexture(GL_TEXTURE1);
+	uploadTexture(lightDataTexture, GL_RGBA32F, GL_RGBA, 2, (int)lighting.getLightData().size() / 8, &lighting.getLightData()[0], lightDataSize);
+	GLState::activeTexture(GL_TEXTURE2);
+	uploadTexture(clusterDataTexture, GL_RG32F, GL_RG, clusters, lighting.getSlices(), &lighting.getClusterData()[0], clusterDataSize);
+	GLState::activeTexture(GL_TEXTURE3);
+	uploadTexture(lightIndicesTexture, GL_R32F, GL_RED, ClusteredLighting::indexRowLength, (int)lighting.getLightIndices().size() / ClusteredLighting::indexRowLength, &lighting.getLightIndices()[0], lightIndicesSize);
+	GLState::activeTexture(GL_TEXTURE0);
+
+	GLState::uniform1i(LightDataUniformLocation, 1);
+	GLState::uniform1i(ClusterDataUniformLocation, 2);
+	GLState::uniform1i(LightIndicesUniformLocation, 3);
+	GLState::uniform4f(ClusterScaleUniformLocation,
+		(float)lighting.getTilesX() / viewportWidth,
+		(float)lighting.getTilesY() / viewportHeight,
+		lighting.getSliceScale(),
+		ClusteredLighting::clusterNear);
+	GLState::uniform3i(ClusterCountUniformLocation, lighting.getTilesX(), lighting.getTilesY(), lighting.getSlices());
+	GLState::uniform1i(PointLightCountUniformLocation, lighting.getLightCount());
+}
+
+
+void GLRenderer::uploadTexture(GLuint texture, GLenum internalFormat, GLenum format, int width, int height, const float* data, int size[2])
+{
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
+
+	// Grow the Texture when Needed, Otherwise Update in Place
+	if (width > size[0] || height > size[1])
+	{
+		size[0] = width > size[0] ? width : size[0];
+		size[1] = height > size[1] ? height : size[1];
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size[0], size[1], 0, format, GL_FLOAT, NULL);
+	}
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	// Copy through the Ring Buffer and Upload from there as a Pixel Buffer
+	int bytes = width * height * (format == GL_RGBA ? 4 : format == GL_RG ? 2 : 1) * sizeof(float);
+	StreamBuffer::Allocation allocation = { NULL, 0 };
+	if (streamBuffer != NULL)
+		allocation = streamBuffer->allocate(bytes);
+
+	if (allocation.pointer != NULL)
+	{
+		memcpy(allocation.pointer, data, bytes);
+		streamBuffer->flush();
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, streamBuffer->getBuffer());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_FLOAT, (void*)allocation.offset);
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_FLOAT, data);
+}
+
+
+void GLRenderer::drawMesh(Mesh& mesh, Matrix4x4 modelView)
+{
+	GLState::uniformMatrix4fv(ModelViewMatrixUniformLocation, modelView.getPtr());
+	mesh.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
+}
+
+
+void GLRenderer::drawMeshInstanced(Mesh& mesh, const std::vector<GLfloat>& instances)
+{
+	if (instances.empty())
+		return;
+
+	// Copy through the Ring Buffer, or Else into a Buffer of its Own
+	int bytes = (int)(instances.size() * sizeof(GLfloat));
+	StreamBuffer::Allocation allocation = { NULL, 0 };
+	if (streamBuffer != NULL)
+		allocation = streamBuffer->allocate(bytes);
+
+	if (allocation.pointer != NULL)
+	{
+		memcpy(allocation.pointer, &instances[0], bytes);
+		streamBuffer->flush();
+		GLState::bindBuffer(GL_ARRAY_BUFFER, streamBuffer->getBuffer());
+	}
+	else
+	{
+		if (instanceBuffer == 0)
+			glGenBuffers(1, &instanceBuffer);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &instances[0]);
+	}
+	GLState::vertexAttribPointer(instanceAttribute, 4, GL_FLOAT, GL_FALSE, 0, allocation.offset);
+	GLState::vertexAttribDivisor(instanceAttribute, 1);
+
+	mesh.drawInstanced((int)instances.size() / 4, instanceAttribute, vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
+
+	// Other Programs may Use the Same Attribute Index Unscaled
+	GLState::vertexAttribDivisor(instanceAttribute, 0);
+}
+
+
+void GLRenderer::setInstancing(bool enabled, Matrix4x4 view, float rotation)
+{
+	GLState::useProgram(shaderProgramID);
+	GLState::uniform1i(InstancedUniformLocation, enabled ? 1 : 0);
+	if (!enabled)
+		return;
+
+	GLState::uniformMatrix4fv(ModelViewMatrixUniformLocation, view.getPtr());
+	GLState::uniform1f(InstanceRotationUniformLocation, rotation);
+}
+
+
+void GLRenderer::setLightmapped(bool enabled, Matrix4x4 view, const Material& material, unsigned int texture, unsigned int lightmap)
+{
+	if (!enabled)
+	{
+		GLState::useProgram(shaderProgramID);
+		return;
+	}
+
+	GLState::useProgram(lightmapProgramID);
+	GLState::uniformMatrix4fv(LightmapProjectionMatrixUniformLocation, projection.getPtr());
+	GLState::uniformMatrix4fv(LightmapModelViewMatrixUniformLocation, view.getPtr());
+	GLState::uniform4f(LightmapAmbientUniformLocation, material.ambient[0], material.ambient[1], material.ambient[2], material.ambient[3]);
+
+	GLState::activeTexture(GL_TEXTURE4);
+	GLState::bindTexture(GL_TEXTURE_2D, lightmap);
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
+	GLState::uniform1i(LightmapTextureMapUniformLocation, 0);
+	GLState::uniform1i(LightmapUniformLocation, 4);
+}
+
+
+unsigned int GLRenderer::createTexture(int width, int height, const char* rgbData)
+{
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	GLState::bindTexture(GL_TEXTURE_2D, textureID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		0,
+		GL_RGB,
+		width,
+		height,
+		0,
+		GL_RGB,
+		GL_UNSIGNED_BYTE,
+		rgbData
+	);
+
+	return textureID;
+}
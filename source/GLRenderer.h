@@ -0,0 +1,102 @@
+#ifndef GLRENDERER_H_
+#define GLRENDERER_H_
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+
+#include "Renderer.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+
+/* Renderer Drawing through OpenGL with shader.vert and shader.frag */
+class GLRenderer : public Renderer {
+public:
+	GLRenderer();
+	~GLRenderer();
+
+	bool init();		// Loads the shader and looks up attribute and uniform locations
+	bool initLightmapped();		// Loads lightmap.vert and lightmap.frag, for walls with baked lighting
+
+	void beginFrame(int width, int height, Vector3f clearColour);
+	void endFrame();
+
+	void setProjection(Matrix4x4 projection);
+	void setLight(Vector3f lightPosition);
+	void setMaterial(const Material& material);
+	void setTexture(unsigned int texture);
+	void setPointLights(const ClusteredLighting& lighting);		// Uploads the cluster light lists for shader.frag
+
+	void drawMesh(Mesh& mesh, Matrix4x4 modelView);
+
+	// Instanced Drawing, with the View as the Model View Matrix and Placement per Instance
+	void setInstancing(bool enabled, Matrix4x4 view, float rotation = 0.0);		// rotation in radians about y
+	void drawMeshInstanced(Mesh& mesh, const std::vector<GLfloat>& instances);	// Position and scale per instance, with instancing enabled
+	GLuint getVertexPositionAttribute() const { return vertexPositionAttribute; }
+	GLuint getVertexNormalAttribute() const { return vertexNormalAttribute; }
+	GLuint getVertexTexCoordAttribute() const { return vertexTexCoordAttribute; }
+	GLuint getInstanceAttribute() const { return instanceAttribute; }
+
+	// Baked Lighting, Drawn with its Own Program until Disabled, Placed by the View Alone
+	void setLightmapped(bool enabled, Matrix4x4 view, const Material& material, unsigned int texture, unsigned int lightmap);
+	GLuint getLightmapPositionAttribute() const { return lightmapPositionAttribute; }
+	GLuint getLightmapTexCoordAttribute() const { return lightmapTexCoordAttribute; }
+	GLuint getLightmapAttribute() const { return lightmapAttribute; }
+
+	unsigned int createTexture(int width, int height, const char* rgbData);
+
+	void setStreamBuffer(StreamBuffer* streamBuffer) { this->streamBuffer = streamBuffer; }	// Point light data is uploaded through it when set
+
+private:
+	GLuint shaderProgramID;
+	int viewportWidth, viewportHeight;
+	Matrix4x4 projection;					// Also given to the lightmap program
+	StreamBuffer* streamBuffer;
+
+	GLuint vertexPositionAttribute;         // Vertex Position Attribute Location
+	GLuint vertexNormalAttribute;           // Vertex Normal Attribute Location
+	GLuint vertexTexCoordAttribute;         // Vertex Texture Coordinate Attribute Location
+	GLuint instanceAttribute;               // Instance Position and Scale Attribute Location
+	GLuint instanceBuffer;                  // Instances drawn without the stream buffer, orphaned every draw
+
+	GLuint TextureMapUniformLocation;       // Texture Map Uniform Location
+	GLuint ModelViewMatrixUniformLocation;  // Model View Matrix Uniform Location
+	GLuint ProjectionMatrixUniformLocation; // Projection Matrix Uniform Location
+	GLuint InstancedUniformLocation;
+	GLuint InstanceRotationUniformLocation;
+
+	// Lighting - Phong Reflection Model
+	GLuint LightPositionUniformLocation;
+	GLuint AmbientUniformLocation;
+	GLuint SpecularUniformLocation;
+	GLuint SpecularPowerUniformLocation;
+
+	// Clustered Point Lights
+	void uploadTexture(GLuint texture, GLenum internalFormat, GLenum format, int width, int height, const float* data, int size[2]);
+
+	GLuint LightDataUniformLocation;
+	GLuint ClusterDataUniformLocation;
+	GLuint LightIndicesUniformLocation;
+	GLuint ClusterScaleUniformLocation;
+	GLuint ClusterCountUniformLocation;
+	GLuint PointLightCountUniformLocation;
+
+	// Baked Lighting
+	GLuint lightmapProgramID;
+	GLuint lightmapPositionAttribute;
+	GLuint lightmapTexCoordAttribute;
+	GLuint lightmapAttribute;
+	GLuint LightmapModelViewMatrixUniformLocation;
+	GLuint LightmapProjectionMatrixUniformLocation;
+	GLuint LightmapAmbientUniformLocation;
+	GLuint LightmapTextureMapUniformLocation;
+	GLuint LightmapUniformLocation;
+
+	GLuint lightDataTexture;
+	GLuint clusterDataTexture;
+	GLuint lightIndicesTexture;
+	int lightDataSize[2];			// Allocated texture sizes, reallocated when the data grows
+	int clusterDataSize[2];
+	int lightIndicesSize[2];
+};
+
+#endif
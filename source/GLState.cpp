@@ -0,0 +1,289 @@
+#include "GLState.h"
+#include "Profiler.h"
+
+// Names that are Never Generated, Standing for Unknown State
+static const GLuint unknown = 0xFFFFFFFF;
+
+bool GLState::filtering = true;
+GLuint GLState::program = unknown;
+GLenum GLState::activeUnit = 0;
+GLuint GLState::textures[textureUnits];
+GLuint GLState::buffers[5];
+unsigned int GLState::attributesKnown = 0;
+unsigned int GLState::attributesEnabled = 0;
+GLState::AttributePointer GLState::pointers[vertexAttributes];
+GLuint GLState::divisors[vertexAttributes];
+std::unordered_map<GLenum, bool> GLState::capabilities;
+std::unordered_map<unsigned long long, GLState::UniformValue> GLState::uniforms;
+int GLState::issued = 0;
+int GLState::elided = 0;
+
+// Every Slot Starts Unknown
+static struct GLStateInitialiser
+{
+	GLStateInitialiser() { GLState::invalidate(); }
+} initialiser;
+
+
+bool GLState::changed(bool same)
+{
+	if (same && filtering)
+	{
+		elided++;
+		return false;
+	}
+	issued++;
+	return true;
+}
+
+
+void GLState::useProgram(GLuint program)
+{
+	if (changed(program == GLState::program))
+	{
+		glUseProgram(program);
+		GLState::program = program;
+	}
+}
+
+
+void GLState::activeTexture(GLenum unit)
+{
+	if (changed(unit == activeUnit))
+	{
+		glActiveTexture(unit);
+		activeUnit = unit;
+	}
+}
+
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	// Only 2D Textures on Known Units are Tracked
+	int unit = activeUnit - GL_TEXTURE0;
+	if (target != GL_TEXTURE_2D || activeUnit == 0 || unit >= textureUnits)
+	{
+		issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (changed(texture == textures[unit]))
+	{
+		glBindTexture(target, texture);
+		textures[unit] = texture;
+	}
+}
+
+
+int GLState::bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER: return 0;
+	case GL_ELEMENT_ARRAY_BUFFER: return 1;
+	case GL_PIXEL_PACK_BUFFER: return 2;
+	case GL_PIXEL_UNPACK_BUFFER: return 3;
+	case GL_UNIFORM_BUFFER: return 4;
+	default: return -1;
+	}
+}
+
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	int slot = bufferSlot(target);
+	if (slot < 0)
+	{
+		issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (changed(buffer == buffers[slot]))
+	{
+		glBindBuffer(target, buffer);
+		buffers[slot] = buffer;
+	}
+}
+
+
+void GLState::useVertexAttribArrays(unsigned int mask)
+{
+	for (int i = 0; i < vertexAttributes; i++)
+	{
+		if (mask & (1u << i))
+			enableVertexAttribArray(i);
+		else if ((attributesEnabled & (1u << i)) || !(attributesKnown & (1u << i)))
+			disableVertexAttribArray(i);
+	}
+}
+
+
+void GLState::enableVertexAttribArray(GLuint index)
+{
+	unsigned int bit = index < vertexAttributes ? 1u << index : 0;
+	if (changed(bit != 0 && (attributesKnown & bit) && (attributesEnabled & bit)))
+	{
+		glEnableVertexAttribArray(index);
+		attributesKnown |= bit;
+		attributesEnabled |= bit;
+	}
+}
+
+
+void GLState::disableVertexAttribArray(GLuint index)
+{
+	unsigned int bit = index < vertexAttributes ? 1u << index : 0;
+	if (changed(bit != 0 && (attributesKnown & bit) && !(attributesEnabled & bit)))
+	{
+		glDisableVertexAttribArray(index);
+		attributesKnown |= bit;
+		attributesEnabled &= ~bit;
+	}
+}
+
+
+void GLState::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, GLintptr offset)
+{
+	AttributePointer pointer = { buffers[0], size, type, normalized, stride, offset };
+	bool same = index < vertexAttributes && buffers[0] != unknown && memcmp(&pointer, &pointers[index], sizeof(pointer)) == 0;
+	if (changed(same))
+	{
+		glVertexAttribPointer(index, size, type, normalized, stride, (void*)offset);
+		if (index < vertexAttributes)
+			pointers[index] = pointer;
+	}
+}
+
+
+void GLState::vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	if (changed(index < vertexAttributes && divisors[index] == divisor))
+	{
+		glVertexAttribDivisor(index, divisor);
+		if (index < vertexAttributes)
+			divisors[index] = divisor;
+	}
+}
+
+
+void GLState::enable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::iterator it = capabilities.find(capability);
+	if (changed(it != capabilities.end() && it->second))
+	{
+		glEnable(capability);
+		capabilities[capability] = true;
+	}
+}
+
+
+void GLState::disable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::iterator it = capabilities.find(capability);
+	if (changed(it != capabilities.end() && !it->second))
+	{
+		glDisable(capability);
+		capabilities[capability] = false;
+	}
+}
+
+
+bool GLState::changedUniform(GLint location, int type, const void* data, int size)
+{
+	// Location -1 is Ignored by GL, so Nothing to Issue
+	if (location == -1)
+		return false;
+
+	if (program == unknown)
+		return changed(false);
+
+	UniformValue& value = uniforms[((unsigned long long)program << 32) | (unsigned int)location];
+	bool same = value.type == type && memcmp(value.data, data, size) == 0;
+	if (!changed(same))
+		return false;
+
+	value.type = type;
+	memcpy(value.data, data, size);
+	return true;
+}
+
+
+void GLState::uniform1i(GLint location, GLint x)
+{
+	if (changedUniform(location, 1, &x, sizeof(x)))
+		glUniform1i(location, x);
+}
+
+
+void GLState::uniform3i(GLint location, GLint x, GLint y, GLint z)
+{
+	GLint value[3] = { x, y, z };
+	if (changedUniform(location, 2, value, sizeof(value)))
+		glUniform3i(location, x, y, z);
+}
+
+
+void GLState::uniform1f(GLint location, GLfloat x)
+{
+	if (changedUniform(location, 3, &x, sizeof(x)))
+		glUniform1f(location, x);
+}
+
+
+void GLState::uniform2f(GLint location, GLfloat x, GLfloat y)
+{
+	GLfloat value[2] = { x, y };
+	if (changedUniform(location, 7, value, sizeof(value)))
+		glUniform2f(location, x, y);
+}
+
+
+void GLState::uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+	GLfloat value[3] = { x, y, z };
+	if (changedUniform(location, 4, value, sizeof(value)))
+		glUniform3f(location, x, y, z);
+}
+
+
+void GLState::uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+	GLfloat value[4] = { x, y, z, w };
+	if (changedUniform(location, 5, value, sizeof(value)))
+		glUniform4f(location, x, y, z, w);
+}
+
+
+void GLState::uniformMatrix4fv(GLint location, const GLfloat* matrix)
+{
+	if (changedUniform(location, 6, matrix, 16 * sizeof(GLfloat)))
+		glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
+}
+
+
+void GLState::invalidate()
+{
+	program = unknown;
+	activeUnit = 0;
+	for (int i = 0; i < textureUnits; i++)
+		textures[i] = unknown;
+	for (int i = 0; i < 5; i++)
+		buffers[i] = unknown;
+	attributesKnown = 0;
+	attributesEnabled = 0;
+	memset(pointers, 0xFF, sizeof(pointers));
+	memset(divisors, 0xFF, sizeof(divisors));
+	capabilities.clear();
+	uniforms.clear();
+}
+
+
+void GLState::endFrame()
+{
+	Profiler::addCounter("GL Calls Issued", issued);
+	Profiler::addCounter("GL Calls Elided", elided);
+	issued = 0;
+	elided = 0;
+}
@@ -0,0 +1,91 @@
+#ifndef GLSTATE_H_
+#define GLSTATE_H_
+
+#include <GL/glew.h>
+
+#include <string.h>
+#include <unordered_map>
+
+/*
+ * Shadow of the OpenGL State the Game Sets, Skipping Calls that would Change Nothing
+ * Tracks the bound program, the 2D texture on each unit, buffer bindings, enabled vertex
+ * attributes and their pointers, a few capabilities and the last value written to each uniform
+ * of each program. Issued and elided calls are counted and passed to the Profiler every frame.
+ * Code that changes this state with GL directly, or deletes a bound object, must call
+ * invalidate() afterwards so the next call of each kind is issued again.
+ */
+class GLState {
+public:
+	static void useProgram(GLuint program);
+	static void activeTexture(GLenum unit);
+	static void bindTexture(GLenum target, GLuint texture);		// On the active unit
+	static void bindBuffer(GLenum target, GLuint buffer);
+
+	// Vertex Attributes
+	static void useVertexAttribArrays(unsigned int mask);		// Enables the attributes in the mask, disables the rest
+	static void enableVertexAttribArray(GLuint index);
+	static void disableVertexAttribArray(GLuint index);
+	static void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, GLintptr offset);	// Into the bound GL_ARRAY_BUFFER
+	static void vertexAttribDivisor(GLuint index, GLuint divisor);
+
+	static void enable(GLenum capability);
+	static void disable(GLenum capability);
+
+	// Uniforms of the Program in Use
+	static void uniform1i(GLint location, GLint x);
+	static void uniform3i(GLint location, GLint x, GLint y, GLint z);
+	static void uniform1f(GLint location, GLfloat x);
+	static void uniform2f(GLint location, GLfloat x, GLfloat y);
+	static void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+	static void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+	static void uniformMatrix4fv(GLint location, const GLfloat* matrix);
+
+	static void invalidate();		// Forgets everything, for code that used GL directly
+	static void endFrame();			// Reports this frame's issued and elided calls
+
+	static void setFiltering(bool enabled) { filtering = enabled; }		// false issues every call, for comparison
+
+	static const int textureUnits = 16;
+	static const int vertexAttributes = 16;
+
+private:
+	static bool changed(bool same);		// Counts the call, true if it must be issued
+	static bool changedUniform(GLint location, int type, const void* data, int size);
+	static int bufferSlot(GLenum target);
+
+	// Attribute Pointer as Last Set
+	struct AttributePointer
+	{
+		GLuint buffer;
+		GLint size;
+		GLenum type;
+		GLboolean normalized;
+		GLsizei stride;
+		GLintptr offset;
+	};
+
+	// Uniform Value as Last Written, Compared Byte for Byte
+	struct UniformValue
+	{
+		int type;
+		unsigned char data[16 * sizeof(GLfloat)];
+	};
+
+	static bool filtering;
+
+	static GLuint program;
+	static GLenum activeUnit;
+	static GLuint textures[textureUnits];
+	static GLuint buffers[5];
+	static unsigned int attributesKnown;		// Bit per attribute whose enabled state is known
+	static unsigned int attributesEnabled;
+	static AttributePointer pointers[vertexAttributes];
+	static GLuint divisors[vertexAttributes];
+	static std::unordered_map<GLenum, bool> capabilities;
+	static std::unordered_map<unsigned long long, UniformValue> uniforms;	// Keyed by program and location
+
+	static int issued;
+	static int elided;
+};
+
+#endif
@@ -0,0 +1,387 @@
+#include "GpuCulling.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <string.h>
+
+
+GpuCulling::GpuCulling()
+	: useCompute(false), shaderProgramID(0), geometryUploaded(false),
+	vertexBuffer(0), indexBuffer(0), instanceBuffer(0), chunkBuffer(0), commandBuffer(0), countBuffer(0), visibleBuffer(0)
+{
+}
+
+
+GpuCulling::~GpuCulling()
+{
+	// GL objects belong to the context, which is gone by the time globals are destroyed
+}
+
+
+bool GpuCulling::isSupported()
+{
+	return (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+}
+
+
+bool GpuCulling::isComputeSupported()
+{
+	return GLEW_VERSION_4_3 || (GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object);
+}
+
+
+bool GpuCulling::init(bool useCompute)
+{
+	this->useCompute = useCompute;
+	if (useCompute)
+	{
+		shaderProgramID = Shader::LoadComputeFromFile("shaders/cull.comp");
+		if (shaderProgramID == 0)
+			return false;
+
+		PassUniformLocation = glGetUniformLocation(shaderProgramID, "Pass_uniform");
+		CountUniformLocation = glGetUniformLocation(shaderProgramID, "Count_uniform");
+		ViewProjectionUniformLocation = glGetUniformLocation(shaderProgramID, "ViewProjection_uniform");
+		MeshMinUniformLocation = glGetUniformLocation(shaderProgramID, "MeshMin_uniform");
+		MeshMaxUniformLocation = glGetUniformLocation(shaderProgramID, "MeshMax_uniform");
+		MeshIndicesUniformLocation = glGetUniformLocation(shaderProgramID, "MeshIndices_uniform");
+	}
+
+	GLuint buffers[7];
+	glGenBuffers(7, buffers);
+	vertexBuffer = buffers[0];
+	indexBuffer = buffers[1];
+	instanceBuffer = buffers[2];
+	chunkBuffer = buffers[3];
+	commandBuffer = buffers[4];
+	countBuffer = buffers[5];
+	visibleBuffer = buffers[6];
+	return true;
+}
+
+
+int GpuCulling::addMesh(const Mesh& mesh)
+{
+	if (meshes.size() == maxMeshes)
+		return -1;
+
+	const std::vector<GLfloat>& positions = mesh.getPositionData();
+	const std::vector<GLfloat>& normals = mesh.getNormalData();
+	const std::vector<GLfloat>& texcoords = mesh.getTexcoordData();
+
+	MeshRange range;
+	range.firstIndex = (int)indices.size();
+	range.baseVertex = (int)vertices.size() / 8;
+	range.firstCommand = 0;
+	range.chunkCount = 0;
+
+	// Share Identical Face Vertices, Indexed from the Mesh's Base Vertex
+	float radius = 0.0;
+	float minY = 0.0, maxY = 0.0;
+	std::map<std::vector<GLfloat>, GLuint> unique;
+	for (int i = 0; i < mesh.getVertexCount(); i++)
+	{
+		std::vector<GLfloat> vertex(8, 0.0);
+		for (int j = 0; j < 3; j++)
+		{
+			vertex[j] = positions[i * 3 + j];
+			if (i * 3 + j < normals.size())
+				vertex[3 + j] = normals[i * 3 + j];
+		}
+		for (int j = 0; j < 2; j++)
+			if (i * 2 + j < texcoords.size())
+				vertex[6 + j] = texcoords[i * 2 + j];
+
+		std::map<std::vector<GLfloat>, GLuint>::iterator it = unique.find(vertex);
+		if (it == unique.end())
+		{
+			it = unique.insert(std::make_pair(vertex, (GLuint)unique.size())).first;
+			vertices.insert(vertices.end(), vertex.begin(), vertex.end());
+		}
+		indices.push_back(it->second);
+
+		// Bounds that Hold under Any Rotation about y
+		radius = std::max(radius, sqrtf(vertex[0] * vertex[0] + vertex[2] * vertex[2]));
+		minY = i == 0 ? vertex[1] : std::min(minY, vertex[1]);
+		maxY = i == 0 ? vertex[1] : std::max(maxY, vertex[1]);
+	}
+	range.indexCount = (int)indices.size() - range.firstIndex;
+
+	float minimum[4] = { -radius, minY, -radius, 0.0 };
+	float maximum[4] = { radius, maxY, radius, 0.0 };
+	memcpy(range.minimum, minimum, sizeof(minimum));
+	memcpy(range.maximum, maximum, sizeof(maximum));
+
+	meshes.push_back(range);
+	geometryUploaded = false;
+	return (int)meshes.size() - 1;
+}
+
+
+void GpuCulling::clearInstances()
+{
+	instances.clear();
+	chunks.clear();
+}
+
+
+int GpuCulling::addChunk(int mesh)
+{
+	Chunk chunk;
+	for (int i = 0; i < 4; i++)
+	{
+		chunk.minimum[i] = 1e30f;
+		chunk.maximum[i] = -1e30f;
+	}
+	chunk.info[0] = mesh;
+	chunk.info[1] = (int)instances.size();
+	chunk.info[2] = 0;
+	chunk.info[3] = 0;
+	chunks.push_back(chunk);
+	return (int)chunks.size() - 1;
+}
+
+
+/* Adds an instance to a chunk - each chunk's instances are added together, straight after it */
+void GpuCulling::addInstance(int chunkIndex, Vector3f position, float scale)
+{
+	Chunk& chunk = chunks[chunkIndex];
+	const MeshRange& mesh = meshes[chunk.info[0]];
+
+	Instance instance;
+	instance.positionScale[0] = position.x;
+	instance.positionScale[1] = position.y;
+	instance.positionScale[2] = position.z;
+	instance.positionScale[3] = scale;
+	instance.chunk[0] = chunkIndex;
+	instance.chunk[1] = instance.chunk[2] = instance.chunk[3] = 0;
+	instances.push_back(instance);
+	chunk.info[2]++;
+
+	// Grow the Chunk's Bounds to Hold the Instance
+	for (int i = 0; i < 3; i++)
+	{
+		chunk.minimum[i] = std::min(chunk.minimum[i], instance.positionScale[i] + mesh.minimum[i] * scale);
+		chunk.maximum[i] = std::max(chunk.maximum[i], instance.positionScale[i] + mesh.maximum[i] * scale);
+	}
+}
+
+
+void GpuCulling::uploadInstances()
+{
+	if (!geometryUploaded && !vertices.empty())
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+		geometryUploaded = true;
+	}
+
+	// Each Mesh's Commands are Contiguous, One per Chunk at Most
+	for (int m = 0; m < meshes.size(); m++)
+		meshes[m].chunkCount = 0;
+	for (int c = 0; c < chunks.size(); c++)
+		meshes[chunks[c].info[0]].chunkCount++;
+	int firstCommand = 0;
+	for (int m = 0; m < meshes.size(); m++)
+	{
+		meshes[m].firstCommand = firstCommand;
+		firstCommand += meshes[m].chunkCount;
+	}
+	for (int c = 0; c < chunks.size(); c++)
+		chunks[c].info[3] = meshes[chunks[c].info[0]].firstCommand;
+
+	commands.assign(chunks.size(), DrawElementsIndirectCommand());
+	visible.assign(instances.size() * 4, 0.0);
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	glBufferData(GL_ARRAY_BUFFER, std::max((size_t)1, instances.size()) * 4 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, std::max((size_t)1, chunks.size()) * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_DRAW);
+
+	if (!useCompute)
+		return;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max((size_t)1, instances.size()) * sizeof(Instance), instances.empty() ? NULL : &instances[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, chunkBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max((size_t)1, chunks.size()) * sizeof(Chunk), chunks.empty() ? NULL : &chunks[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (maxMeshes + chunks.size()) * sizeof(GLint), NULL, GL_DYNAMIC_DRAW);
+
+	// Mesh Ranges and Bounds Only Change with the Instances
+	GLfloat minimum[maxMeshes * 4], maximum[maxMeshes * 4];
+	GLint ranges[maxMeshes * 4];
+	memset(minimum, 0, sizeof(minimum));
+	memset(maximum, 0, sizeof(maximum));
+	memset(ranges, 0, sizeof(ranges));
+	for (int m = 0; m < meshes.size(); m++)
+	{
+		memcpy(&minimum[m * 4], meshes[m].minimum, sizeof(meshes[m].minimum));
+		memcpy(&maximum[m * 4], meshes[m].maximum, sizeof(meshes[m].maximum));
+		ranges[m * 4 + 0] = meshes[m].indexCount;
+		ranges[m * 4 + 1] = meshes[m].firstIndex;
+		ranges[m * 4 + 2] = meshes[m].baseVertex;
+	}
+	GLState::useProgram(shaderProgramID);
+	glUniform4fv(MeshMinUniformLocation, maxMeshes, minimum);
+	glUniform4fv(MeshMaxUniformLocation, maxMeshes, maximum);
+	glUniform4iv(MeshIndicesUniformLocation, maxMeshes, ranges);
+}
+
+
+void GpuCulling::cull(Matrix4x4 viewProjection)
+{
+	if (chunks.empty())
+		return;
+
+	if (!useCompute)
+	{
+		cullOnCpu(viewProjection);
+		return;
+	}
+
+	// Empty Commands Draw Nothing, so Chunks Culled this Frame Leave No Gaps to Fill
+	GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+	glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, maxMeshes * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, chunkBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, countBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, visibleBuffer);
+
+	GLState::useProgram(shaderProgramID);
+	GLState::uniformMatrix4fv(ViewProjectionUniformLocation, viewProjection.getPtr());
+
+	// Chunks, then the Instances of Those Visible
+	GLState::uniform1i(PassUniformLocation, 0);
+	GLState::uniform1i(CountUniformLocation, (int)chunks.size());
+	glDispatchCompute((GLuint)(chunks.size() + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	GLState::uniform1i(PassUniformLocation, 1);
+	GLState::uniform1i(CountUniformLocation, (int)instances.size());
+	glDispatchCompute((GLuint)(instances.size() + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+
+void GpuCulling::cullOnCpu(Matrix4x4& viewProjection)
+{
+	const float* m = viewProjection.getPtr();
+	int drawCounts[maxMeshes] = { 0, 0, 0, 0 };
+	int drawn = 0;
+
+	memset(&commands[0], 0, commands.size() * sizeof(DrawElementsIndirectCommand));
+	for (int c = 0; c < chunks.size(); c++)
+	{
+		const Chunk& chunk = chunks[c];
+		if (!isVisible(m, chunk.minimum, chunk.maximum))
+			continue;
+
+		const MeshRange& mesh = meshes[chunk.info[0]];
+		DrawElementsIndirectCommand& command = commands[chunk.info[3] + drawCounts[chunk.info[0]]++];
+		command.count = mesh.indexCount;
+		command.firstIndex = mesh.firstIndex;
+		command.baseVertex = mesh.baseVertex;
+		command.baseInstance = chunk.info[1];
+
+		for (int i = chunk.info[1]; i < chunk.info[1] + chunk.info[2]; i++)
+		{
+			const float* p = instances[i].positionScale;
+			float minimum[3], maximum[3];
+			for (int j = 0; j < 3; j++)
+			{
+				minimum[j] = p[j] + mesh.minimum[j] * p[3];
+				maximum[j] = p[j] + mesh.maximum[j] * p[3];
+			}
+			if (!isVisible(m, minimum, maximum))
+				continue;
+
+			memcpy(&visible[(chunk.info[1] + command.instanceCount) * 4], p, 4 * sizeof(float));
+			command.instanceCount++;
+		}
+		drawn += command.instanceCount;
+	}
+	Profiler::addCounter("Indirect Instances Drawn", drawn);
+	if (visible.empty())
+		return;
+
+	// Orphaned so the Upload Never Waits on Last Frame's Draws
+	GLState::bindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	glBufferData(GL_ARRAY_BUFFER, visible.size() * sizeof(GLfloat), &visible[0], GL_STREAM_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), &commands[0], GL_DYNAMIC_DRAW);
+}
+
+
+void GpuCulling::draw(int mesh, GLuint positionAttribute, GLuint normalAttribute, GLuint texCoordAttribute, GLuint instanceAttribute)
+{
+	if (mesh < 0 || meshes[mesh].chunkCount == 0)
+		return;
+
+	unsigned int attributes = (1u << positionAttribute) | (1u << instanceAttribute);
+	if (normalAttribute != -1)
+		attributes |= 1u << normalAttribute;
+	if (texCoordAttribute != -1)
+		attributes |= 1u << texCoordAttribute;
+	GLState::useVertexAttribArrays(attributes);
+
+	GLsizei stride = 8 * sizeof(GLfloat);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLState::vertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, stride, 0);
+	if (normalAttribute != -1)
+		GLState::vertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, stride, 3 * sizeof(GLfloat));
+	if (texCoordAttribute != -1)
+		GLState::vertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, stride, 6 * sizeof(GLfloat));
+
+	// Base Instance Offsets the Instance Attribute to Each Chunk's Visible Instances
+	GLState::bindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	GLState::vertexAttribPointer(instanceAttribute, 4, GL_FLOAT, GL_FALSE, 0, 0);
+	GLState::vertexAttribDivisor(instanceAttribute, 1);
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(void*)(meshes[mesh].firstCommand * sizeof(DrawElementsIndirectCommand)), meshes[mesh].chunkCount, 0);
+
+	// Other Programs may Use the Same Attribute Index Unscaled
+	GLState::vertexAttribDivisor(instanceAttribute, 0);
+}
+
+
+/* True unless all corners are beyond the same clip plane, as in the compute shader */
+bool GpuCulling::isVisible(const float* m, const float* minimum, const float* maximum)
+{
+	int outside[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 8; i++)
+	{
+		float x = (i & 1) ? maximum[0] : minimum[0];
+		float y = (i & 2) ? maximum[1] : minimum[1];
+		float z = (i & 4) ? maximum[2] : minimum[2];
+
+		float cx = m[0] * x + m[4] * y + m[8] * z + m[12];
+		float cy = m[1] * x + m[5] * y + m[9] * z + m[13];
+		float cz = m[2] * x + m[6] * y + m[10] * z + m[14];
+		float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+		if (cx > cw) outside[0]++;
+		if (cx < -cw) outside[1]++;
+		if (cy > cw) outside[2]++;
+		if (cy < -cw) outside[3]++;
+		if (cz > cw) outside[4]++;
+		if (cz < -cw) outside[5]++;
+	}
+	for (int plane = 0; plane < 6; plane++)
+		if (outside[plane] == 8)
+			return false;
+	return true;
+}
@@ -0,0 +1,117 @@
+#ifndef GPUCULLING_H_
+#define GPUCULLING_H_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+
+/*
+ * Frustum Culling and Submission of Many Instances in a Few Draws
+ * Meshes are packed into one indexed vertex buffer and instances are grouped into chunks. A
+ * compute pass tests each chunk's bounds, giving every visible chunk one DrawElementsIndirect
+ * command, then tests each instance of a visible chunk and packs the survivors behind the
+ * chunk's first instance. Each mesh then goes out with a single glMultiDrawElementsIndirect, so
+ * the CPU does the same work however many instances there are. Without compute shaders the
+ * same commands are built on the CPU and uploaded, which costs time in the instance count.
+ */
+class GpuCulling {
+public:
+	GpuCulling();
+	~GpuCulling();
+
+	static bool isSupported();			// Multi draw indirect with base instance
+	static bool isComputeSupported();
+
+	bool init(bool useCompute);			// Loads the compute shader when used - needs a current GL context
+	bool isUsingCompute() const { return useCompute; }
+
+	// Geometry, Added before the First Instance
+	int addMesh(const Mesh& mesh);		// Returns the mesh's index, at most maxMeshes
+
+	// Instances, Rebuilt Whenever they Change
+	void clearInstances();
+	int addChunk(int mesh);
+	void addInstance(int chunk, Vector3f position, float scale);
+	void uploadInstances();
+
+	void cull(Matrix4x4 viewProjection);		// Builds this frame's draw commands
+	void draw(int mesh, GLuint positionAttribute, GLuint normalAttribute, GLuint texCoordAttribute, GLuint instanceAttribute);
+
+	static const int maxMeshes = 4;
+
+private:
+	// Instance as Stored for the Compute Shader
+	struct Instance
+	{
+		float positionScale[4];
+		int chunk[4];
+	};
+
+	// Chunk as Stored for the Compute Shader
+	struct Chunk
+	{
+		float minimum[4];
+		float maximum[4];
+		int info[4];		// Mesh, first instance, instance count, first command
+	};
+
+	// Laid Out as GL Expects
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// Packed Mesh
+	struct MeshRange
+	{
+		int indexCount;
+		int firstIndex;
+		int baseVertex;
+		float minimum[4];	// Bounds under any rotation about y
+		float maximum[4];
+		int firstCommand;
+		int chunkCount;
+	};
+
+	static bool isVisible(const float* viewProjection, const float* minimum, const float* maximum);
+	void cullOnCpu(Matrix4x4& viewProjection);
+
+	bool useCompute;
+	GLuint shaderProgramID;
+	GLint PassUniformLocation;
+	GLint CountUniformLocation;
+	GLint ViewProjectionUniformLocation;
+	GLint MeshMinUniformLocation;
+	GLint MeshMaxUniformLocation;
+	GLint MeshIndicesUniformLocation;
+
+	std::vector<GLfloat> vertices;		// Position, normal and texture coordinates, interleaved
+	std::vector<GLuint> indices;
+	std::vector<MeshRange> meshes;
+	bool geometryUploaded;
+
+	std::vector<Instance> instances;
+	std::vector<Chunk> chunks;
+
+	// CPU Culling Results
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<GLfloat> visible;
+
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GLuint instanceBuffer;
+	GLuint chunkBuffer;
+	GLuint commandBuffer;
+	GLuint countBuffer;				// Draw count per mesh, then the command of each chunk
+	GLuint visibleBuffer;
+};
+
+#endif
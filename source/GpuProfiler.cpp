@@ -0,0 +1,117 @@
+#include "GpuProfiler.h"
+#include "Profiler.h"
+
+std::map<std::string, GpuProfiler::Section> GpuProfiler::sections;
+bool GpuProfiler::enabled = false;
+int GpuProfiler::frame = 0;
+
+
+bool GpuProfiler::init()
+{
+	// Timer Queries are Core since OpenGL 3.3
+	GLint bits = 0;
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+
+	enabled = bits > 0;
+	return enabled;
+}
+
+
+void GpuProfiler::release()
+{
+	for (std::map<std::string, Section>::iterator it = sections.begin(); it != sections.end(); ++it)
+		glDeleteQueries(latency * 2, &it->second.queries[0][0]);
+	sections.clear();
+	enabled = false;
+}
+
+
+void GpuProfiler::beginFrame()
+{
+	beginSection("Frame");
+}
+
+
+void GpuProfiler::endFrame()
+{
+	if (!enabled)
+		return;
+
+	endSection("Frame");
+
+	for (std::map<std::string, Section>::iterator it = sections.begin(); it != sections.end(); ++it)
+		collect(it->first, it->second);
+
+	frame++;
+}
+
+
+void GpuProfiler::beginSection(const std::string& name)
+{
+	if (!enabled)
+		return;
+
+	std::map<std::string, Section>::iterator it = sections.find(name);
+	if (it == sections.end())
+	{
+		Section section;
+		glGenQueries(latency * 2, &section.queries[0][0]);
+		for (int i = 0; i < latency; i++)
+			section.frame[i] = -1;
+		section.running = false;
+		it = sections.insert(std::make_pair(name, section)).first;
+	}
+
+	// Pair Still Waiting on the GPU, Skip this Frame Rather than Stall
+	Section& section = it->second;
+	int slot = frame % latency;
+	if (section.frame[slot] != -1)
+	{
+		if (section.frame[slot] != frame)
+			Profiler::addCounter("GPU Timings Dropped", 1);
+		return;
+	}
+
+	glQueryCounter(section.queries[slot][0], GL_TIMESTAMP);
+	section.frame[slot] = frame;
+	section.running = true;
+}
+
+
+void GpuProfiler::endSection(const std::string& name)
+{
+	if (!enabled)
+		return;
+
+	std::map<std::string, Section>::iterator it = sections.find(name);
+	if (it == sections.end() || !it->second.running)
+		return;
+
+	Section& section = it->second;
+	glQueryCounter(section.queries[frame % latency][1], GL_TIMESTAMP);
+	section.running = false;
+}
+
+// Reads Every Pair of the Section that the GPU has Finished, Without Waiting
+void GpuProfiler::collect(const std::string& name, Section& section)
+{
+	for (int i = 1; i <= latency; i++)
+	{
+		// Oldest First, as Later Queries Cannot Finish Before Earlier Ones
+		int slot = (frame + i) % latency;
+		if (section.frame[slot] == -1 || section.running)
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(section.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 started = 0, finished = 0;
+		glGetQueryObjectui64v(section.queries[slot][0], GL_QUERY_RESULT, &started);
+		glGetQueryObjectui64v(section.queries[slot][1], GL_QUERY_RESULT, &finished);
+		Profiler::addTime("GPU " + name, (finished - started) / 1000000.0);
+		section.frame[slot] = -1;
+	}
+}
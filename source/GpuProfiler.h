@@ -0,0 +1,58 @@
+#ifndef GPUPROFILER_H_
+#define GPUPROFILER_H_
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+
+/*
+ * Per Frame GPU Timings from Timer Queries, Merged into the Profiler's Stats
+ * Each section records a GL_TIMESTAMP before and after its commands, so sections can nest, and
+ * owns a ring of query pairs so the results are read several frames later once the GPU has
+ * caught up instead of stalling for them. A section whose oldest pair has still not finished
+ * when it comes round again skips that frame and counts as dropped. Times are reported through
+ * Profiler::addTime with a "GPU " prefix, in the frame in which they become available.
+ */
+class GpuProfiler {
+public:
+	static bool init();			// Needs a current GL context with timer queries, otherwise every call does nothing
+	static void release();
+
+	static void beginFrame();	// Starts the "Frame" section
+	static void endFrame();		// Ends it and collects every result that is ready
+
+	static void beginSection(const std::string& name);
+	static void endSection(const std::string& name);
+
+	static bool isEnabled() { return enabled; }
+
+	static const int latency = 4;		// Frames a result may take before its queries are needed again
+
+private:
+	// Query Pairs for One Section
+	struct Section
+	{
+		GLuint queries[latency][2];		// Timestamps at the start and end of the section
+		int frame[latency];				// Frame the pair was issued in, -1 while free
+		bool running;
+	};
+
+	static void collect(const std::string& name, Section& section);
+
+	static std::map<std::string, Section> sections;
+	static bool enabled;
+	static int frame;
+};
+
+/* Times a Section on the GPU for the Lifetime of the Scope */
+class GpuProfileScope {
+public:
+	GpuProfileScope(const std::string& name) : name(name) { GpuProfiler::beginSection(name); };
+	~GpuProfileScope() { GpuProfiler::endSection(name); };
+
+private:
+	std::string name;
+};
+
+#endif
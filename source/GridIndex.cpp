@@ -0,0 +1,63 @@
+#include "GridIndex.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+const float GridIndex::cellSize = 30.0;
+
+
+GridIndex::GridIndex()
+	: map(NULL), width(0), depth(0)
+{
+}
+
+
+void GridIndex::build(const LevelGrid& map)
+{
+	this->map = &map;
+	width = map.getWidth();
+	depth = map.getDepth();
+}
+
+
+bool GridIndex::cellUnder(Vector3f position, int& x, int& z) const
+{
+	float half = cellSize * 0.5f;
+	if (!(position.x > -half && position.x < width * cellSize - half && position.z > -half && position.z < depth * cellSize - half))
+		return false;
+
+	// The Nearest Cell, and its Neighbours in Case Rounding Put the Position a Cell Out
+	int nearX = (int)floorf((position.x + half) / cellSize);
+	int nearZ = (int)floorf((position.z + half) / cellSize);
+	for (int cellZ = std::max(nearZ - 1, 0); cellZ <= std::min(nearZ + 1, depth - 1); cellZ++)
+	{
+		for (int cellX = std::max(nearX - 1, 0); cellX <= std::min(nearX + 1, width - 1); cellX++)
+		{
+			if (map->isWall(cellX, cellZ) &&
+				position.x > cellX * cellSize - half && position.x < cellX * cellSize + half &&
+				position.z > cellZ * cellSize - half && position.z < cellZ * cellSize + half)
+			{
+				x = cellX;
+				z = cellZ;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+void GridIndex::cellsNear(Vector3f min, Vector3f max, std::vector<int>& cells) const
+{
+	if (!(min.x <= max.x && min.z <= max.z) || max.x < -cellSize || max.z < -cellSize || min.x > width * cellSize || min.z > depth * cellSize)
+		return;
+
+	int firstX = std::max((int)floorf(std::max(min.x, -cellSize) / cellSize) - 1, 0);
+	int firstZ = std::max((int)floorf(std::max(min.z, -cellSize) / cellSize) - 1, 0);
+	int lastX = std::min((int)ceilf(std::min(max.x, width * cellSize) / cellSize) + 1, width - 1);
+	int lastZ = std::min((int)ceilf(std::min(max.z, depth * cellSize) / cellSize) + 1, depth - 1);
+	for (int z = firstZ; z <= lastZ; z++)
+		for (int x = firstX; x <= lastX; x++)
+			cells.push_back(z * width + x);
+}
@@ -0,0 +1,41 @@
+#ifndef GRIDINDEX_H_
+#define GRIDINDEX_H_
+
+#include <vector>
+
+#include "LevelGrid.h"
+#include "Vector.h"
+
+/*
+ * Constant Time Lookups of the Map's Cells by World Position
+ * Cell (x, z) is centred on (x, z) times the cell size, so a position maps straight to the one
+ * cell it is over and a box to the few cells it spreads over, instead of every cell being
+ * compared each update. The index reads the map it was built for in place, and only needs
+ * building again when a map of another size is loaded.
+ */
+class GridIndex {
+public:
+	GridIndex();
+	~GridIndex(){};
+
+	void build(const LevelGrid& map);		// The map is read in place, so must outlive the index
+
+	int getCell(int x, int z) const { return map->get(x, z); }	// 0 outside the map
+	bool cellUnder(Vector3f position, int& x, int& z) const;	// Wall cell whose square strictly holds the position
+	bool hasWalls() const { return map->getFirstWall() >= 0; }
+	bool hasWallBefore(int x, int z) const { return map->getFirstWall() >= 0 && map->getFirstWall() < z * width + x; }	// In row order, as loaded
+
+	// Appends z * width + x for Every Cell whose Centre is in the Box in x and z, with a Cell Spare on Each Side for Rounding
+	void cellsNear(Vector3f min, Vector3f max, std::vector<int>& cells) const;
+
+	int getWidth() const { return width; }
+	int getDepth() const { return depth; }
+
+	static const float cellSize;
+
+private:
+	const LevelGrid* map;
+	int width, depth;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "GridRay.h"
+
+
+const float GridRay::parallel = 1.0e-8f;
+
+
+bool GridRay::isBlocked(const std::vector<unsigned char>& solid, int width, int depth, float cellSize, float bottom, float top,
+	Vector3f origin, Vector3f direction, float maxDistance)
+{
+	// Only the Part Between the Bottom and Top of the Walls can Reach One
+	float tNear = 0.0, tFar = maxDistance;
+	if (fabsf(direction.y) < parallel)
+	{
+		if (origin.y < bottom || origin.y > top)
+			return false;
+	}
+	else
+	{
+		float t0 = (bottom - origin.y) / direction.y;
+		float t1 = (top - origin.y) / direction.y;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+		if (tNear > tFar)
+			return false;
+	}
+
+	// There Every Wall Cell Reached is Hit, as All Walls Fill its Height
+	return traverse(width, depth, cellSize, origin, direction, tNear, tFar,
+		[&](int x, int z) { return solid[z * width + x] != 0; });
+}
@@ -0,0 +1,101 @@
+#ifndef GRIDRAY_H_
+#define GRIDRAY_H_
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#include "Vector.h"
+
+/*
+ * Rays Against the Maze Grid
+ * Every wall is a whole cell filling the same height, so a ray is clipped to the box holding all
+ * the walls and then steps through the cells it crosses, as Amanatides and Woo, until it reaches
+ * a wall or runs out. Inside the box any wall cell reached is a hit. The stepping is shared with
+ * anything else that walks a path through the cells, such as the swept ball.
+ */
+class GridRay {
+public:
+	static const float parallel;		// Direction components smaller than this never cross a cell edge
+
+	// Walls Fill [bottom, top] over the Cells Set in solid, x Fastest, Centred on Multiples of cellSize
+	static bool isBlocked(const std::vector<unsigned char>& solid, int width, int depth, float cellSize, float bottom, float top,
+		Vector3f origin, Vector3f direction, float maxDistance);		// direction normalised
+
+	// Calls visit(x, z) for Each Cell of a width by depth Grid that origin + direction * t Crosses in x and z for t in
+	// [minTime, maxTime], in Order, Stopping as Soon as it Returns true - true if it Did
+	template <typename Visit>
+	static bool traverse(int width, int depth, float cellSize, Vector3f origin, Vector3f direction, float minTime, float maxTime, Visit visit);
+};
+
+
+template <typename Visit>
+bool GridRay::traverse(int width, int depth, float cellSize, Vector3f origin, Vector3f direction, float minTime, float maxTime, Visit visit)
+{
+	if (width <= 0 || depth <= 0)
+		return false;
+
+	float half = cellSize * 0.5f;
+	float o[2] = { origin.x, origin.z };
+	float d[2] = { direction.x, direction.z };
+
+	// Clip to the Grid
+	float boxMax[2] = { width * cellSize - half, depth * cellSize - half };
+	float tNear = minTime, tFar = maxTime;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (fabsf(d[axis]) < parallel)
+		{
+			if (o[axis] < -half || o[axis] > boxMax[axis])
+				return false;
+			continue;
+		}
+		float t0 = (-half - o[axis]) / d[axis];
+		float t1 = (boxMax[axis] - o[axis]) / d[axis];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+		if (tNear > tFar)
+			return false;
+	}
+
+	int x = std::min(std::max((int)floorf((o[0] + d[0] * tNear + half) / cellSize), 0), width - 1);
+	int z = std::min(std::max((int)floorf((o[1] + d[1] * tNear + half) / cellSize), 0), depth - 1);
+
+	// Times the Path Next Crosses an Edge, Never Along an Axis it Does Not Move On
+	const float never = 1.0e30f;
+	int stepX = d[0] > 0.0 ? 1 : -1;
+	int stepZ = d[1] > 0.0 ? 1 : -1;
+	float nextX = fabsf(d[0]) < parallel ? never : ((x + (stepX > 0 ? 1 : 0)) * cellSize - half - o[0]) / d[0];
+	float nextZ = fabsf(d[1]) < parallel ? never : ((z + (stepZ > 0 ? 1 : 0)) * cellSize - half - o[1]) / d[1];
+	float deltaX = fabsf(d[0]) < parallel ? never : cellSize / fabsf(d[0]);
+	float deltaZ = fabsf(d[1]) < parallel ? never : cellSize / fabsf(d[1]);
+
+	while (true)
+	{
+		if (visit(x, z))
+			return true;
+
+		if (nextX < nextZ)
+		{
+			if (nextX >= tFar)
+				return false;
+			x += stepX;
+			nextX += deltaX;
+			if (x < 0 || x >= width)
+				return false;
+		}
+		else
+		{
+			if (nextZ >= tFar)
+				return false;
+			z += stepZ;
+			nextZ += deltaZ;
+			if (z < 0 || z >= depth)
+				return false;
+		}
+	}
+}
+
+#endif
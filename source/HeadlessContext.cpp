@@ -0,0 +1,176 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+#include <string.h>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+HeadlessContext::HeadlessContext()
+	: display(NULL), context(NULL), surface(NULL), framebuffer(0), colourbuffer(0), depthbuffer(0)
+{
+}
+
+
+HeadlessContext::~HeadlessContext()
+{
+	release();
+}
+
+
+#ifdef _WIN32
+
+bool HeadlessContext::init(int width, int height)
+{
+	std::cout << "Headless rendering needs EGL, which is not available on Windows" << std::endl;
+	return false;
+}
+
+
+void HeadlessContext::release()
+{
+}
+
+#else
+
+bool HeadlessContext::init(int width, int height)
+{
+	// Prefer Mesa's Surfaceless Platform, which needs no X Server or GPU Device
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != NULL)
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+	if (eglDisplay == EGL_NO_DISPLAY)
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor))
+	{
+		std::cout << "Failed to initialise EGL" << std::endl;
+		return false;
+	}
+	display = eglDisplay;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "EGL does not support desktop OpenGL" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+	eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount);
+
+	// The Surfaceless Platform has no Configs, so Use None where Allowed
+	const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+	bool noConfig = extensions != NULL && strstr(extensions, "EGL_KHR_no_config_context") != NULL;
+	if (configCount == 0 && !noConfig)
+	{
+		std::cout << "No EGL config for OpenGL" << std::endl;
+		return false;
+	}
+
+	EGLContext eglContext = eglCreateContext(eglDisplay, configCount > 0 ? config : (EGLConfig)0, EGL_NO_CONTEXT, NULL);
+	if (eglContext == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create EGL context" << std::endl;
+		return false;
+	}
+	context = eglContext;
+
+	// Without EGL_KHR_surfaceless_context a Tiny Pbuffer is Needed to Make the Context Current
+	EGLSurface eglSurface = EGL_NO_SURFACE;
+	if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+	{
+		const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		if (configCount > 0)
+			eglSurface = eglCreatePbufferSurface(eglDisplay, config, surfaceAttributes);
+		if (eglSurface == EGL_NO_SURFACE || !eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
+		{
+			std::cout << "Failed to make EGL context current" << std::endl;
+			return false;
+		}
+		surface = eglSurface;
+	}
+
+	// GLEW Looks for a GLX Display it does not Need Here
+	glewExperimental = GL_TRUE;
+	GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (result == GLEW_ERROR_NO_GLX_DISPLAY)
+		result = GLEW_OK;
+#endif
+	if (result != GLEW_OK)
+	{
+		std::cout << "Failed to initialize GLEW" << std::endl;
+		return false;
+	}
+
+	// Framebuffer with Colour and Depth Renderbuffers
+	glGenRenderbuffers(1, &colourbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colourbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colourbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Headless framebuffer is incomplete" << std::endl;
+		return false;
+	}
+
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glViewport(0, 0, width, height);
+
+	std::cout << "Headless: " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION) << std::endl;
+	return true;
+}
+
+
+void HeadlessContext::release()
+{
+	if (display == NULL)
+		return;
+
+	if (context != NULL)
+	{
+		if (colourbuffer != 0)
+		{
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(1, &colourbuffer);
+			glDeleteRenderbuffers(1, &depthbuffer);
+			framebuffer = colourbuffer = depthbuffer = 0;
+		}
+
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+	}
+	if (surface != NULL)
+		eglDestroySurface(display, surface);
+	eglTerminate(display);
+
+	display = NULL;
+	context = NULL;
+	surface = NULL;
+}
+
+#endif
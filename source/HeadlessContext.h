@@ -0,0 +1,32 @@
+#ifndef HEADLESSCONTEXT_H_
+#define HEADLESSCONTEXT_H_
+
+#include <GL/glew.h>
+
+/*
+ * OpenGL Context with No Window
+ * A surfaceless EGL context, so the game can render on machines with no display such as build
+ * servers running Mesa's llvmpipe. Everything is drawn into a framebuffer object with colour
+ * and depth renderbuffers, which stays bound. Not available on Windows.
+ */
+class HeadlessContext {
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	bool init(int width, int height);		// Creates the context, makes it current and loads GLEW
+	void release();
+
+	GLuint getFramebuffer() const { return framebuffer; }
+
+private:
+	void* display;		// EGLDisplay
+	void* context;		// EGLContext
+	void* surface;		// EGLSurface, only when surfaceless contexts are unsupported
+
+	GLuint framebuffer;
+	GLuint colourbuffer;
+	GLuint depthbuffer;
+};
+
+#endif
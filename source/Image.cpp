@@ -0,0 +1,197 @@
+#include "Image.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdlib.h>
+
+
+bool Image::WritePPM(const std::string& filename, int width, int height, const unsigned char* rgba, int stride)
+{
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output.is_open())
+		return false;
+
+	output << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<unsigned char> row(width * 3);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		const unsigned char* pixel = rgba + (size_t)y * stride * 4;
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			row[x * 3] = pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = pixel[2];
+		}
+		output.write((const char*)&row[0], row.size());
+	}
+	return true;
+}
+
+
+static unsigned int crc32(const unsigned char* data, size_t length, unsigned int crc = 0)
+{
+	static unsigned int table[256];
+	static bool tableBuilt = false;
+	if (!tableBuilt)
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		tableBuilt = true;
+	}
+
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+
+static void writePNGChunk(std::ofstream& output, const char* type, const std::vector<unsigned char>& data)
+{
+	unsigned char header[8] =
+	{
+		(unsigned char)(data.size() >> 24), (unsigned char)(data.size() >> 16), (unsigned char)(data.size() >> 8), (unsigned char)data.size(),
+		(unsigned char)type[0], (unsigned char)type[1], (unsigned char)type[2], (unsigned char)type[3]
+	};
+	unsigned int crc = crc32(header + 4, 4);
+	if (!data.empty())
+		crc = crc32(&data[0], data.size(), crc);
+	unsigned char footer[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+
+	output.write((const char*)header, 8);
+	if (!data.empty())
+		output.write((const char*)&data[0], data.size());
+	output.write((const char*)footer, 4);
+}
+
+// Uncompressed PNG: the image is stored in zlib stored blocks, so no compression library is needed
+bool Image::WritePNG(const std::string& filename, int width, int height, const unsigned char* rgba, int stride)
+{
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output.is_open())
+		return false;
+
+	// Raw Scanlines, Filter Type 0, Top Row First
+	std::vector<unsigned char> raw;
+	raw.reserve((width * 3 + 1) * height);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		raw.push_back(0);
+		const unsigned char* pixel = rgba + (size_t)y * stride * 4;
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			raw.push_back(pixel[0]);
+			raw.push_back(pixel[1]);
+			raw.push_back(pixel[2]);
+		}
+	}
+
+	// zlib Stream of Stored Blocks
+	std::vector<unsigned char> compressed;
+	compressed.push_back(0x78);
+	compressed.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		size_t blockLength = std::min((size_t)65535, raw.size() - offset);
+		bool last = offset + blockLength == raw.size();
+		compressed.push_back(last ? 1 : 0);
+		compressed.push_back(blockLength & 0xFF);
+		compressed.push_back((blockLength >> 8) & 0xFF);
+		compressed.push_back(~blockLength & 0xFF);
+		compressed.push_back((~blockLength >> 8) & 0xFF);
+		compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + blockLength);
+		offset += blockLength;
+	} while (offset < raw.size());
+
+	unsigned int adlerA = 1, adlerB = 0;
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		adlerA = (adlerA + raw[i]) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	unsigned int adler = (adlerB << 16) | adlerA;
+	compressed.push_back(adler >> 24);
+	compressed.push_back((adler >> 16) & 0xFF);
+	compressed.push_back((adler >> 8) & 0xFF);
+	compressed.push_back(adler & 0xFF);
+
+	// Signature and Chunks
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	output.write((const char*)signature, 8);
+
+	std::vector<unsigned char> header(13, 0);
+	header[0] = (width >> 24) & 0xFF; header[1] = (width >> 16) & 0xFF; header[2] = (width >> 8) & 0xFF; header[3] = width & 0xFF;
+	header[4] = (height >> 24) & 0xFF; header[5] = (height >> 16) & 0xFF; header[6] = (height >> 8) & 0xFF; header[7] = height & 0xFF;
+	header[8] = 8;		// Bit depth
+	header[9] = 2;		// Colour type RGB
+
+	writePNGChunk(output, "IHDR", header);
+	writePNGChunk(output, "IDAT", compressed);
+	writePNGChunk(output, "IEND", std::vector<unsigned char>());
+	return true;
+}
+
+
+// Reads the binary PPMs written by WritePPM, flipped back to bottom row first with opaque alpha
+bool Image::ReadPPM(const std::string& filename, int& width, int& height, std::vector<unsigned char>& rgba)
+{
+	std::ifstream input(filename.c_str(), std::ios::binary);
+	if (!input.is_open())
+		return false;
+
+	std::string magic;
+	int maxValue = 0;
+	input >> magic >> width >> height >> maxValue;
+	if (!input || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+		return false;
+	input.get();	// Single whitespace before the pixels
+
+	std::vector<unsigned char> row(width * 3);
+	rgba.resize((size_t)width * height * 4);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		input.read((char*)&row[0], row.size());
+		if (!input)
+			return false;
+
+		unsigned char* pixel = &rgba[(size_t)y * width * 4];
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			pixel[0] = row[x * 3];
+			pixel[1] = row[x * 3 + 1];
+			pixel[2] = row[x * 3 + 2];
+			pixel[3] = 255;
+		}
+	}
+	return true;
+}
+
+
+// Alpha is ignored as the files do not store it
+double Image::Compare(const unsigned char* a, const unsigned char* b, int width, int height, int tolerance, int& maxDifference)
+{
+	maxDifference = 0;
+	if (width <= 0 || height <= 0)
+		return 0.0;
+
+	size_t differing = 0;
+	size_t pixels = (size_t)width * height;
+	for (size_t i = 0; i < pixels; i++, a += 4, b += 4)
+	{
+		int difference = 0;
+		for (int c = 0; c < 3; c++)
+			difference = std::max(difference, abs((int)a[c] - (int)b[c]));
+
+		maxDifference = std::max(maxDifference, difference);
+		if (difference > tolerance)
+			differing++;
+	}
+	return (double)differing / pixels;
+}
@@ -0,0 +1,22 @@
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#include <string>
+#include <vector>
+
+/*
+ * Reading, Writing and Comparing Frame Captures
+ * Pixels are RGBA8 with the bottom row first, as read back from OpenGL. Files are written top
+ * row first. PNG output uses zlib stored blocks, so no compression library is needed.
+ */
+class Image {
+public:
+	static bool WritePPM(const std::string& filename, int width, int height, const unsigned char* rgba, int stride);	// stride in pixels
+	static bool WritePNG(const std::string& filename, int width, int height, const unsigned char* rgba, int stride);
+	static bool ReadPPM(const std::string& filename, int& width, int& height, std::vector<unsigned char>& rgba);
+
+	// Fraction of Pixels with a Channel Differing by more than the Tolerance
+	static double Compare(const unsigned char* a, const unsigned char* b, int width, int height, int tolerance, int& maxDifference);
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "InputRecorder.h"
+
+#include <fstream>
+#include <string.h>
+
+
+static const char fileMagic[4] = { 'I', 'N', 'P', '1' };
+
+
+InputRecorder::InputRecorder()
+	: nextEvent(0), recording(false), playing(false), tickMilliseconds(0.0), tickCount(0), startChecksum(0), finalChecksum(0), bytes(0)
+{
+}
+
+
+void InputRecorder::start(double tickMilliseconds, unsigned long long startChecksum)
+{
+	events.clear();
+	this->tickMilliseconds = tickMilliseconds;
+	this->startChecksum = startChecksum;
+	recording = true;
+	playing = false;
+}
+
+
+void InputRecorder::add(const InputEvent& event)
+{
+	if (recording)
+		events.push_back(event);
+}
+
+
+bool InputRecorder::save(const std::string& filename, unsigned int tickCount, unsigned long long finalChecksum)
+{
+	recording = false;
+	this->tickCount = tickCount;
+	this->finalChecksum = finalChecksum;
+
+	std::vector<unsigned char> encoded;
+	unsigned int lastTick = 0;
+	int lastX = 0, lastY = 0;
+	for (int i = 0; i < events.size(); i++)
+	{
+		const InputEvent& event = events[i];
+		writeVarint(event.tick - lastTick, encoded);
+		encoded.push_back(event.type);
+		lastTick = event.tick;
+
+		if (event.type == InputEvent::KeyDown || event.type == InputEvent::KeyUp)
+		{
+			encoded.push_back(event.key);
+			continue;
+		}
+		if (event.type == InputEvent::MouseButton)
+		{
+			encoded.push_back(event.key);
+			encoded.push_back(event.state);
+		}
+
+		// Positions Move a Little at a Time, so Offsets are Small Either Way
+		int offsetX = event.x - lastX, offsetY = event.y - lastY;
+		writeVarint(((unsigned int)offsetX << 1) ^ (unsigned int)(offsetX >> 31), encoded);
+		writeVarint(((unsigned int)offsetY << 1) ^ (unsigned int)(offsetY >> 31), encoded);
+		lastX = event.x;
+		lastY = event.y;
+	}
+
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output)
+		return false;
+
+	unsigned int eventCount = (unsigned int)events.size();
+	unsigned int encodedBytes = (unsigned int)encoded.size();
+	output.write(fileMagic, sizeof(fileMagic));
+	output.write((const char*)&tickMilliseconds, sizeof(tickMilliseconds));
+	output.write((const char*)&startChecksum, sizeof(startChecksum));
+	output.write((const char*)&finalChecksum, sizeof(finalChecksum));
+	output.write((const char*)&tickCount, sizeof(tickCount));
+	output.write((const char*)&eventCount, sizeof(eventCount));
+	output.write((const char*)&encodedBytes, sizeof(encodedBytes));
+	if (encodedBytes > 0)
+		output.write((const char*)&encoded[0], encodedBytes);
+	bytes = sizeof(fileMagic) + sizeof(tickMilliseconds) + sizeof(startChecksum) + sizeof(finalChecksum) + 3 * sizeof(unsigned int) + encodedBytes;
+	return (bool)output;
+}
+
+
+bool InputRecorder::load(const std::string& filename)
+{
+	events.clear();
+	nextEvent = 0;
+	recording = false;
+	playing = false;
+
+	std::ifstream input(filename.c_str(), std::ios::binary);
+	if (!input)
+		return false;
+
+	char magic[4];
+	unsigned int eventCount, encodedBytes;
+	input.read(magic, sizeof(magic));
+	input.read((char*)&tickMilliseconds, sizeof(tickMilliseconds));
+	input.read((char*)&startChecksum, sizeof(startChecksum));
+	input.read((char*)&finalChecksum, sizeof(finalChecksum));
+	input.read((char*)&tickCount, sizeof(tickCount));
+	input.read((char*)&eventCount, sizeof(eventCount));
+	input.read((char*)&encodedBytes, sizeof(encodedBytes));
+	if (!input || memcmp(magic, fileMagic, sizeof(magic)) != 0)
+		return false;
+
+	// Sizes from a Damaged File must Not Decide what is Allocated - the Events must Fit in the Rest of the File,
+	// and Each Takes at Least Two Bytes, its Ticks and its Type
+	std::streamoff headerEnd = input.tellg();
+	input.seekg(0, std::ios::end);
+	std::streamoff fileEnd = input.tellg();
+	input.seekg(headerEnd);
+	if (!input || encodedBytes > fileEnd - headerEnd || eventCount > encodedBytes / 2)
+		return false;
+
+	std::vector<unsigned char> encoded(encodedBytes);
+	if (encodedBytes > 0)
+		input.read((char*)&encoded[0], encodedBytes);
+	if (!input)
+		return false;
+
+	// Decode, Stopping at the First Event that Runs Off the End
+	size_t position = 0;
+	unsigned int tick = 0;
+	int x = 0, y = 0;
+	events.reserve(eventCount);
+	for (unsigned int i = 0; i < eventCount; i++)
+	{
+		InputEvent event = {};
+		unsigned int ticks, offsetX = 0, offsetY = 0;
+		if (!readVarint(encoded, position, ticks) || position >= encoded.size())
+			return false;
+		event.type = encoded[position++];
+		tick += ticks;
+		event.tick = tick;
+
+		if (event.type > InputEvent::MouseMotion)
+			return false;
+		if (event.type != InputEvent::MouseMotion)
+		{
+			if (position >= encoded.size())
+				return false;
+			event.key = encoded[position++];
+		}
+		if (event.type == InputEvent::MouseButton)
+		{
+			if (position >= encoded.size())
+				return false;
+			event.state = encoded[position++];
+		}
+		if (event.type == InputEvent::MouseButton || event.type == InputEvent::MouseMotion)
+		{
+			if (!readVarint(encoded, position, offsetX) || !readVarint(encoded, position, offsetY))
+				return false;
+			x += (int)(offsetX >> 1) ^ -(int)(offsetX & 1);
+			y += (int)(offsetY >> 1) ^ -(int)(offsetY & 1);
+			event.x = x;
+			event.y = y;
+		}
+		events.push_back(event);
+	}
+
+	bytes = sizeof(fileMagic) + sizeof(tickMilliseconds) + sizeof(startChecksum) + sizeof(finalChecksum) + 3 * sizeof(unsigned int) + encodedBytes;
+	playing = true;
+	return true;
+}
+
+
+bool InputRecorder::next(unsigned int tick, InputEvent& event)
+{
+	if (!playing || nextEvent >= events.size() || events[nextEvent].tick > tick)
+		return false;
+
+	event = events[nextEvent++];
+	return true;
+}
+
+
+void InputRecorder::writeVarint(unsigned int value, std::vector<unsigned char>& out)
+{
+	// Seven Bits at a Time, Lowest First
+	while (value >= 0x80)
+	{
+		out.push_back((unsigned char)(value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+
+bool InputRecorder::readVarint(const std::vector<unsigned char>& in, size_t& position, unsigned int& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (position >= in.size())
+			return false;
+		unsigned char byte = in[position++];
+		value |= (unsigned int)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,68 @@
+#ifndef INPUTRECORDER_H_
+#define INPUTRECORDER_H_
+
+#include <string>
+#include <vector>
+
+// Keyboard or Mouse Event, Stamped with the Number of Ticks Run before it Arrived
+struct InputEvent
+{
+	enum Type { KeyDown, KeyUp, MouseButton, MouseMotion };
+
+	unsigned int tick;
+	unsigned char type;
+	unsigned char key;		// Key, or mouse button
+	unsigned char state;	// Mouse button state
+	int x, y;				// Mouse position, unused for keys
+};
+
+/*
+ * Keyboard and Mouse Input of a Run, to be Played Back Later
+ * Events are stamped with the tick they arrived before, so played back ahead of the same ticks
+ * through the same handlers they reach the same state whatever the frame rate. A file holds
+ * the tick length, checksums of the state at the start and at the end, and the events as
+ * varints: ticks since the previous event, the type, then the key or the button and state, with
+ * mouse positions as zigzag offsets from the previous position. A key event takes 3 bytes.
+ */
+class InputRecorder {
+public:
+	InputRecorder();
+	~InputRecorder(){};
+
+	// Recording
+	void start(double tickMilliseconds, unsigned long long startChecksum);
+	void add(const InputEvent& event);
+	bool save(const std::string& filename, unsigned int tickCount, unsigned long long finalChecksum);
+	bool isRecording() const { return recording; }
+
+	// Playback - next() gives the events stamped up to the tick, in order, false when there are no more
+	bool load(const std::string& filename);
+	bool next(unsigned int tick, InputEvent& event);
+	bool isPlaying() const { return playing; }
+	bool isFinished(unsigned int tick) const { return tick >= tickCount; }
+
+	// Recording as Loaded or Saved
+	int getEventCount() const { return (int)events.size(); }
+	unsigned int getTickCount() const { return tickCount; }
+	double getTickMilliseconds() const { return tickMilliseconds; }
+	unsigned long long getStartChecksum() const { return startChecksum; }
+	unsigned long long getFinalChecksum() const { return finalChecksum; }
+	long long getBytes() const { return bytes; }
+
+private:
+	static void writeVarint(unsigned int value, std::vector<unsigned char>& out);
+	static bool readVarint(const std::vector<unsigned char>& in, size_t& position, unsigned int& value);
+
+	std::vector<InputEvent> events;
+	int nextEvent;				// Next to play back
+	bool recording;
+	bool playing;
+
+	double tickMilliseconds;
+	unsigned int tickCount;
+	unsigned long long startChecksum;
+	unsigned long long finalChecksum;
+	long long bytes;			// Of the file
+};
+
+#endif
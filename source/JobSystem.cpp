@@ -0,0 +1,315 @@
+#include "JobSystem.h"
+
+
+// Slot of the Calling Thread in the Job System it Last Ran Jobs for
+struct ThreadSlotIndex
+{
+	const void* system;
+	int generation;
+	int slot;
+};
+static thread_local ThreadSlotIndex threadSlot = { 0, 0, -1 };
+
+// Shared by Every Job System, so One Made where Another Was Never Matches its Indices
+static std::atomic<int> slotGeneration(0);
+
+// One Worker per Hardware Thread, Leaving One for the Caller
+static unsigned int hardwareWorkers()
+{
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+
+JobSystem::WorkDeque::WorkDeque()
+	: top(0), bottom(0), buffer(new std::atomic<Job*>[capacity])
+{
+}
+
+
+bool JobSystem::WorkDeque::push(Job* job)
+{
+	long long b = bottom.load(std::memory_order_relaxed);
+	long long t = top.load(std::memory_order_acquire);
+	if (b - t >= capacity)
+		return false;
+
+	buffer[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+
+JobSystem::Job* JobSystem::WorkDeque::pop()
+{
+	long long b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		// Empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	Job* job = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// Last Job, Raced for with Thieves
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = 0;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+
+JobSystem::Job* JobSystem::WorkDeque::steal()
+{
+	long long t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return 0;
+
+	Job* job = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return 0;
+	return job;
+}
+
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: externalCount(0), generation(0), queuedJobs(0), sleepingWorkers(0), stopping(false), jobCount(0), stealCount(0)
+{
+	start(threadCount > 0 ? threadCount - 1 : hardwareWorkers());
+}
+
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+
+void JobSystem::setThreadCount(unsigned int threadCount)
+{
+	stop();
+	start(threadCount > 0 ? threadCount - 1 : hardwareWorkers());
+}
+
+
+void JobSystem::start(unsigned int workerCount)
+{
+	slots.clear();
+	for (unsigned int i = 0; i < workerCount + maxExternalThreads; i++)
+		slots.push_back(std::unique_ptr<ThreadSlot>(new ThreadSlot()));
+	externalCount = 0;
+	generation = ++slotGeneration;
+
+	stopping = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, (int)i));
+}
+
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+	workers.clear();
+}
+
+
+int JobSystem::currentSlot()
+{
+	if (threadSlot.system == this && threadSlot.generation == generation)
+		return threadSlot.slot;
+
+	int external = externalCount.fetch_add(1);
+	int slot = external < maxExternalThreads ? (int)workers.size() + external : -1;
+	threadSlot.system = this;
+	threadSlot.generation = generation;
+	threadSlot.slot = slot;
+	return slot;
+}
+
+
+void JobSystem::workerLoop(int slot)
+{
+	threadSlot.system = this;
+	threadSlot.generation = generation;
+	threadSlot.slot = slot;
+
+	while (true)
+	{
+		Job* job = find(slot);
+		if (job)
+		{
+			execute(job);
+			continue;
+		}
+
+		// Nothing to Take, so Sleep until a Job is Queued Anywhere
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		sleepCondition.wait(lock, [this] { return stopping || queuedJobs.load() > 0; });
+		sleepingWorkers--;
+		if (stopping)
+			return;
+	}
+}
+
+
+JobSystem::Job* JobSystem::allocate(int slot)
+{
+	ThreadSlot& thread = *slots[slot];
+	Job& job = thread.jobs[thread.nextJob % jobsPerThread];
+	if (job.busy.load(std::memory_order_acquire))
+		return 0;
+
+	thread.nextJob++;
+	job.busy.store(true, std::memory_order_relaxed);
+	return &job;
+}
+
+
+void JobSystem::submit(int slot, Job* job)
+{
+	job->counter->count.fetch_add(1, std::memory_order_relaxed);
+	if (!slots[slot]->deque.push(job))
+	{
+		execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1);
+	if (sleepingWorkers.load() > 0)
+	{
+		// Taking the Lock Means a Worker about to Sleep either Sees the Job or is Woken
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		sleepCondition.notify_one();
+	}
+}
+
+
+JobSystem::Job* JobSystem::find(int slot)
+{
+	Job* job = slot >= 0 ? slots[slot]->deque.pop() : 0;
+
+	// Steal Round the Other Threads, Starting Past this One so Thieves Spread Out
+	for (int i = 1; !job && i <= (int)slots.size(); i++)
+	{
+		int victim = (slot + i + (int)slots.size()) % (int)slots.size();
+		if (victim == slot)
+			continue;
+		job = slots[victim]->deque.steal();
+		if (job)
+			stealCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (job)
+		queuedJobs.fetch_sub(1);
+	return job;
+}
+
+
+void JobSystem::execute(Job* job)
+{
+	JobCounter* counter = job->counter;
+	if (job->range)
+		splitRange(currentSlot(), *job->range, job->begin, job->end, job->grainSize, *counter);
+	else
+		job->work();
+
+	jobCount.fetch_add(1, std::memory_order_relaxed);
+	job->busy.store(false, std::memory_order_release);
+	counter->count.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+
+void JobSystem::run(const std::function<void()>& work, JobCounter& counter)
+{
+	int slot = currentSlot();
+	Job* job = slot >= 0 ? allocate(slot) : 0;
+	if (!job)
+	{
+		work();
+		return;
+	}
+
+	job->work = work;
+	job->range = 0;
+	job->counter = &counter;
+	submit(slot, job);
+}
+
+
+void JobSystem::wait(JobCounter& counter)
+{
+	int slot = currentSlot();
+	while (!counter.isDone())
+	{
+		Job* job = find(slot);
+		if (job)
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+
+// Halves the range, handing the upper half out as a job each time, until one block is left to run here
+void JobSystem::splitRange(int slot, const std::function<void(int, int)>& task, int begin, int end, int grainSize, JobCounter& counter)
+{
+	while (end - begin > grainSize && slot >= 0)
+	{
+		int middle = begin + ((end - begin) / grainSize + 1) / 2 * grainSize;
+		Job* job = allocate(slot);
+		if (!job)
+			break;
+
+		job->work = nullptr;
+		job->range = &task;
+		job->begin = middle;
+		job->end = end;
+		job->grainSize = grainSize;
+		job->counter = &counter;
+		submit(slot, job);
+		end = middle;
+	}
+
+	// Blocks Keep to Multiples of the Grain from the Start, as with Fixed Blocks
+	for (int block = begin; block < end; block += grainSize)
+		task(block, block + grainSize < end ? block + grainSize : end);
+}
+
+
+void JobSystem::parallelFor(int count, const std::function<void(int begin, int end)>& task, int grainSize)
+{
+	if (count <= 0)
+		return;
+	if (grainSize < 1)
+		grainSize = 1;
+
+	// Nothing to share out
+	if (workers.empty() || count <= grainSize)
+	{
+		task(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	splitRange(currentSlot(), task, 0, count, grainSize, counter);
+	wait(counter);
+}
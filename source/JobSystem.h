@@ -0,0 +1,119 @@
+#ifndef JOBSYSTEM_H_
+#define JOBSYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Jobs Still to Finish - Raised when a Job is Run against it and Lowered when the Job Ends */
+class JobCounter {
+public:
+	JobCounter() : count(0) {}
+	bool isDone() const { return count.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> count;
+};
+
+/*
+ * Worker Threads that Share Out Jobs by Stealing them
+ * Every thread running jobs has its own Chase-Lev deque. A thread pushes the jobs it makes onto
+ * the bottom of its deque and pops the newest back off, while idle threads steal the oldest from
+ * the top of another's, so work spreads without a shared queue or lock. A job may wait on the
+ * counter of the jobs it depends on, running other jobs meanwhile rather than blocking, which
+ * is how parallelFor splits a range: each half is a job, split again by whoever takes it, down
+ * to the grain size. Threads other than the workers, such as the main and simulation threads,
+ * get a deque of their own the first time they run jobs. Jobs come from a fixed ring per
+ * thread, and a job made when the ring is full runs on the spot instead.
+ */
+class JobSystem {
+public:
+	JobSystem(unsigned int threadCount = 0);	// Threads running jobs, the caller included, so threadCount - 1 workers - 0 for one per hardware thread
+	~JobSystem();
+
+	void setThreadCount(unsigned int threadCount);		// Threads running jobs, the caller included, 0 for one per hardware thread - only while no jobs are running
+
+	void run(const std::function<void()>& work, JobCounter& counter);
+	void wait(JobCounter& counter);		// Runs jobs until the counter reaches zero
+
+	// Runs task(begin, end) over [0, count) in blocks of at least grainSize, caller thread joins in
+	void parallelFor(int count, const std::function<void(int begin, int end)>& task, int grainSize = 1);
+
+	unsigned int size() const { return (unsigned int)workers.size() + 1; }	// Worker threads plus caller
+
+	// Statistics since Start
+	long long getJobCount() const { return jobCount.load(std::memory_order_relaxed); }
+	long long getStealCount() const { return stealCount.load(std::memory_order_relaxed); }
+
+	static const int maxExternalThreads = 4;		// Threads other than the workers that may run jobs
+	static const int jobsPerThread = 4096;
+
+private:
+	struct Job
+	{
+		Job() : range(0), begin(0), end(0), grainSize(1), counter(0), busy(false) {}
+
+		std::function<void()> work;
+		const std::function<void(int, int)>* range;		// Set instead of work for a block of parallelFor
+		int begin, end, grainSize;
+		JobCounter* counter;
+		std::atomic<bool> busy;							// Queued or running, so its slot in the ring is taken
+	};
+
+	// Chase-Lev Deque of Fixed Size - the Owner Pushes and Pops the Bottom, Anyone Steals the Top
+	class WorkDeque {
+	public:
+		WorkDeque();
+		bool push(Job* job);		// false when full
+		Job* pop();
+		Job* steal();
+
+	private:
+		static const int capacity = jobsPerThread;		// Power of two
+		std::atomic<long long> top;
+		std::atomic<long long> bottom;
+		std::unique_ptr<std::atomic<Job*>[]> buffer;
+	};
+
+	// Deque and Job Ring of a Thread
+	struct ThreadSlot
+	{
+		ThreadSlot() : jobs(jobsPerThread), nextJob(0) {}
+
+		WorkDeque deque;
+		std::vector<Job> jobs;
+		unsigned int nextJob;
+	};
+
+	void start(unsigned int workerCount);
+	void stop();
+	void workerLoop(int slot);
+
+	int currentSlot();						// Of the calling thread, -1 if every slot for other threads is taken
+	Job* allocate(int slot);				// null when the ring is full
+	void submit(int slot, Job* job);
+	Job* find(int slot);					// Own newest job, else another thread's oldest
+	void execute(Job* job);
+	void splitRange(int slot, const std::function<void(int, int)>& task, int begin, int end, int grainSize, JobCounter& counter);
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<ThreadSlot>> slots;		// Workers first, then the other threads
+	std::atomic<int> externalCount;
+	int generation;										// Of the slots, so stale thread slot indices are not used
+
+	std::atomic<int> queuedJobs;
+	std::atomic<int> sleepingWorkers;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<bool> stopping;
+
+	std::atomic<long long> jobCount;
+	std::atomic<long long> stealCount;
+};
+
+#endif
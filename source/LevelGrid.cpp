@@ -0,0 +1,219 @@
+#include "LevelGrid.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+
+static const char fileMagic[4] = { 'L', 'V', 'L', '1' };
+
+
+LevelGrid::LevelGrid()
+	: width(0), depth(0), coinCount(0), levelCoinCount(0), spawn(-1), firstWall(-1), loadTime(0.0), restartTime(0.0)
+{
+}
+
+
+bool LevelGrid::load(const std::string& filename)
+{
+	double started = Profiler::now();
+	std::ifstream input(filename.c_str(), std::ios::binary);
+	if (!input)
+		return false;
+
+	// Whole File at Once
+	input.seekg(0, std::ios::end);
+	std::vector<char> text((size_t)input.tellg());
+	input.seekg(0, std::ios::beg);
+	if (!text.empty())
+		input.read(&text[0], text.size());
+	if (!input)
+		return false;
+
+	if (text.size() >= sizeof(fileMagic) + 2 * sizeof(int) && memcmp(&text[0], fileMagic, sizeof(fileMagic)) == 0)
+	{
+		int header[2];
+		memcpy(header, &text[sizeof(fileMagic)], sizeof(header));
+		size_t cellsStart = sizeof(fileMagic) + sizeof(header);
+		if (header[0] < 0 || header[1] < 0 || text.size() - cellsStart != (size_t)header[0] * header[1])
+			return false;
+		setLevel(header[0], header[1], (const unsigned char*)&text[0] + cellsStart);
+	}
+	else
+		parseText(text);
+
+	loadTime = Profiler::now() - started;
+	return true;
+}
+
+
+void LevelGrid::parseText(const std::vector<char>& text)
+{
+	// A Line per Row, Numbers Separated by Spaces - First Find the Rows and the Longest
+	int rows = 0, longest = 0, count = 0;
+	bool inNumber = false;
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		char c = text[i];
+		bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		if (!space && !inNumber)
+			count++;
+		inNumber = !space;
+		if (c == '\n')
+		{
+			longest = std::max(longest, count);
+			count = 0;
+			rows++;
+		}
+	}
+	if (!text.empty() && text.back() != '\n')
+	{
+		longest = std::max(longest, count);
+		rows++;
+	}
+
+	// Then Read the Numbers Straight into their Cells - Anything Other than a Digit or Space Ends the Row, Leaving the Rest of its Cells Empty
+	std::vector<unsigned char> parsed((size_t)longest * rows, 0);
+	int x = 0, z = 0, value = 0;
+	bool skipping = false;
+	inNumber = false;
+	for (size_t i = 0; i <= text.size(); i++)
+	{
+		char c = i < text.size() ? text[i] : '\n';
+		if (skipping && c != '\n')
+			continue;
+		if (c >= '0' && c <= '9')
+		{
+			value = std::min(value * 10 + (c - '0'), 255);
+			inNumber = true;
+			continue;
+		}
+		bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		if (inNumber)
+			parsed[(size_t)z * longest + x++] = (unsigned char)value;
+		inNumber = false;
+		value = 0;
+		skipping = !space;
+		if (c == '\n' && i < text.size())
+		{
+			x = 0;
+			z++;
+		}
+	}
+
+	setLevel(longest, rows, parsed.empty() ? 0 : &parsed[0]);
+}
+
+
+bool LevelGrid::save(const std::string& filename) const
+{
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output)
+		return false;
+
+	int header[2] = { width, depth };
+	output.write(fileMagic, sizeof(fileMagic));
+	output.write((const char*)header, sizeof(header));
+	if (!cells.empty())
+		output.write((const char*)&cells[0], cells.size());
+	return (bool)output;
+}
+
+
+void LevelGrid::setLevel(int width, int depth, const unsigned char* cells)
+{
+	this->width = width;
+	this->depth = depth;
+	this->cells.assign(cells, cells + (size_t)width * depth);
+	indexLevel();
+}
+
+
+void LevelGrid::indexLevel()
+{
+	size_t words = (cells.size() + 63) / 64;
+	wallBits.assign(words, 0);
+	coinBits.assign(words, 0);
+	coinCount = 0;
+	spawn = -1;
+	firstWall = -1;
+	for (int i = 0; i < cells.size(); i++)
+	{
+		if (cells[i] == 0)
+			continue;
+		wallBits[i >> 6] |= 1ull << (i & 63);
+		if (firstWall < 0)
+			firstWall = i;
+		if (cells[i] == 1 && spawn < 0)
+			spawn = i;
+		if (cells[i] == 2)
+		{
+			coinBits[i >> 6] |= 1ull << (i & 63);
+			coinCount++;
+		}
+	}
+
+	levelCells = cells;
+	levelWallBits = wallBits;
+	levelCoinBits = coinBits;
+	levelCoinCount = coinCount;
+}
+
+
+void LevelGrid::restart()
+{
+	double started = Profiler::now();
+	if (!cells.empty())
+	{
+		memcpy(&cells[0], &levelCells[0], cells.size());
+		memcpy(&wallBits[0], &levelWallBits[0], wallBits.size() * sizeof(unsigned long long));
+		memcpy(&coinBits[0], &levelCoinBits[0], coinBits.size() * sizeof(unsigned long long));
+	}
+	coinCount = levelCoinCount;
+	restartTime = Profiler::now() - started;
+}
+
+
+void LevelGrid::set(int x, int z, int value)
+{
+	int cell = z * width + x;
+	unsigned long long bit = 1ull << (cell & 63);
+	if ((cells[cell] == 2) != (value == 2))
+		coinCount += value == 2 ? 1 : -1;
+
+	cells[cell] = (unsigned char)value;
+	wallBits[cell >> 6] = value != 0 ? wallBits[cell >> 6] | bit : wallBits[cell >> 6] & ~bit;
+	coinBits[cell >> 6] = value == 2 ? coinBits[cell >> 6] | bit : coinBits[cell >> 6] & ~bit;
+}
+
+
+void LevelGrid::getCoins(std::vector<int>& coins) const
+{
+	// Whole Words without a Coin are Skipped
+	for (int word = 0; word < coinBits.size(); word++)
+	{
+		if (!coinBits[word])
+			continue;
+		for (int bit = 0; bit < 64; bit++)
+			if (coinBits[word] >> bit & 1)
+				coins.push_back(word * 64 + bit);
+	}
+}
+
+
+bool LevelGrid::getSpawn(int& x, int& z) const
+{
+	if (spawn < 0)
+		return false;
+	x = spawn % width;
+	z = spawn / width;
+	return true;
+}
+
+
+long long LevelGrid::getBytes() const
+{
+	return (long long)(cells.size() + levelCells.size()) +
+		(long long)(wallBits.size() + coinBits.size() + levelWallBits.size() + levelCoinBits.size()) * sizeof(unsigned long long);
+}
@@ -0,0 +1,68 @@
+#ifndef LEVELGRID_H_
+#define LEVELGRID_H_
+
+#include <string>
+#include <vector>
+
+/*
+ * The Maze's Cells in One Block, a Byte Each
+ * Cells are 0 for none, 1 for a wall and 2 for a wall with a coin, x fastest, with rows shorter
+ * than the longest padded with 0. Bitsets of the walls and the coins are kept in step, so coins
+ * are found 64 cells at a time. The level as loaded is kept beside it with its coin count and
+ * spawn, so restarting copies it back instead of reading the file again. Text levels are parsed
+ * straight from the file's bytes, binary levels are a small header and the cells.
+ */
+class LevelGrid {
+public:
+	LevelGrid();
+	~LevelGrid(){};
+
+	bool load(const std::string& filename);			// Text, or binary when it starts as save() writes it
+	bool save(const std::string& filename) const;	// Binary
+	void setLevel(int width, int depth, const unsigned char* cells);
+	void restart();									// Back to the level as loaded
+
+	int getWidth() const { return width; }
+	int getDepth() const { return depth; }
+	int get(int x, int z) const { return x >= 0 && x < width && z >= 0 && z < depth ? cells[z * width + x] : 0; }	// 0 outside
+	void set(int x, int z, int value);
+	bool isWall(int x, int z) const { return x >= 0 && x < width && z >= 0 && z < depth && (wallBits[(z * width + x) >> 6] >> ((z * width + x) & 63) & 1); }
+	bool hasCoin(int x, int z) const { return x >= 0 && x < width && z >= 0 && z < depth && (coinBits[(z * width + x) >> 6] >> ((z * width + x) & 63) & 1); }
+	const unsigned char* getRow(int z) const { return cells.data() + z * width; }
+	const unsigned char* getCells() const { return cells.empty() ? 0 : &cells[0]; }
+
+	void getCoins(std::vector<int>& coins) const;	// z * width + x of each coin, in row order
+	int getCoinCount() const { return coinCount; }
+
+	// Level as Loaded
+	int getLevelCoinCount() const { return levelCoinCount; }
+	bool getSpawn(int& x, int& z) const;			// First plain wall in row order, false for none
+	int getFirstWall() const { return firstWall; }	// Row order index of the first cell that is not 0, -1 for none
+
+	// Statistics
+	long long getBytes() const;
+	double getLoadTime() const { return loadTime; }
+	double getRestartTime() const { return restartTime; }
+
+private:
+	void parseText(const std::vector<char>& text);
+	void indexLevel();
+
+	int width, depth;
+	std::vector<unsigned char> cells;
+	std::vector<unsigned long long> wallBits;		// Bit per cell that is not 0
+	std::vector<unsigned long long> coinBits;
+	int coinCount;
+
+	std::vector<unsigned char> levelCells;
+	std::vector<unsigned long long> levelWallBits;
+	std::vector<unsigned long long> levelCoinBits;
+	int levelCoinCount;
+	int spawn;										// Row order index, -1 for none
+	int firstWall;
+
+	double loadTime;
+	double restartTime;
+};
+
+#endif
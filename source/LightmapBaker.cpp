@@ -0,0 +1,484 @@
+#include "LightmapBaker.h"
+#include "GLState.h"
+#include "GridRay.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+
+
+const float LightmapBaker::cellSize = 30.0;
+
+// Normal, then the Axes Texture u and v Run along, as the Faces of cube.obj
+static const float sideAxes[6][3][3] = {
+	{ { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+	{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+	{ { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+	{ { 0, -1, 0 }, { 0, 0, -1 }, { 1, 0, 0 } },
+	{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+	{ { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } }
+};
+
+
+LightmapBaker::LightmapBaker(JobSystem& jobSystem)
+	: jobSystem(jobSystem), sunDirection(0.0, 1.0, 0.0), sunColour(1.0, 1.0, 1.0), skyColour(0.0, 0.0, 0.0),
+	width(0), depth(0), lightReach(0.0), tileSize(0), tilesPerRow(0), atlasWidth(0), atlasHeight(0),
+	geometryChanged(false), texelsChanged(false), bakeTime(0.0), buildCount(0), texture(0), vertexBuffer(0), indexBuffer(0)
+{
+	// Hammersley Points, Mapped to a Cosine Weighted Hemisphere
+	for (int i = 0; i < aoRays; i++)
+	{
+		unsigned int bits = i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+
+		float u = (i + 0.5f) / aoRays;
+		float v = bits * 2.3283064365386963e-10f;
+		float radius = sqrtf(u);
+		float angle = 2.0f * 3.14159265f * v;
+		aoDirections.push_back(Vector3f(radius * cosf(angle), radius * sinf(angle), sqrtf(1.0f - u)));
+	}
+}
+
+
+void LightmapBaker::setSun(Vector3f direction, Vector3f colour)
+{
+	sunDirection = Vector3f::normalise(direction);
+	sunColour = colour;
+}
+
+
+void LightmapBaker::setSky(Vector3f colour)
+{
+	skyColour = colour;
+}
+
+
+long long LightmapBaker::getBytes() const
+{
+	// RGBA16F Atlas
+	return (long long)atlasWidth * atlasHeight * 8 + (long long)vertices.size() * sizeof(GLfloat) + (long long)indices.size() * sizeof(GLuint);
+}
+
+
+bool LightmapBaker::update(const LevelGrid& map, const std::vector<PointLight>& lights)
+{
+	// Walls as a Flat Grid
+	int newWidth = map.getWidth();
+	int newDepth = map.getDepth();
+
+	std::vector<unsigned char> newSolid(newWidth * newDepth);
+	for (int i = 0; i < newSolid.size(); i++)
+		newSolid[i] = map.getCells()[i] != 0 ? 1 : 0;
+
+	// Lights by the Cell Below them
+	std::vector<std::vector<PointLight>> newCellLights(newWidth * newDepth);
+	float newReach = 0.0;
+	for (int i = 0; i < lights.size() && !newCellLights.empty(); i++)
+	{
+		int x = std::min(std::max((int)floorf(lights[i].position.x / cellSize + 0.5f), 0), newWidth - 1);
+		int z = std::min(std::max((int)floorf(lights[i].position.z / cellSize + 0.5f), 0), newDepth - 1);
+		newCellLights[z * newWidth + x].push_back(lights[i]);
+		newReach = std::max(newReach, lights[i].radius);
+	}
+
+	// New Walls Need Everything Baked Again
+	if (newWidth != width || newDepth != depth || newSolid != solid)
+	{
+		double started = Profiler::now();
+		width = newWidth;
+		depth = newDepth;
+		solid.swap(newSolid);
+		cellLights.swap(newCellLights);
+		lightReach = newReach;
+		build();
+		bakeTime = Profiler::now() - started;
+		buildCount++;
+		return true;
+	}
+
+	// Otherwise Only Cells whose Lights Changed
+	std::vector<unsigned char> changed(width * depth, 0);
+	bool anyChanged = false;
+	for (int c = 0; c < cellLights.size(); c++)
+	{
+		const std::vector<PointLight>& before = cellLights[c];
+		const std::vector<PointLight>& after = newCellLights[c];
+		bool same = before.size() == after.size();
+		for (int i = 0; i < before.size() && same; i++)
+		{
+			same = before[i].position.x == after[i].position.x && before[i].position.y == after[i].position.y && before[i].position.z == after[i].position.z &&
+				before[i].colour.x == after[i].colour.x && before[i].colour.y == after[i].colour.y && before[i].colour.z == after[i].colour.z &&
+				before[i].radius == after[i].radius;
+		}
+		if (!same)
+		{
+			changed[c] = 1;
+			anyChanged = true;
+		}
+	}
+	if (!anyChanged)
+		return false;
+
+	double started = Profiler::now();
+
+	// Faces within Reach of a Changed Light, Old or New
+	int reach = (int)ceilf(std::max(lightReach, newReach) / cellSize) + 1;
+	std::vector<unsigned char> near(width * depth, 0);
+	for (int z = 0; z < depth; z++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			if (!changed[z * width + x])
+				continue;
+			for (int nz = std::max(z - reach, 0); nz <= std::min(z + reach, depth - 1); nz++)
+				for (int nx = std::max(x - reach, 0); nx <= std::min(x + reach, width - 1); nx++)
+					near[nz * width + nx] = 1;
+		}
+	}
+
+	cellLights.swap(newCellLights);
+	lightReach = newReach;
+
+	std::vector<int> relit;
+	for (int f = 0; f < faces.size(); f++)
+		if (near[faces[f].z * width + faces[f].x])
+			relit.push_back(f);
+
+	jobSystem.parallelFor((int)relit.size(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			bakeFace(relit[i], false);
+	}, 16);
+	texelsChanged = true;
+
+	Profiler::addTime("Lightmap Relight", Profiler::now() - started);
+	Profiler::addCounter("Lightmap Faces Relit", (double)relit.size());
+	return true;
+}
+
+
+void LightmapBaker::build()
+{
+	// Faces Open to the Air, Grouped by Chunk
+	faces.clear();
+	chunks.clear();
+	for (int chunkZ = 0; chunkZ < depth; chunkZ += chunkSize) {
+		for (int chunkX = 0; chunkX < width; chunkX += chunkSize) {
+			int first = (int)faces.size();
+			for (int z = chunkZ; z < chunkZ + chunkSize && z < depth; z++) {
+				for (int x = chunkX; x < chunkX + chunkSize && x < width; x++) {
+					if (!isSolid(x, z))
+						continue;
+					for (int side = 0; side < 6; side++)
+					{
+						int nx = x + (int)sideAxes[side][0][0];
+						int nz = z + (int)sideAxes[side][0][2];
+						if (side == 2 || side == 3 || !isSolid(nx, nz))
+						{
+							Face face = { x, z, side, (int)faces.size() };
+							faces.push_back(face);
+						}
+					}
+				}
+			}
+			if ((int)faces.size() == first)
+				continue;
+
+			Chunk chunk;
+			chunk.minimum[0] = chunkX * cellSize - cellSize * 0.5f;
+			chunk.minimum[1] = -cellSize * 0.5f;
+			chunk.minimum[2] = chunkZ * cellSize - cellSize * 0.5f;
+			chunk.maximum[0] = (chunkX + chunkSize) * cellSize - cellSize * 0.5f;
+			chunk.maximum[1] = cellSize * 0.5f;
+			chunk.maximum[2] = (chunkZ + chunkSize) * cellSize - cellSize * 0.5f;
+			chunk.firstIndex = first * 6;
+			chunk.indexCount = ((int)faces.size() - first) * 6;
+			chunks.push_back(chunk);
+		}
+	}
+
+	// Largest Tiles that Fit the Atlas
+	int faceCount = (int)faces.size();
+	for (tileSize = 8; tileSize > 1; tileSize /= 2)
+	{
+		int tilesPerSide = maxAtlasSize / (tileSize + 2);
+		if ((long long)tilesPerSide * tilesPerSide >= faceCount)
+			break;
+	}
+	int tile = tileSize + 2;
+	tilesPerRow = std::max(1, std::min(faceCount, maxAtlasSize / tile));
+	atlasWidth = tilesPerRow * tile;
+	atlasHeight = std::max(1, (faceCount + tilesPerRow - 1) / tilesPerRow) * tile;
+	if (atlasHeight > maxAtlasSize)
+	{
+		std::cout << "Lightmap atlas needs " << atlasHeight << " rows, clamped to " << maxAtlasSize << std::endl;
+		atlasHeight = maxAtlasSize;
+	}
+	texels.assign((size_t)atlasWidth * atlasHeight * 4, 0.0f);
+
+	// Four Corners per Face, Texture Coordinates as the Cube, Lightmap Coordinates Inside the Tile's Border
+	vertices.resize(faces.size() * 4 * 7);
+	indices.resize(faces.size() * 6);
+	for (int f = 0; f < faces.size(); f++)
+	{
+		const Face& face = faces[f];
+		float tileX = (float)(face.tile % tilesPerRow * tile + 1);
+		float tileY = (float)(face.tile / tilesPerRow * tile + 1);
+
+		static const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+		for (int c = 0; c < 4; c++)
+		{
+			Vector3f position, normal;
+			facePoint(face, corners[c][0], corners[c][1], position, normal);
+
+			GLfloat* vertex = &vertices[(f * 4 + c) * 7];
+			vertex[0] = position.x;
+			vertex[1] = position.y;
+			vertex[2] = position.z;
+			vertex[3] = corners[c][0];
+			vertex[4] = corners[c][1];
+			vertex[5] = (tileX + corners[c][0] * tileSize) / atlasWidth;
+			vertex[6] = (tileY + corners[c][1] * tileSize) / atlasHeight;
+		}
+
+		static const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+		for (int i = 0; i < 6; i++)
+			indices[f * 6 + i] = f * 4 + quad[i];
+	}
+
+	jobSystem.parallelFor(faceCount, [&](int begin, int end)
+	{
+		for (int f = begin; f < end; f++)
+			bakeFace(f, true);
+	}, 16);
+
+	geometryChanged = true;
+	texelsChanged = true;
+}
+
+
+void LightmapBaker::bakeFace(int index, bool occlusion)
+{
+	const Face& face = faces[index];
+	int tile = tileSize + 2;
+	int tileX = face.tile % tilesPerRow * tile;
+	int tileY = face.tile / tilesPerRow * tile;
+	if (tileY + tile > atlasHeight)
+		return;
+
+	Vector3f normal, uAxis, vAxis;
+	uAxis = Vector3f(sideAxes[face.side][1][0], sideAxes[face.side][1][1], sideAxes[face.side][1][2]);
+	vAxis = Vector3f(sideAxes[face.side][2][0], sideAxes[face.side][2][1], sideAxes[face.side][2][2]);
+
+	int reach = (int)ceilf(lightReach / cellSize) + 1;
+
+	for (int j = 0; j < tileSize; j++)
+	{
+		for (int i = 0; i < tileSize; i++)
+		{
+			Vector3f position;
+			facePoint(face, (i + 0.5f) / tileSize, (j + 0.5f) / tileSize, position, normal);
+			Vector3f origin = position + normal * 0.01f;
+			float* texel = &texels[((size_t)(tileY + 1 + j) * atlasWidth + tileX + 1 + i) * 4];
+
+			// Sun
+			Vector3f light(0.0, 0.0, 0.0);
+			float sunNDotL = Vector3f::dot(normal, sunDirection);
+			if (sunNDotL > 0.0 && !isOccluded(origin, sunDirection, 1.0e6f))
+				light = sunColour * sunNDotL;
+
+			// Coin Lights in Reach, Faded as in shader.frag
+			for (int z = std::max(face.z - reach, 0); z <= std::min(face.z + reach, depth - 1); z++) {
+				for (int x = std::max(face.x - reach, 0); x <= std::min(face.x + reach, width - 1); x++) {
+					const std::vector<PointLight>& lights = cellLights[z * width + x];
+					for (int l = 0; l < lights.size(); l++)
+					{
+						Vector3f toLight = Vector3f(lights[l].position) - position;
+						float distance = toLight.length();
+						if (distance >= lights[l].radius || distance <= 0.0)
+							continue;
+
+						Vector3f direction = toLight / distance;
+						float nDotL = Vector3f::dot(normal, direction);
+						if (nDotL <= 0.0 || isOccluded(origin, direction, distance))
+							continue;
+
+						float falloff = 1.0f - distance / lights[l].radius;
+						light = light + Vector3f(lights[l].colour) * (falloff * falloff * nDotL);
+					}
+				}
+			}
+
+			// Share of the Hemisphere Open within a Cell
+			if (occlusion)
+			{
+				int open = 0;
+				for (int r = 0; r < aoRays; r++)
+				{
+					Vector3f direction = uAxis * aoDirections[r].x + vAxis * aoDirections[r].y + normal * aoDirections[r].z;
+					if (!isOccluded(origin, direction, cellSize))
+						open++;
+				}
+				texel[3] = (float)open / aoRays;
+			}
+
+			// Sky, Blocked as Much as the Ambient
+			light = light + skyColour * texel[3];
+			texel[0] = light.x;
+			texel[1] = light.y;
+			texel[2] = light.z;
+		}
+	}
+
+	copyBorder(face.tile);
+}
+
+
+/* Repeat the edge texels of a tile into its border so filtering never reads a neighbour */
+void LightmapBaker::copyBorder(int index)
+{
+	int tile = tileSize + 2;
+	int tileX = index % tilesPerRow * tile;
+	int tileY = index / tilesPerRow * tile;
+
+	for (int j = 0; j < tile; j++)
+	{
+		for (int i = 0; i < tile; i++)
+		{
+			if (i > 0 && i < tile - 1 && j > 0 && j < tile - 1)
+				continue;
+			int si = std::min(std::max(i, 1), tileSize);
+			int sj = std::min(std::max(j, 1), tileSize);
+			float* target = &texels[((size_t)(tileY + j) * atlasWidth + tileX + i) * 4];
+			const float* source = &texels[((size_t)(tileY + sj) * atlasWidth + tileX + si) * 4];
+			for (int c = 0; c < 4; c++)
+				target[c] = source[c];
+		}
+	}
+}
+
+
+void LightmapBaker::facePoint(const Face& face, float u, float v, Vector3f& position, Vector3f& normal) const
+{
+	const float (*axes)[3] = sideAxes[face.side];
+	float half = cellSize * 0.5f;
+	float a = (u - 0.5f) * cellSize;
+	float b = (v - 0.5f) * cellSize;
+
+	normal = Vector3f(axes[0][0], axes[0][1], axes[0][2]);
+	position = Vector3f(
+		face.x * cellSize + axes[0][0] * half + axes[1][0] * a + axes[2][0] * b,
+		axes[0][1] * half + axes[1][1] * a + axes[2][1] * b,
+		face.z * cellSize + axes[0][2] * half + axes[1][2] * a + axes[2][2] * b);
+}
+
+
+bool LightmapBaker::isSolid(int x, int z) const
+{
+	return x >= 0 && x < width && z >= 0 && z < depth && solid[z * width + x] != 0;
+}
+
+
+bool LightmapBaker::isOccluded(Vector3f origin, Vector3f direction, float maxDistance) const
+{
+	return GridRay::isBlocked(solid, width, depth, cellSize, -cellSize * 0.5f, cellSize * 0.5f, origin, direction, maxDistance);
+}
+
+
+void LightmapBaker::upload()
+{
+	if (texture == 0)
+	{
+		glGenTextures(1, &texture);
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glGenBuffers(1, &vertexBuffer);
+		glGenBuffers(1, &indexBuffer);
+	}
+
+	if (geometryChanged)
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, std::max((size_t)1, vertices.size()) * sizeof(GLfloat), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, std::max((size_t)1, indices.size()) * sizeof(GLuint), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, atlasWidth, atlasHeight, 0, GL_RGBA, GL_FLOAT, &texels[0]);
+	}
+	else if (texelsChanged)
+	{
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlasWidth, atlasHeight, GL_RGBA, GL_FLOAT, &texels[0]);
+	}
+
+	geometryChanged = false;
+	texelsChanged = false;
+}
+
+
+void LightmapBaker::draw(Matrix4x4 viewProjection, GLuint positionAttribute, GLuint texCoordAttribute, GLuint lightmapAttribute)
+{
+	// Chunks in View, Drawn Together
+	drawCounts.clear();
+	drawOffsets.clear();
+	const float* m = viewProjection.getPtr();
+	for (int c = 0; c < chunks.size(); c++)
+	{
+		int outside[6] = { 0, 0, 0, 0, 0, 0 };
+		for (int i = 0; i < 8; i++)
+		{
+			float x = (i & 1) ? chunks[c].maximum[0] : chunks[c].minimum[0];
+			float y = (i & 2) ? chunks[c].maximum[1] : chunks[c].minimum[1];
+			float z = (i & 4) ? chunks[c].maximum[2] : chunks[c].minimum[2];
+
+			float cx = m[0] * x + m[4] * y + m[8] * z + m[12];
+			float cy = m[1] * x + m[5] * y + m[9] * z + m[13];
+			float cz = m[2] * x + m[6] * y + m[10] * z + m[14];
+			float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+			if (cx > cw) outside[0]++;
+			if (cx < -cw) outside[1]++;
+			if (cy > cw) outside[2]++;
+			if (cy < -cw) outside[3]++;
+			if (cz > cw) outside[4]++;
+			if (cz < -cw) outside[5]++;
+		}
+		bool visible = true;
+		for (int plane = 0; plane < 6; plane++)
+			visible = visible && outside[plane] < 8;
+		if (!visible)
+			continue;
+
+		// Neighbouring Chunks Merge into One Range
+		GLintptr offset = chunks[c].firstIndex * sizeof(GLuint);
+		if (!drawCounts.empty() && (GLintptr)drawOffsets.back() + drawCounts.back() * (GLintptr)sizeof(GLuint) == offset)
+			drawCounts.back() += chunks[c].indexCount;
+		else
+		{
+			drawCounts.push_back(chunks[c].indexCount);
+			drawOffsets.push_back((const GLvoid*)offset);
+		}
+	}
+	Profiler::addCounter("Lightmap Draw Ranges", (double)drawCounts.size());
+	if (drawCounts.empty())
+		return;
+
+	GLState::useVertexAttribArrays((1u << positionAttribute) | (1u << texCoordAttribute) | (1u << lightmapAttribute));
+
+	GLsizei stride = 7 * sizeof(GLfloat);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLState::vertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, stride, 0);
+	GLState::vertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, stride, 3 * sizeof(GLfloat));
+	GLState::vertexAttribPointer(lightmapAttribute, 2, GL_FLOAT, GL_FALSE, stride, 5 * sizeof(GLfloat));
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glMultiDrawElements(GL_TRIANGLES, &drawCounts[0], GL_UNSIGNED_INT, &drawOffsets[0], (GLsizei)drawCounts.size());
+}
@@ -0,0 +1,113 @@
+#ifndef LIGHTMAPBAKER_H_
+#define LIGHTMAPBAKER_H_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "ClusteredLighting.h"
+#include "JobSystem.h"
+#include "LevelGrid.h"
+
+/*
+ * Baked Lighting of the Maze Walls
+ * Every wall face open to the air gets a small tile of an atlas holding its diffuse light from a
+ * fixed sun, the sky and the coin lights, each shadowed, and its ambient occlusion. Shadow and occlusion
+ * rays march through the map grid cell by cell, and faces are baked as jobs. When
+ * coins are collected only the faces their lights reached are baked again. The faces are kept
+ * in one buffer, grouped into chunks of cells that are culled against the view before drawing.
+ */
+class LightmapBaker {
+public:
+	LightmapBaker(JobSystem& jobSystem);
+	~LightmapBaker(){};
+
+	void setSun(Vector3f direction, Vector3f colour);		// Direction towards the sun, in world space
+	void setSky(Vector3f colour);							// Light from every direction, scaled by occlusion
+
+	// Bakes Whatever Changed Since the Last Call - Returns true if Anything was Baked
+	bool update(const LevelGrid& map, const std::vector<PointLight>& lights);
+	void upload();			// Sends baked changes to GL - needs a current GL context
+
+	void draw(Matrix4x4 viewProjection, GLuint positionAttribute, GLuint texCoordAttribute, GLuint lightmapAttribute);
+	GLuint getTexture() const { return texture; }
+
+	// Statistics of the Last Full Bake
+	int getBuildCount() const { return buildCount; }	// Full bakes so far
+	int getFaceCount() const { return (int)faces.size(); }
+	int getAtlasWidth() const { return atlasWidth; }
+	int getAtlasHeight() const { return atlasHeight; }
+	double getBakeTime() const { return bakeTime; }
+	long long getBytes() const;			// Atlas and geometry on the GPU
+
+	static const float cellSize;
+	static const int chunkSize = 8;		// Cells per side of a drawn chunk
+	static const int aoRays = 32;
+	static const int maxAtlasSize = 4096;
+
+private:
+	// Face Open to the Air, Axis Aligned
+	struct Face
+	{
+		int x, z;			// Cell
+		int side;			// 0 +x, 1 -x, 2 +y, 3 -y, 4 +z, 5 -z
+		int tile;			// Tile of the atlas
+	};
+
+	// Cells Drawn Together, with the Range of their Indices
+	struct Chunk
+	{
+		float minimum[3];
+		float maximum[3];
+		int firstIndex;
+		int indexCount;
+	};
+
+	bool isSolid(int x, int z) const;
+	bool isOccluded(Vector3f origin, Vector3f direction, float maxDistance) const;	// Ray against the walls, direction normalised
+
+	void build();				// Faces, tiles, geometry and ambient occlusion
+	void bakeFace(int face, bool occlusion);
+	void facePoint(const Face& face, float u, float v, Vector3f& position, Vector3f& normal) const;
+	void copyBorder(int tile);
+
+	JobSystem& jobSystem;
+
+	Vector3f sunDirection;
+	Vector3f sunColour;
+	Vector3f skyColour;
+
+	// Map as Last Baked
+	int width, depth;
+	std::vector<unsigned char> solid;					// Wall per cell, x fastest
+	std::vector<std::vector<PointLight>> cellLights;	// Lights by the cell they are above
+	float lightReach;									// Largest radius of any light
+
+	std::vector<Face> faces;
+	std::vector<Chunk> chunks;
+	std::vector<GLfloat> vertices;		// Position, texture and lightmap coordinates, interleaved
+	std::vector<GLuint> indices;
+
+	int tileSize;						// Texels across a face, each tile has a border texel more on every side
+	int tilesPerRow;
+	int atlasWidth, atlasHeight;
+	std::vector<float> texels;			// RGB diffuse light, A ambient occlusion
+	std::vector<Vector3f> aoDirections;	// Cosine weighted about +z
+
+	bool geometryChanged;
+	bool texelsChanged;
+	double bakeTime;
+	int buildCount;
+
+	GLuint texture;
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+
+	// Per Draw Scratch
+	std::vector<GLsizei> drawCounts;
+	std::vector<const GLvoid*> drawOffsets;
+};
+
+#endif
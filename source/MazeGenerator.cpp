@@ -0,0 +1,106 @@
+#include "MazeGenerator.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+
+MazeGenerator::MazeGenerator(unsigned int seed)
+	: seed(seed), state(seed), width(0), depth(0), passageCount(0), coinCount(0), generateTime(0.0)
+{
+}
+
+
+void MazeGenerator::generate(int width, int depth, float coinDensity)
+{
+	double started = Profiler::now();
+	this->width = width = std::max(width, 1);
+	this->depth = depth = std::max(depth, 1);
+	state = seed;
+	cells.assign((size_t)width * depth, 0);
+
+	// Carve from the Corner, Backing Up from Dead Ends
+	static const int steps[4][2] = { { 2, 0 }, { -2, 0 }, { 0, 2 }, { 0, -2 } };
+	std::vector<int> stack;
+	stack.push_back(0);
+	cells[0] = 1;
+	while (!stack.empty())
+	{
+		int cell = stack.back();
+		int x = cell % width, z = cell / width;
+
+		int choices[4];
+		int choiceCount = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int nextX = x + steps[i][0], nextZ = z + steps[i][1];
+			if (nextX >= 0 && nextX < width && nextZ >= 0 && nextZ < depth && !cells[nextZ * width + nextX])
+				choices[choiceCount++] = i;
+		}
+		if (choiceCount == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
+
+		const int* step = steps[choices[random() % choiceCount]];
+		cells[(z + step[1] / 2) * width + x + step[0] / 2] = 1;
+		cells[(z + step[1]) * width + x + step[0]] = 1;
+		stack.push_back((z + step[1]) * width + x + step[0]);
+	}
+
+	// Coins on the Passages, Never Under the Tank at the Spawn
+	passageCount = 1;
+	coinCount = 0;
+	int lastPassage = 0;
+	for (int i = 1; i < cells.size(); i++)
+	{
+		if (!cells[i])
+			continue;
+		passageCount++;
+		lastPassage = i;
+		if ((random() & 0xFFFFFF) < coinDensity * 16777216.0f)
+		{
+			cells[i] = 2;
+			coinCount++;
+		}
+	}
+
+	// A Level Needs a Coin to be Won
+	if (coinCount == 0 && coinDensity > 0.0f && lastPassage > 0)
+	{
+		cells[lastPassage] = 2;
+		coinCount++;
+	}
+
+	generateTime = Profiler::now() - started;
+}
+
+
+bool MazeGenerator::save(const std::string& filename) const
+{
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output)
+		return false;
+
+	// Whole Rows at a Time, Digits Separated by Spaces
+	std::vector<char> line(width * 2);
+	for (int z = 0; z < depth; z++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			line[x * 2] = (char)('0' + cells[z * width + x]);
+			line[x * 2 + 1] = x + 1 < width ? ' ' : '\n';
+		}
+		output.write(&line[0], line.size());
+	}
+	return (bool)output;
+}
+
+
+unsigned int MazeGenerator::random()
+{
+	// Linear Congruential, the High Bits are the Random Ones
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
@@ -0,0 +1,47 @@
+#ifndef MAZEGENERATOR_H_
+#define MAZEGENERATOR_H_
+
+#include <string>
+#include <vector>
+
+/*
+ * Seeded Maze Levels of Any Size
+ * Passages of wall cells, for the tank to drive along the top of, are carved by a recursive
+ * backtracker run with an explicit stack, so the largest levels cannot overflow the call stack:
+ * from the corner it steps to a random unvisited cell two away, opening the cell between, and
+ * backs up when there is none. Every passage is then reachable from the spawn in the corner.
+ * Coins are dropped on passage cells at the given density. The generator's own random numbers
+ * make a seed give the same level with any compiler.
+ */
+class MazeGenerator {
+public:
+	MazeGenerator(unsigned int seed = 1);
+	~MazeGenerator(){};
+
+	void generate(int width, int depth, float coinDensity);		// coinDensity is the chance of a coin on each passage cell
+	bool save(const std::string& filename) const;				// As a text level, a line of cells per row
+
+	int getWidth() const { return width; }
+	int getDepth() const { return depth; }
+	const std::vector<unsigned char>& getCells() const { return cells; }	// 0 none, 1 wall, 2 wall with a coin, x fastest
+
+	// Statistics of the Last Level
+	int getPassageCount() const { return passageCount; }
+	int getCoinCount() const { return coinCount; }
+	double getGenerateTime() const { return generateTime; }
+
+private:
+	unsigned int random();
+
+	unsigned int seed;
+	unsigned int state;
+
+	int width, depth;
+	std::vector<unsigned char> cells;
+
+	int passageCount;
+	int coinCount;
+	double generateTime;
+};
+
+#endif
@@ -1,7 +1,8 @@
 #include "Mesh.h"
+#include "GLState.h"
 
 
-void Mesh::loadOBJ(std::string filename)
+void Mesh::loadOBJ(std::string filename, bool createBuffers)
 {
 	/**
 	 * OBJ file format:
@@ -67,24 +68,18 @@ void Mesh::loadOBJ(std::string filename)
 				<< "\t Tex Coords: " 	<< texcoords.size() << "\n" 
 				<< "\t Faces: " 		<< faces.size() 	<< "\n" << std::endl;
 				
-				
-	initBuffers();
+	buildVertexData();
+
+	if(createBuffers)
+		initBuffers();
 }
 
-// Initialise vertex array buffers
-void Mesh::initBuffers()
+// Flatten faces into per vertex data and find the AABB
+void Mesh::buildVertexData()
 {
-	std::cout << "Start Init Mesh Buffers" << std::endl;
-	
-	// Initialise Buffers
-	glGenBuffers(1, &positionBuffer);
-	glGenBuffers(1, &normalBuffer);
-	glGenBuffers(1, &texcoordBuffer);
-	
-	// Data
-	std::vector<GLfloat> vertexPositionData;
-	std::vector<GLfloat> vertexNormalData;
-	std::vector<GLfloat> vertexTexcoordData;
+	vertexPositionData.clear();
+	vertexNormalData.clear();
+	vertexTexcoordData.clear();
 
 	// Go Through each Face and Add to Data
 	for(int face_i = 0 ; face_i < faces.size(); face_i++)
@@ -136,11 +131,22 @@ void Mesh::initBuffers()
 			}
 		}
 	}
+}
+
+// Initialise vertex array buffers
+void Mesh::initBuffers()
+{
+	std::cout << "Start Init Mesh Buffers" << std::endl;
+	
+	// Initialise Buffers
+	glGenBuffers(1, &positionBuffer);
+	glGenBuffers(1, &normalBuffer);
+	glGenBuffers(1, &texcoordBuffer);
 	
 	// Set Data for Position Buffer
 	if(positions.size() > 0)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
 		glBufferData(
 			GL_ARRAY_BUFFER,
 			vertexPositionData.size() * sizeof(GLfloat),
@@ -152,7 +158,7 @@ void Mesh::initBuffers()
 	// Set Data for Normal Buffer
 	if(normals.size() > 0)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, normalBuffer);
 		glBufferData(
 			GL_ARRAY_BUFFER, 
 			vertexNormalData.size() * sizeof(GLfloat), 
@@ -164,7 +170,7 @@ void Mesh::initBuffers()
 	// Set Data for Texture Coordinates Buffer
 	if(texcoords.size() > 0)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
 		glBufferData(GL_ARRAY_BUFFER,
 			vertexTexcoordData.size() * sizeof(GLfloat),
 			&vertexTexcoordData[0],
@@ -179,69 +185,68 @@ void Mesh::initBuffers()
 // Function to Draw a Mesh 
 void Mesh::draw(GLuint vertexPositionAttribute, GLuint vertexNormalAttribute, GLuint vertexTexcordAttribute)
 {
+	drawInstanced(1, -1, vertexPositionAttribute, vertexNormalAttribute, vertexTexcordAttribute);
+}
+
+void Mesh::drawInstanced(int instanceCount, GLuint instanceAttribute, GLuint vertexPositionAttribute, GLuint vertexNormalAttribute, GLuint vertexTexcordAttribute)
+{
+	// Attributes this Mesh Uses, Others Left Enabled by the Last Draw are Disabled
+	unsigned int attributes = 0;
+	if(instanceAttribute != -1)
+		attributes |= 1u << instanceAttribute;
+	if(positions.size() > 0)
+		attributes |= 1u << vertexPositionAttribute;
+	if(normals.size() > 0 && vertexNormalAttribute != -1)
+		attributes |= 1u << vertexNormalAttribute;
+	if(texcoords.size() > 0 && vertexTexcordAttribute != -1)
+		attributes |= 1u << vertexTexcordAttribute;
+	GLState::useVertexAttribArrays(attributes);
+
 	// Vertex Position Attribute and Buffer
 	if(positions.size() > 0)
 	{
-		glEnableVertexAttribArray(vertexPositionAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
-		glVertexAttribPointer(
+		GLState::bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+		GLState::vertexAttribPointer(
 			vertexPositionAttribute, 		// The attribute we want to configure
 			3,                  			// Size
 			GL_FLOAT,        			    // Type
 			GL_FALSE,           			// Normalized?
 			0,                  			// Stride
-			(void*)0            			// Array buffer offset
+			0            					// Array buffer offset
 		);
 	}
 
 	if(normals.size() > 0 && vertexNormalAttribute != -1)
 	{
-		glEnableVertexAttribArray(vertexNormalAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-		glVertexAttribPointer(
+		GLState::bindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+		GLState::vertexAttribPointer(
 			vertexNormalAttribute, 		// The attribute we want to configure
 			3,                 		 	// Size
 			GL_FLOAT,           		// Type
 			GL_FALSE,           		// Normalized?
 			0,                  		// Stride
-			(void*)0           			// Array buffer offset
+			0           				// Array buffer offset
 		);
 	}
 
 	if(texcoords.size() > 0 && vertexTexcordAttribute != -1)
 	{
-		glEnableVertexAttribArray(vertexTexcordAttribute);
-		glBindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
-		glVertexAttribPointer(
+		GLState::bindBuffer(GL_ARRAY_BUFFER, texcoordBuffer);
+		GLState::vertexAttribPointer(
 			vertexTexcordAttribute, 	// The attribute we want to configure
 			2,                  		// Size
 			GL_FLOAT,           		// Type
 			GL_FALSE,          			// Normalized?
 			0,                 			// Stride
-			(void*)0           			// Array buffer offset
+			0           				// Array buffer offset
 		);
 	}
 
-	// Draw Arrays
-	glDrawArrays(GL_TRIANGLES, 0, faces.size() * 3); 
-	
-	// Disable Vertex Psition Array
-	if(positions.size() > 0)
-	{
-		glDisableVertexAttribArray(vertexPositionAttribute);
-	}
-	
-	// Disable Vertex Normal Array
-	if(normals.size() > 0  && vertexNormalAttribute != -1)
-	{
-		glDisableVertexAttribArray(vertexNormalAttribute);
-	}
-
-	// Disable Vertex Texture Coordinates Array
-	if(texcoords.size() > 0 && vertexTexcordAttribute != -1)
-	{
-		glDisableVertexAttribArray(vertexTexcordAttribute);
-	}
+	// Draw Arrays, Attributes Stay Enabled for the Next Mesh
+	if(instanceAttribute != -1)
+		glDrawArraysInstanced(GL_TRIANGLES, 0, faces.size() * 3, instanceCount);
+	else
+		glDrawArrays(GL_TRIANGLES, 0, faces.size() * 3); 
 }
 
 
@@ -278,7 +283,7 @@ void Mesh::drawAABB(GLuint vertexPositionAttribute)
 
 	// Create Vertex Buffer and Upload Data
 	glGenBuffers(1, &AABBPositionBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, AABBPositionBuffer);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, AABBPositionBuffer);
 	glBufferData(GL_ARRAY_BUFFER,
 		sizeof(vertexPositionData),
 		vertexPositionData, 
@@ -286,15 +291,15 @@ void Mesh::drawAABB(GLuint vertexPositionAttribute)
 	);
 
 	// Enable vertexPositionAttribute and bind vertex position buffer to vertexPositonAttribute
-	glEnableVertexAttribArray(vertexPositionAttribute);
-	glBindBuffer(GL_ARRAY_BUFFER, AABBPositionBuffer);
-	glVertexAttribPointer(
+	GLState::enableVertexAttribArray(vertexPositionAttribute);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, AABBPositionBuffer);
+	GLState::vertexAttribPointer(
 		vertexPositionAttribute,	// The attribute we want to configure
 		3,							// size
 		GL_FLOAT,					// type
 		GL_FALSE,					// normalized?
 		0,							// stride
-		(void*)0					// array buffer offset
+		0							// array buffer offset
 	);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -302,7 +307,7 @@ void Mesh::drawAABB(GLuint vertexPositionAttribute)
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 	// Disable VertexPositionAttribute
-	glDisableVertexAttribArray(vertexPositionAttribute);
+	GLState::disableVertexAttribArray(vertexPositionAttribute);
 }
 
 void Mesh::transformAABB(Vector3f translate, Vector3f scale)
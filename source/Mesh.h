@@ -29,10 +29,17 @@ public:
 	Vector3f transformedMin;
 	Vector3f transformedMax;
 
-    void loadOBJ(std::string filename);
+    void loadOBJ(std::string filename, bool createBuffers = true);	// createBuffers = false keeps the mesh on the CPU only
 	void initBuffers();
 
+	// Flattened Vertex Data, Three Vertices per Face
+	const std::vector<GLfloat>& getPositionData() const { return vertexPositionData; }
+	const std::vector<GLfloat>& getNormalData() const { return vertexNormalData; }
+	const std::vector<GLfloat>& getTexcoordData() const { return vertexTexcoordData; }
+	int getVertexCount() const { return (int)faces.size() * 3; }
+
     void draw(GLuint vertexPositionAttribute, GLuint vertexNormalAttribute = -1, GLuint vertexTexcordAttribute = -1 );	// Draws mesh
+	void drawInstanced(int instanceCount, GLuint instanceAttribute, GLuint vertexPositionAttribute, GLuint vertexNormalAttribute = -1, GLuint vertexTexcordAttribute = -1);	// Instance attribute set up by the caller
 	void drawAABB(GLuint vertexPositionAttribute);																		// Draws AABB of mesh
 
 private:
@@ -50,6 +57,12 @@ private:
 	std::vector<Vector2f> texcoords;	// Mesh texture coordinates
 	std::vector<Face> faces;			// Mesh faces
 
+	void buildVertexData();
+
+	std::vector<GLfloat> vertexPositionData;	// Positions per face vertex
+	std::vector<GLfloat> vertexNormalData;		// Normals per face vertex
+	std::vector<GLfloat> vertexTexcoordData;	// Texture coordinates per face vertex
+
 	GLuint positionBuffer;	// OpenGL vertex position buffer
 	GLuint normalBuffer;	// OpenGL vertex normal buffer
 	GLuint texcoordBuffer;	// OpenGL vertex texture coordinates buffer
@@ -0,0 +1,321 @@
+#include "MeshBVH.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+
+MeshBVH::MeshBVH()
+	: buildTime(0.0)
+{
+}
+
+
+void MeshBVH::build(const std::vector<float>& positions)
+{
+	double started = Profiler::now();
+
+	triangles.assign(positions.begin(), positions.begin() + (positions.size() / 9) * 9);
+
+	// Box of Each Triangle, Binned by its Centre
+	std::vector<float> boxes(triangles.size() / 9 * 6);
+	for (int t = 0; t < triangles.size() / 9; t++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boxes[t * 6 + axis] = std::min(triangles[t * 9 + axis], std::min(triangles[t * 9 + 3 + axis], triangles[t * 9 + 6 + axis]));
+			boxes[t * 6 + 3 + axis] = std::max(triangles[t * 9 + axis], std::max(triangles[t * 9 + 3 + axis], triangles[t * 9 + 6 + axis]));
+		}
+	}
+
+	nodes.clear();
+	nodes.reserve(std::max(1, (int)triangles.size() / 9 * 2));
+	buildNode(0, (int)triangles.size() / 9, boxes);
+
+	buildTime = Profiler::now() - started;
+}
+
+
+int MeshBVH::buildNode(int start, int end, std::vector<float>& boxes)
+{
+	int index = (int)nodes.size();
+	nodes.push_back(Node());
+
+	// Bounds of the Triangles and of their Centres
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	float centreMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, centreMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int t = start; t < end; t++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float centre = (boxes[t * 6 + axis] + boxes[t * 6 + 3 + axis]) * 0.5f;
+			minimum[axis] = std::min(minimum[axis], boxes[t * 6 + axis]);
+			maximum[axis] = std::max(maximum[axis], boxes[t * 6 + 3 + axis]);
+			centreMin[axis] = std::min(centreMin[axis], centre);
+			centreMax[axis] = std::max(centreMax[axis], centre);
+		}
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		nodes[index].minimum[axis] = minimum[axis];
+		nodes[index].maximum[axis] = maximum[axis];
+	}
+	nodes[index].first = start;
+	nodes[index].count = end - start;
+
+	int count = end - start;
+	if (count <= maxLeafTriangles)
+		return index;
+
+	// Cheapest Split over the Bins of Each Axis, Cost as Surface Area times Triangles
+	auto area = [](const float* low, const float* high)
+	{
+		float x = high[0] - low[0], y = high[1] - low[1], z = high[2] - low[2];
+		return x * y + y * z + z * x;
+	};
+	float bestCost = area(minimum, maximum) * count;
+	int bestAxis = -1, bestSplit = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centreMax[axis] - centreMin[axis];
+		if (extent <= 0.0f)
+			continue;
+		float scale = binCount / extent;
+
+		int binCounts[binCount] = { 0 };
+		float binMin[binCount][3], binMax[binCount][3];
+		for (int b = 0; b < binCount; b++)
+			for (int a = 0; a < 3; a++)
+			{
+				binMin[b][a] = FLT_MAX;
+				binMax[b][a] = -FLT_MAX;
+			}
+
+		for (int t = start; t < end; t++)
+		{
+			float centre = (boxes[t * 6 + axis] + boxes[t * 6 + 3 + axis]) * 0.5f;
+			int b = std::min((int)((centre - centreMin[axis]) * scale), binCount - 1);
+			binCounts[b]++;
+			for (int a = 0; a < 3; a++)
+			{
+				binMin[b][a] = std::min(binMin[b][a], boxes[t * 6 + a]);
+				binMax[b][a] = std::max(binMax[b][a], boxes[t * 6 + 3 + a]);
+			}
+		}
+
+		// Sweep from the Right to Get the Cost of Every Right Side, then from the Left
+		float rightCost[binCount];
+		float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		int rightCount = 0;
+		for (int b = binCount - 1; b > 0; b--)
+		{
+			rightCount += binCounts[b];
+			for (int a = 0; a < 3; a++)
+			{
+				low[a] = std::min(low[a], binMin[b][a]);
+				high[a] = std::max(high[a], binMax[b][a]);
+			}
+			rightCost[b] = rightCount > 0 ? area(low, high) * rightCount : 0.0f;
+		}
+
+		int leftCount = 0;
+		for (int a = 0; a < 3; a++)
+		{
+			low[a] = FLT_MAX;
+			high[a] = -FLT_MAX;
+		}
+		for (int b = 0; b < binCount - 1; b++)
+		{
+			leftCount += binCounts[b];
+			for (int a = 0; a < 3; a++)
+			{
+				low[a] = std::min(low[a], binMin[b][a]);
+				high[a] = std::max(high[a], binMax[b][a]);
+			}
+			if (leftCount == 0 || leftCount == count)
+				continue;
+
+			// Splitting also Costs a Node Visit, Taken as Much as One Triangle Test
+			float cost = area(minimum, maximum) + area(low, high) * leftCount + rightCost[b + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b + 1;
+			}
+		}
+	}
+	if (bestAxis < 0)
+		return index;
+
+	// Move the Triangles Left of the Split to the Front
+	float scale = binCount / (centreMax[bestAxis] - centreMin[bestAxis]);
+	int middle = start;
+	for (int t = start; t < end; t++)
+	{
+		float centre = (boxes[t * 6 + bestAxis] + boxes[t * 6 + 3 + bestAxis]) * 0.5f;
+		if (std::min((int)((centre - centreMin[bestAxis]) * scale), binCount - 1) < bestSplit)
+		{
+			std::swap_ranges(triangles.begin() + t * 9, triangles.begin() + t * 9 + 9, triangles.begin() + middle * 9);
+			std::swap_ranges(boxes.begin() + t * 6, boxes.begin() + t * 6 + 6, boxes.begin() + middle * 6);
+			middle++;
+		}
+	}
+
+	// The First Child Follows its Parent, the Second is Found through first
+	nodes[index].count = 0;
+	buildNode(start, middle, boxes);
+	int second = buildNode(middle, end, boxes);
+	nodes[index].first = second;
+	return index;
+}
+
+
+bool MeshBVH::intersectsBox(Matrix4x4 model, Vector3f min, Vector3f max) const
+{
+	if (nodes.empty())
+		return false;
+
+	// Nodes are Culled by the Box as Seen from the Mesh, which Holds All of the Real Box
+	float worldMin[3] = { min.x, min.y, min.z };
+	float worldMax[3] = { max.x, max.y, max.z };
+	Matrix4x4 inverse = model.inverse();
+	float localMin[3], localMax[3];
+	transformBox(inverse.getPtr(), worldMin, worldMax, localMin, localMax);
+
+	const float* m = model.getPtr();
+	int stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+		if (node.minimum[0] > localMax[0] || node.maximum[0] < localMin[0] ||
+			node.minimum[1] > localMax[1] || node.maximum[1] < localMin[1] ||
+			node.minimum[2] > localMax[2] || node.maximum[2] < localMin[2])
+			continue;
+
+		if (node.count == 0)
+		{
+			if (stackSize + 2 > 64)
+				continue;
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = (int)(&node - &nodes[0]) + 1;
+			continue;
+		}
+
+		// Leaves are Tested Exactly, with their Triangles in the World
+		for (int t = node.first; t < node.first + node.count; t++)
+		{
+			float corners[3][3];
+			for (int v = 0; v < 3; v++)
+			{
+				const float* p = &triangles[t * 9 + v * 3];
+				for (int i = 0; i < 3; i++)
+					corners[v][i] = m[i] * p[0] + m[4 + i] * p[1] + m[8 + i] * p[2] + m[12 + i];
+			}
+			if (triangleTouchesBox(corners[0], corners[1], corners[2], worldMin, worldMax))
+				return true;
+		}
+	}
+	return false;
+}
+
+
+void MeshBVH::getBounds(Matrix4x4 model, Vector3f& min, Vector3f& max) const
+{
+	if (nodes.empty())
+	{
+		min = max = Vector3f(0.0, 0.0, 0.0);
+		return;
+	}
+
+	float low[3], high[3];
+	transformBox(model.getPtr(), nodes[0].minimum, nodes[0].maximum, low, high);
+	min = Vector3f(low[0], low[1], low[2]);
+	max = Vector3f(high[0], high[1], high[2]);
+}
+
+
+int MeshBVH::getLeafCount() const
+{
+	int leaves = 0;
+	for (int i = 0; i < nodes.size(); i++)
+		if (nodes[i].count > 0)
+			leaves++;
+	return leaves;
+}
+
+
+/* Box around the eight corners of a box moved by a matrix */
+void MeshBVH::transformBox(const float* m, const float* minimum, const float* maximum, float* outMinimum, float* outMaximum)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		outMinimum[i] = outMaximum[i] = m[12 + i];
+		for (int j = 0; j < 3; j++)
+		{
+			float a = m[j * 4 + i] * minimum[j];
+			float b = m[j * 4 + i] * maximum[j];
+			outMinimum[i] += std::min(a, b);
+			outMaximum[i] += std::max(a, b);
+		}
+	}
+}
+
+
+/* Separating axis test of a triangle and a box, as Akenine-Moller: the box's axes, the triangle's normal and their nine cross products */
+bool MeshBVH::triangleTouchesBox(const float* a, const float* b, const float* c, const float* minimum, const float* maximum)
+{
+	float centre[3], half[3], v[3][3];
+	for (int i = 0; i < 3; i++)
+	{
+		centre[i] = (minimum[i] + maximum[i]) * 0.5f;
+		half[i] = (maximum[i] - minimum[i]) * 0.5f;
+		v[0][i] = a[i] - centre[i];
+		v[1][i] = b[i] - centre[i];
+		v[2][i] = c[i] - centre[i];
+	}
+
+	// Box Axes
+	for (int i = 0; i < 3; i++)
+		if (std::min(v[0][i], std::min(v[1][i], v[2][i])) > half[i] || std::max(v[0][i], std::max(v[1][i], v[2][i])) < -half[i])
+			return false;
+
+	float edges[3][3];
+	for (int i = 0; i < 3; i++)
+	{
+		edges[0][i] = v[1][i] - v[0][i];
+		edges[1][i] = v[2][i] - v[1][i];
+		edges[2][i] = v[0][i] - v[2][i];
+	}
+
+	// Edge Cross Box Axis
+	for (int e = 0; e < 3; e++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			float axis[3] = { 0.0, 0.0, 0.0 };
+			int j = (i + 1) % 3, k = (i + 2) % 3;
+			axis[j] = -edges[e][k];
+			axis[k] = edges[e][j];
+
+			float p0 = axis[0] * v[0][0] + axis[1] * v[0][1] + axis[2] * v[0][2];
+			float p1 = axis[0] * v[1][0] + axis[1] * v[1][1] + axis[2] * v[1][2];
+			float p2 = axis[0] * v[2][0] + axis[1] * v[2][1] + axis[2] * v[2][2];
+			float radius = half[0] * fabsf(axis[0]) + half[1] * fabsf(axis[1]) + half[2] * fabsf(axis[2]);
+			if (std::min(p0, std::min(p1, p2)) > radius || std::max(p0, std::max(p1, p2)) < -radius)
+				return false;
+		}
+	}
+
+	// Triangle Normal
+	float normal[3] = {
+		edges[0][1] * edges[1][2] - edges[0][2] * edges[1][1],
+		edges[0][2] * edges[1][0] - edges[0][0] * edges[1][2],
+		edges[0][0] * edges[1][1] - edges[0][1] * edges[1][0] };
+	float distance = normal[0] * v[0][0] + normal[1] * v[0][1] + normal[2] * v[0][2];
+	float radius = half[0] * fabsf(normal[0]) + half[1] * fabsf(normal[1]) + half[2] * fabsf(normal[2]);
+	return fabsf(distance) <= radius;
+}
@@ -0,0 +1,56 @@
+#ifndef MESHBVH_H_
+#define MESHBVH_H_
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+
+/*
+ * Bounding Volume Hierarchy over a Mesh's Triangles
+ * Built once when the mesh is loaded. Each node's triangles are split where the surface area
+ * heuristic is lowest, over a few bins of their centres along each axis, until a split costs
+ * more than testing them all. Nodes sit in one array in depth first order, a parent followed by
+ * its first child, and the triangles are reordered so every leaf holds a run of them. Queries
+ * take the matrix the mesh is drawn with: a box is moved into the mesh's space by its inverse to
+ * cull nodes, then tested exactly against the triangles moved into the world.
+ */
+class MeshBVH {
+public:
+	MeshBVH();
+	~MeshBVH(){};
+
+	void build(const std::vector<float>& positions);		// Three positions per triangle, as Mesh::getPositionData
+
+	bool intersectsBox(Matrix4x4 model, Vector3f min, Vector3f max) const;			// Any triangle touching the world box
+	void getBounds(Matrix4x4 model, Vector3f& min, Vector3f& max) const;			// World box around the whole mesh
+
+	// Statistics
+	int getTriangleCount() const { return (int)triangles.size() / 9; }
+	int getNodeCount() const { return (int)nodes.size(); }
+	int getLeafCount() const;
+	double getBuildTime() const { return buildTime; }
+
+	static const int binCount = 12;
+	static const int maxLeafTriangles = 4;
+
+private:
+	// Node of 32 Bytes, Two to a Cache Line
+	struct Node
+	{
+		float minimum[3];
+		float maximum[3];
+		int first;			// First triangle of a leaf, or the second child of an inner node
+		int count;			// Triangles of a leaf, 0 for an inner node
+	};
+
+	int buildNode(int start, int end, std::vector<float>& boxes);		// boxes holds each triangle's bounds, reordered with it
+	static void transformBox(const float* m, const float* minimum, const float* maximum, float* outMinimum, float* outMaximum);
+	static bool triangleTouchesBox(const float* a, const float* b, const float* c, const float* minimum, const float* maximum);
+
+	std::vector<Node> nodes;
+	std::vector<float> triangles;		// Three positions each, in leaf order
+	double buildTime;
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Four pixels are shaded at once with SSE2 where the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+const float OcclusionCuller::nearClipW = 0.1f;
+
+// Box corner i has x = max if bit 0 is set, y = max if bit 1 is set and z = max if bit 2 is set.
+// Faces are listed counter clockwise as seen from outside of the box.
+static const int boxFaces[6][4] =
+{
+	{ 0, 4, 6, 2 },		// -X
+	{ 5, 1, 3, 7 },		// +X
+	{ 0, 1, 5, 4 },		// -Y
+	{ 6, 7, 3, 2 },		// +Y
+	{ 1, 0, 2, 3 },		// -Z
+	{ 4, 5, 7, 6 }		// +Z
+};
+
+
+OcclusionCuller::OcclusionCuller(JobSystem& jobSystem, int width, int height)
+	: jobSystem(jobSystem), occluderCount(0), rasteriseMs(0.0), testMs(0.0),
+	testedCount(0), frustumCulledCount(0), occludedCount(0)
+{
+	// Round Size up to Whole Tiles
+	this->width = ((width + tileSize - 1) / tileSize) * tileSize;
+	this->height = ((height + tileSize - 1) / tileSize) * tileSize;
+	stride = this->width;
+	tilesX = this->width / tileSize;
+	tilesY = this->height / tileSize;
+
+	depth.resize(stride * this->height, 1.0f);
+	tileDepth.resize(tilesX * tilesY, 1.0f);
+
+	for (int i = 0; i < 16; i++)
+		viewProjection[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+
+void OcclusionCuller::beginFrame(Matrix4x4 viewProjection)
+{
+	float* values = viewProjection.getPtr();
+	for (int i = 0; i < 16; i++)
+		this->viewProjection[i] = values[i];
+
+	triangles.clear();
+	occluderCount = 0;
+	rasteriseMs = 0.0;
+	testedCount = 0;
+	frustumCulledCount = 0;
+	occludedCount = 0;
+	testMs = 0.0;
+}
+
+
+void OcclusionCuller::transformCorners(Vector3f min, Vector3f max, ClipVertex corners[8])
+{
+	const float* m = viewProjection;
+	for (int i = 0; i < 8; i++)
+	{
+		float x = (i & 1) ? max.x : min.x;
+		float y = (i & 2) ? max.y : min.y;
+		float z = (i & 4) ? max.z : min.z;
+
+		corners[i].x = m[0] * x + m[4] * y + m[8] * z + m[12];
+		corners[i].y = m[1] * x + m[5] * y + m[9] * z + m[13];
+		corners[i].z = m[2] * x + m[6] * y + m[10] * z + m[14];
+		corners[i].w = m[3] * x + m[7] * y + m[11] * z + m[15];
+	}
+}
+
+
+void OcclusionCuller::addOccluder(Vector3f min, Vector3f max)
+{
+	ClipVertex corners[8];
+	transformCorners(min, max, corners);
+
+	// Reject Boxes Entirely Outside of one Frustum Plane
+	int outside[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 8; i++)
+	{
+		const ClipVertex& c = corners[i];
+		if (c.x > c.w) outside[0]++;
+		if (c.x < -c.w) outside[1]++;
+		if (c.y > c.w) outside[2]++;
+		if (c.y < -c.w) outside[3]++;
+		if (c.z > c.w) outside[4]++;
+		if (c.w < nearClipW) outside[5]++;
+	}
+	for (int plane = 0; plane < 6; plane++)
+		if (outside[plane] == 8)
+			return;
+
+	occluderCount++;
+	for (int face = 0; face < 6; face++)
+	{
+		const int* f = boxFaces[face];
+		addClippedTriangle(corners[f[0]], corners[f[1]], corners[f[2]]);
+		addClippedTriangle(corners[f[0]], corners[f[2]], corners[f[3]]);
+	}
+}
+
+// Clips a triangle against the near plane, giving at most a quad, then adds it in screen space
+void OcclusionCuller::addClippedTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c)
+{
+	const ClipVertex* input[3] = { &a, &b, &c };
+	ClipVertex output[4];
+	int outputCount = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const ClipVertex& current = *input[i];
+		const ClipVertex& next = *input[(i + 1) % 3];
+		bool currentInside = current.w >= nearClipW;
+		bool nextInside = next.w >= nearClipW;
+
+		if (currentInside)
+			output[outputCount++] = current;
+
+		if (currentInside != nextInside)
+		{
+			float t = (nearClipW - current.w) / (next.w - current.w);
+			ClipVertex v;
+			v.x = current.x + (next.x - current.x) * t;
+			v.y = current.y + (next.y - current.y) * t;
+			v.z = current.z + (next.z - current.z) * t;
+			v.w = nearClipW;
+			output[outputCount++] = v;
+		}
+	}
+
+	if (outputCount < 3)
+		return;
+
+	ClipVertex fan[3];
+	for (int i = 1; i + 1 < outputCount; i++)
+	{
+		fan[0] = output[0];
+		fan[1] = output[i];
+		fan[2] = output[i + 1];
+		addScreenTriangle(fan);
+	}
+}
+
+
+void OcclusionCuller::addScreenTriangle(const ClipVertex* vertices)
+{
+	Triangle triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		float invW = 1.0f / vertices[i].w;
+		triangle.x[i] = (vertices[i].x * invW * 0.5f + 0.5f) * width;
+		triangle.y[i] = (vertices[i].y * invW * 0.5f + 0.5f) * height;
+		triangle.z[i] = vertices[i].z * invW;
+	}
+
+	// Back Facing or Degenerate
+	float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+		(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+	if (area <= 0.0f)
+		return;
+
+	float minY = std::min(triangle.y[0], std::min(triangle.y[1], triangle.y[2]));
+	float maxY = std::max(triangle.y[0], std::max(triangle.y[1], triangle.y[2]));
+	float minX = std::min(triangle.x[0], std::min(triangle.x[1], triangle.x[2]));
+	float maxX = std::max(triangle.x[0], std::max(triangle.x[1], triangle.x[2]));
+	if (maxY < 0.0f || minY >= height || maxX < 0.0f || minX >= width)
+		return;
+
+	triangle.minY = std::max(0, (int)floor(minY));
+	triangle.maxY = std::min(height - 1, (int)ceil(maxY));
+	triangles.push_back(triangle);
+}
+
+
+void OcclusionCuller::rasterise()
+{
+	double started = Profiler::now();
+
+	// Each Band of Tile Rows is Cleared, Drawn and Reduced by one Thread
+	jobSystem.parallelFor(tilesY, [this](int tileRowBegin, int tileRowEnd)
+	{
+		int bandMinY = tileRowBegin * tileSize;
+		int bandMaxY = tileRowEnd * tileSize - 1;
+
+		std::fill(depth.begin() + bandMinY * stride, depth.begin() + (bandMaxY + 1) * stride, 1.0f);
+
+		for (unsigned int i = 0; i < triangles.size(); i++)
+		{
+			const Triangle& triangle = triangles[i];
+			if (triangle.maxY < bandMinY || triangle.minY > bandMaxY)
+				continue;
+			rasteriseTriangle(triangle, bandMinY, bandMaxY);
+		}
+
+		buildTileDepth(tileRowBegin, tileRowEnd);
+	}, 2);
+
+	rasteriseMs = Profiler::now() - started;
+}
+
+// Edge function rasteriser keeping the nearest depth, clipped to rows [bandMinY, bandMaxY]
+void OcclusionCuller::rasteriseTriangle(const Triangle& t, int bandMinY, int bandMaxY)
+{
+	// Edge Functions E(x, y) = A * x + B * y + C, Positive Inside
+	float edgeA[3], edgeB[3], edgeC[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		edgeA[i] = -(t.y[j] - t.y[i]);
+		edgeB[i] = t.x[j] - t.x[i];
+		edgeC[i] = -edgeA[i] * t.x[i] - edgeB[i] * t.y[i];
+	}
+
+	// Depth Plane z(x, y) = zA * x + zB * y + zC
+	float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+	float dz1 = t.z[1] - t.z[0];
+	float dz2 = t.z[2] - t.z[0];
+	float zA = (dz1 * (t.y[2] - t.y[0]) - dz2 * (t.y[1] - t.y[0])) / area;
+	float zB = (dz2 * (t.x[1] - t.x[0]) - dz1 * (t.x[2] - t.x[0])) / area;
+	float zC = t.z[0] - zA * t.x[0] - zB * t.y[0];
+
+	int minX = std::max(0, (int)floor(std::min(t.x[0], std::min(t.x[1], t.x[2]))));
+	int maxX = std::min(width - 1, (int)ceil(std::max(t.x[0], std::max(t.x[1], t.x[2]))));
+	int minY = std::max(bandMinY, t.minY);
+	int maxY = std::min(bandMaxY, t.maxY);
+	minX &= ~3;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		float py = y + 0.5f;
+		float* row = &depth[y * stride];
+
+		float rowE0 = edgeB[0] * py + edgeC[0];
+		float rowE1 = edgeB[1] * py + edgeC[1];
+		float rowE2 = edgeB[2] * py + edgeC[2];
+		float rowZ = zB * py + zC;
+
+#ifdef OCCLUSION_SSE2
+		const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), px), _mm_set1_ps(rowE0));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), px), _mm_set1_ps(rowE1));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), px), _mm_set1_ps(rowE2));
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(rowZ));
+			__m128 previous = _mm_loadu_ps(row + x);
+			__m128 nearest = _mm_min_ps(previous, z);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+		}
+#else
+		for (int x = minX; x <= maxX; x++)
+		{
+			float px = x + 0.5f;
+			if (edgeA[0] * px + rowE0 < 0.0f || edgeA[1] * px + rowE1 < 0.0f || edgeA[2] * px + rowE2 < 0.0f)
+				continue;
+
+			float z = zA * px + rowZ;
+			if (z < row[x])
+				row[x] = z;
+		}
+#endif
+	}
+}
+
+
+void OcclusionCuller::buildTileDepth(int tileRowBegin, int tileRowEnd)
+{
+	for (int ty = tileRowBegin; ty < tileRowEnd; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			float farthest = -1.0f;
+			for (int y = ty * tileSize; y < (ty + 1) * tileSize; y++)
+			{
+				const float* row = &depth[y * stride + tx * tileSize];
+				for (int x = 0; x < tileSize; x++)
+					farthest = std::max(farthest, row[x]);
+			}
+			tileDepth[ty * tilesX + tx] = farthest;
+		}
+	}
+}
+
+
+bool OcclusionCuller::isVisible(Vector3f min, Vector3f max)
+{
+	testedCount.fetch_add(1, std::memory_order_relaxed);
+
+	ClipVertex corners[8];
+	transformCorners(min, max, corners);
+
+	bool visible = true;
+	bool crossesNearPlane = false;
+	float minX = 1e30f, minY = 1e30f, minZ = 1e30f;
+	float maxX = -1e30f, maxY = -1e30f;
+
+	for (int i = 0; i < 8 && !crossesNearPlane; i++)
+	{
+		if (corners[i].w < nearClipW)
+		{
+			crossesNearPlane = true;
+			break;
+		}
+		float invW = 1.0f / corners[i].w;
+		float x = corners[i].x * invW;
+		float y = corners[i].y * invW;
+		float z = corners[i].z * invW;
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		minZ = std::min(minZ, z);
+	}
+
+	if (crossesNearPlane)
+	{
+		// Box Reaches the Camera, Treat as Visible unless Wholly Behind it
+		int behind = 0;
+		for (int i = 0; i < 8; i++)
+			if (corners[i].w < nearClipW)
+				behind++;
+		if (behind == 8)
+		{
+			visible = false;
+			frustumCulledCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	else if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || minZ > 1.0f)
+	{
+		visible = false;
+		frustumCulledCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		// Screen Rectangle Covered by the Box
+		int x0 = std::max(0, (int)floor((minX * 0.5f + 0.5f) * width));
+		int x1 = std::min(width - 1, (int)floor((maxX * 0.5f + 0.5f) * width));
+		int y0 = std::max(0, (int)floor((minY * 0.5f + 0.5f) * height));
+		int y1 = std::min(height - 1, (int)floor((maxY * 0.5f + 0.5f) * height));
+
+		// Coarse Test per Tile, Fine Test per Pixel only where a Tile is Inconclusive
+		visible = false;
+		for (int ty = y0 / tileSize; ty <= y1 / tileSize && !visible; ty++)
+		{
+			for (int tx = x0 / tileSize; tx <= x1 / tileSize && !visible; tx++)
+			{
+				if (minZ > tileDepth[ty * tilesX + tx])
+					continue;
+
+				int py0 = std::max(y0, ty * tileSize), py1 = std::min(y1, (ty + 1) * tileSize - 1);
+				int px0 = std::max(x0, tx * tileSize), px1 = std::min(x1, (tx + 1) * tileSize - 1);
+				for (int y = py0; y <= py1 && !visible; y++)
+					for (int x = px0; x <= px1; x++)
+						if (minZ <= depth[y * stride + x])
+						{
+							visible = true;
+							break;
+						}
+			}
+		}
+
+		if (!visible)
+			occludedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return visible;
+}
+
+
+OcclusionCuller::Stats OcclusionCuller::getStats()
+{
+	Stats stats;
+	stats.occluders = occluderCount;
+	stats.triangles = (int)triangles.size();
+	stats.tested = testedCount;
+	stats.frustumCulled = frustumCulledCount;
+	stats.occluded = occludedCount;
+	stats.rasteriseMs = rasteriseMs;
+	stats.testMs = testMs;
+	return stats;
+}
+
+
+void OcclusionCuller::reportStats()
+{
+	Stats stats = getStats();
+	Profiler::addCounter("Occlusion Occluders", stats.occluders);
+	Profiler::addCounter("Occlusion Triangles", stats.triangles);
+	Profiler::addCounter("Occlusion Tested", stats.tested);
+	Profiler::addCounter("Occlusion Frustum Culled", stats.frustumCulled);
+	Profiler::addCounter("Occlusion Occluded", stats.occluded);
+	Profiler::addTime("Occlusion Rasterise", stats.rasteriseMs);
+	Profiler::addTime("Occlusion Test", stats.testMs);
+}
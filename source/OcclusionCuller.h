@@ -0,0 +1,91 @@
+#ifndef OCCLUSIONCULLER_H_
+#define OCCLUSIONCULLER_H_
+
+#include <atomic>
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "JobSystem.h"
+
+/*
+ * Software Occlusion Culling
+ * Box occluders are rasterised on the CPU into a small depth buffer each frame, a hierarchical
+ * max-depth buffer is built over 8x8 pixel tiles and object bounds are tested against it
+ * before being submitted to OpenGL. Uses no OpenGL so it can run headless.
+ */
+class OcclusionCuller {
+public:
+	OcclusionCuller(JobSystem& jobSystem, int width = 256, int height = 256);
+	~OcclusionCuller(){};
+
+	// Statistics for the Current Frame
+	struct Stats
+	{
+		int occluders;			// Boxes added as occluders
+		int triangles;			// Triangles rasterised after near plane clipping
+		int tested;				// Bounds tested
+		int frustumCulled;		// Bounds outside of the view frustum
+		int occluded;			// Bounds hidden behind occluders
+		double rasteriseMs;		// Time spent drawing occluders and building hierarchical depth
+		double testMs;			// Time the caller spent testing bounds
+	};
+
+	void beginFrame(Matrix4x4 viewProjection);		// Clears occluders for a new view
+	void addOccluder(Vector3f min, Vector3f max);	// Adds a solid box as an occluder
+	void rasterise();								// Draws occluders into the depth buffer as jobs
+
+	bool isVisible(Vector3f min, Vector3f max);		// Tests a box against the depth buffer, safe to call from many threads
+	void addTestTime(double ms) { testMs += ms; }	// Timed by the caller over a batch of tests, as a clock read per test costs more than the test
+
+	Stats getStats();
+	void reportStats();								// Adds this frame's stats to the Profiler
+
+	float depthAt(int x, int y) const { return depth[y * stride + x]; }	// NDC depth of nearest occluder
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	static const int tileSize = 8;		// Hierarchical depth tile size in pixels
+	static const float nearClipW;		// Clip space w of the near clipping plane
+
+private:
+	// Clip Space Vertex
+	struct ClipVertex
+	{
+		float x, y, z, w;
+	};
+
+	// Screen Space Triangle, Counter Clockwise
+	struct Triangle
+	{
+		float x[3], y[3], z[3];
+		int minY, maxY;
+	};
+
+	void transformCorners(Vector3f min, Vector3f max, ClipVertex corners[8]);
+	void addClippedTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c);
+	void addScreenTriangle(const ClipVertex* vertices);
+	void rasteriseTriangle(const Triangle& triangle, int bandMinY, int bandMaxY);
+	void buildTileDepth(int tileRowBegin, int tileRowEnd);
+
+	JobSystem& jobSystem;
+
+	int width, height;			// Depth buffer size, multiples of tileSize
+	int stride;					// Floats per depth buffer row
+	int tilesX, tilesY;
+
+	float viewProjection[16];	// Column major, as Matrix4x4
+
+	std::vector<float> depth;		// Nearest occluder depth per pixel
+	std::vector<float> tileDepth;	// Farthest occluder depth per tile
+	std::vector<Triangle> triangles;
+
+	int occluderCount;
+	double rasteriseMs;
+	double testMs;
+	std::atomic<int> testedCount;
+	std::atomic<int> frustumCulledCount;
+	std::atomic<int> occludedCount;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "PostProcess.h"
+#include "Shader.h"
+#include "GLState.h"
+
+
+PostProcess::PostProcess() : shaderProgramID(0), vertexBuffer(0), positionAttribute(-1)
+{
+}
+
+
+PostProcess::~PostProcess()
+{
+}
+
+
+bool PostProcess::init()
+{
+	shaderProgramID = Shader::LoadFromFile("shaders/post.vert", "shaders/post.frag");
+	if (shaderProgramID == 0)
+		return false;
+
+	positionAttribute = glGetAttribLocation(shaderProgramID, "aPosition");
+
+	ModeUniformLocation = glGetUniformLocation(shaderProgramID, "Mode_uniform");
+	SourceUniformLocation = glGetUniformLocation(shaderProgramID, "Source_uniform");
+	BloomUniformLocation = glGetUniformLocation(shaderProgramID, "Bloom_uniform");
+	TexelStepUniformLocation = glGetUniformLocation(shaderProgramID, "TexelStep_uniform");
+	ThresholdUniformLocation = glGetUniformLocation(shaderProgramID, "Threshold_uniform");
+	IntensityUniformLocation = glGetUniformLocation(shaderProgramID, "Intensity_uniform");
+
+	// One Triangle Covering the Screen, Clipped to It
+	GLfloat vertices[] = { -1.0, -1.0, 3.0, -1.0, -1.0, 3.0 };
+	glGenBuffers(1, &vertexBuffer);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	return true;
+}
+
+
+void PostProcess::brightPass(GLuint source, float threshold)
+{
+	GLState::useProgram(shaderProgramID);
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, source);
+	GLState::uniform1i(SourceUniformLocation, 0);
+	GLState::uniform1f(ThresholdUniformLocation, threshold);
+	draw(0);
+}
+
+
+void PostProcess::blur(GLuint source, float stepX, float stepY)
+{
+	GLState::useProgram(shaderProgramID);
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, source);
+	GLState::uniform1i(SourceUniformLocation, 0);
+	GLState::uniform2f(TexelStepUniformLocation, stepX, stepY);
+	draw(1);
+}
+
+
+void PostProcess::composite(GLuint scene, GLuint bloom, float intensity)
+{
+	GLState::useProgram(shaderProgramID);
+	GLState::activeTexture(GL_TEXTURE4);
+	GLState::bindTexture(GL_TEXTURE_2D, bloom);
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, scene);
+	GLState::uniform1i(SourceUniformLocation, 0);
+	GLState::uniform1i(BloomUniformLocation, 4);
+	GLState::uniform1f(IntensityUniformLocation, intensity);
+	draw(2);
+}
+
+
+void PostProcess::draw(int mode)
+{
+	GLState::uniform1i(ModeUniformLocation, mode);
+	GLState::disable(GL_DEPTH_TEST);
+
+	GLState::useVertexAttribArrays(1u << positionAttribute);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLState::vertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	GLState::enable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,38 @@
+#ifndef POSTPROCESS_H_
+#define POSTPROCESS_H_
+
+#include <GL/glew.h>
+
+/*
+ * Full Screen Passes for Bloom
+ * Each pass draws one triangle covering the bound target, sampling the given textures: a bright
+ * pass keeping what is above a threshold, a separable Gaussian blur run once per axis, and a
+ * composite adding the blurred highlights back onto the scene. Targets are owned by the caller.
+ */
+class PostProcess {
+public:
+	PostProcess();
+	~PostProcess();
+
+	bool init();		// Loads the post shader - needs a current GL context
+
+	void brightPass(GLuint source, float threshold);
+	void blur(GLuint source, float stepX, float stepY);		// Step is one source texel along the blur axis
+	void composite(GLuint scene, GLuint bloom, float intensity);
+
+private:
+	void draw(int mode);
+
+	GLuint shaderProgramID;
+	GLuint vertexBuffer;
+	GLint positionAttribute;
+
+	GLint ModeUniformLocation;
+	GLint SourceUniformLocation;
+	GLint BloomUniformLocation;
+	GLint TexelStepUniformLocation;
+	GLint ThresholdUniformLocation;
+	GLint IntensityUniformLocation;
+};
+
+#endif
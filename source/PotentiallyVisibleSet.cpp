@@ -0,0 +1,283 @@
+#include "PotentiallyVisibleSet.h"
+#include "GridRay.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <string.h>
+
+
+const float PotentiallyVisibleSet::cellSize = 30.0;
+const float PotentiallyVisibleSet::viewLow = 20.0;
+const float PotentiallyVisibleSet::viewHigh = 60.0;
+
+static const char fileMagic[4] = { 'P', 'V', 'S', '1' };
+
+
+PotentiallyVisibleSet::PotentiallyVisibleSet(JobSystem& jobSystem)
+	: jobSystem(jobSystem), width(0), depth(0), mapHash(0), chunkSize(1), chunksX(0), chunksZ(0), viewDistance(0.0),
+	viewCell(-1), cellCount(0), averageVisible(0.0), buildTime(0.0)
+{
+}
+
+
+void PotentiallyVisibleSet::setGrid(const LevelGrid& map, int chunkSize, float viewDistance)
+{
+	width = map.getWidth();
+	depth = map.getDepth();
+
+	solid.resize(width * depth);
+	for (int i = 0; i < solid.size(); i++)
+		solid[i] = map.getCells()[i] != 0 ? 1 : 0;
+
+	this->chunkSize = chunkSize;
+	this->viewDistance = viewDistance;
+	chunksX = (width + chunkSize - 1) / chunkSize;
+	chunksZ = (depth + chunkSize - 1) / chunkSize;
+	viewCell = -1;
+	visible.assign(chunksX * chunksZ, 1);
+
+	// FNV-1a over Everything the Sets Depend on
+	unsigned int distanceBits;
+	memcpy(&distanceBits, &viewDistance, sizeof(distanceBits));
+	int header[4] = { width, depth, chunkSize, (int)distanceBits };
+	mapHash = 14695981039346656037ull;
+	for (int i = 0; i < sizeof(header); i++)
+		mapHash = (mapHash ^ ((unsigned char*)header)[i]) * 1099511628211ull;
+	for (int i = 0; i < solid.size(); i++)
+		mapHash = (mapHash ^ solid[i]) * 1099511628211ull;
+}
+
+
+void PotentiallyVisibleSet::build(const LevelGrid& map, int chunkSize, float viewDistance)
+{
+	double started = Profiler::now();
+	setGrid(map, chunkSize, viewDistance);
+
+	// Each Row of Cells is Encoded on its Own, then the Rows are Joined
+	std::vector<std::vector<unsigned char>> rowRuns(depth);
+	std::vector<std::vector<unsigned int>> rowSizes(depth);
+	std::vector<long long> rowVisible(depth, 0);
+
+	float half = cellSize * 0.5f;
+	jobSystem.parallelFor(depth, [&](int begin, int end)
+	{
+		std::vector<unsigned char> bits(chunksX * chunksZ);
+		for (int z = begin; z < end; z++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				if (!solid[z * width + x])
+				{
+					rowSizes[z].push_back(0);
+					continue;
+				}
+
+				std::fill(bits.begin(), bits.end(), 0);
+				for (int chunkZ = 0; chunkZ < chunksZ; chunkZ++) {
+					for (int chunkX = 0; chunkX < chunksX; chunkX++) {
+						// Chunks Further than the View Distance from the Whole Cell are Never Seen
+						float gapX = std::max(0.0f, std::max(chunkX * chunkSize * cellSize - half - (x * cellSize + half), x * cellSize - half - ((chunkX + 1) * chunkSize * cellSize - half)));
+						float gapZ = std::max(0.0f, std::max(chunkZ * chunkSize * cellSize - half - (z * cellSize + half), z * cellSize - half - ((chunkZ + 1) * chunkSize * cellSize - half)));
+						if (gapX * gapX + gapZ * gapZ > viewDistance * viewDistance)
+							continue;
+
+						bool seen = false;
+						for (int tz = chunkZ * chunkSize; tz < (chunkZ + 1) * chunkSize && tz < depth && !seen; tz++)
+							for (int tx = chunkX * chunkSize; tx < (chunkX + 1) * chunkSize && tx < width && !seen; tx++)
+								seen = solid[tz * width + tx] && isVisible(x, z, tx, tz);
+						if (seen)
+						{
+							bits[chunkZ * chunksX + chunkX] = 1;
+							rowVisible[z]++;
+						}
+					}
+				}
+
+				size_t before = rowRuns[z].size();
+				encode(bits, rowRuns[z]);
+				rowSizes[z].push_back((unsigned int)(rowRuns[z].size() - before));
+			}
+		}
+	});
+
+	// Join the Rows
+	offsets.assign(width * depth + 1, 0);
+	runs.clear();
+	cellCount = 0;
+	long long totalVisible = 0;
+	for (int z = 0; z < depth; z++)
+	{
+		runs.insert(runs.end(), rowRuns[z].begin(), rowRuns[z].end());
+		for (int x = 0; x < width; x++)
+		{
+			offsets[z * width + x + 1] = offsets[z * width + x] + rowSizes[z][x];
+			if (solid[z * width + x])
+				cellCount++;
+		}
+		totalVisible += rowVisible[z];
+	}
+	averageVisible = cellCount > 0 ? (double)totalVisible / cellCount : 0.0;
+	buildTime = Profiler::now() - started;
+}
+
+
+/* Is any point on top of the target cell in sight of any point over the viewing cell */
+bool PotentiallyVisibleSet::isVisible(int fromX, int fromZ, int toX, int toZ) const
+{
+	static const float corners[5][2] = { { 0, 0 }, { -0.9f, -0.9f }, { 0.9f, -0.9f }, { -0.9f, 0.9f }, { 0.9f, 0.9f } };
+	float half = cellSize * 0.5f;
+
+	for (int v = 0; v < 10; v++)
+	{
+		Vector3f eye(fromX * cellSize + corners[v % 5][0] * half, v < 5 ? viewLow : viewHigh, fromZ * cellSize + corners[v % 5][1] * half);
+		for (int t = 0; t < 5; t++)
+		{
+			Vector3f target(toX * cellSize + corners[t][0] * half, half + 0.01f, toZ * cellSize + corners[t][1] * half);
+			Vector3f toTarget = target - eye;
+			float distance = toTarget.length();
+			if (distance > viewDistance)
+				continue;
+			if (distance <= 0.0 || !GridRay::isBlocked(solid, width, depth, cellSize, -half, half, eye, toTarget / distance, distance - 0.02f))
+				return true;
+		}
+	}
+	return false;
+}
+
+
+void PotentiallyVisibleSet::encode(const std::vector<unsigned char>& bits, std::vector<unsigned char>& out)
+{
+	unsigned char current = 0;
+	unsigned int run = 0;
+	for (int i = 0; i <= bits.size(); i++)
+	{
+		if (i < bits.size() && bits[i] == current)
+		{
+			run++;
+			continue;
+		}
+
+		// End of a Run, Written Seven Bits at a Time
+		while (run >= 0x80)
+		{
+			out.push_back((unsigned char)(run & 0x7F) | 0x80);
+			run >>= 7;
+		}
+		out.push_back((unsigned char)run);
+
+		current ^= 1;
+		run = 1;
+	}
+}
+
+
+void PotentiallyVisibleSet::decode(int cell, std::vector<unsigned char>& bits) const
+{
+	std::fill(bits.begin(), bits.end(), 0);
+
+	unsigned int position = offsets[cell];
+	int index = 0;
+	unsigned char value = 0;
+	while (position < offsets[cell + 1])
+	{
+		unsigned int run = 0;
+		int shift = 0;
+		unsigned char byte;
+		do
+		{
+			byte = runs[position++];
+			run |= (unsigned int)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+
+		if (value)
+			std::fill(bits.begin() + index, bits.begin() + std::min(index + (int)run, (int)bits.size()), 1);
+		index += run;
+		value ^= 1;
+	}
+}
+
+
+bool PotentiallyVisibleSet::setView(Vector3f camera)
+{
+	int x = (int)floorf((camera.x + cellSize * 0.5f) / cellSize);
+	int z = (int)floorf((camera.z + cellSize * 0.5f) / cellSize);
+	bool covered = !offsets.empty() && x >= 0 && x < width && z >= 0 && z < depth && solid[z * width + x] &&
+		camera.y >= viewLow && camera.y <= viewHigh;
+	if (!covered)
+	{
+		viewCell = -1;
+		return false;
+	}
+
+	int cell = z * width + x;
+	if (cell != viewCell)
+	{
+		decode(cell, visible);
+		viewCell = cell;
+	}
+	return true;
+}
+
+
+bool PotentiallyVisibleSet::save(const std::string& filename) const
+{
+	std::ofstream output(filename.c_str(), std::ios::binary);
+	if (!output)
+		return false;
+
+	unsigned int offsetCount = (unsigned int)offsets.size();
+	unsigned int runBytes = (unsigned int)runs.size();
+	output.write(fileMagic, sizeof(fileMagic));
+	output.write((const char*)&mapHash, sizeof(mapHash));
+	output.write((const char*)&cellCount, sizeof(cellCount));
+	output.write((const char*)&averageVisible, sizeof(averageVisible));
+	output.write((const char*)&offsetCount, sizeof(offsetCount));
+	output.write((const char*)&runBytes, sizeof(runBytes));
+	output.write((const char*)&offsets[0], offsetCount * sizeof(unsigned int));
+	if (runBytes > 0)
+		output.write((const char*)&runs[0], runBytes);
+	return (bool)output;
+}
+
+
+bool PotentiallyVisibleSet::load(const std::string& filename, const LevelGrid& map, int chunkSize, float viewDistance)
+{
+	double started = Profiler::now();
+	setGrid(map, chunkSize, viewDistance);
+	offsets.clear();
+	runs.clear();
+
+	std::ifstream input(filename.c_str(), std::ios::binary);
+	if (!input)
+		return false;
+
+	char magic[4];
+	unsigned long long hash;
+	unsigned int offsetCount, runBytes;
+	input.read(magic, sizeof(magic));
+	input.read((char*)&hash, sizeof(hash));
+	input.read((char*)&cellCount, sizeof(cellCount));
+	input.read((char*)&averageVisible, sizeof(averageVisible));
+	input.read((char*)&offsetCount, sizeof(offsetCount));
+	input.read((char*)&runBytes, sizeof(runBytes));
+	if (!input || memcmp(magic, fileMagic, sizeof(magic)) != 0 || hash != mapHash || offsetCount != width * depth + 1)
+		return false;
+
+	offsets.resize(offsetCount);
+	runs.resize(runBytes);
+	input.read((char*)&offsets[0], offsetCount * sizeof(unsigned int));
+	if (runBytes > 0)
+		input.read((char*)&runs[0], runBytes);
+	if (!input || offsets.back() != runBytes)
+	{
+		offsets.clear();
+		runs.clear();
+		return false;
+	}
+
+	buildTime = Profiler::now() - started;
+	return true;
+}
@@ -0,0 +1,71 @@
+#ifndef POTENTIALLYVISIBLESET_H_
+#define POTENTIALLYVISIBLESET_H_
+
+#include <string>
+#include <vector>
+
+#include "Vector.h"
+#include "JobSystem.h"
+#include "LevelGrid.h"
+
+/*
+ * Chunks of the Maze that can be Seen from Each Walkable Cell
+ * For every wall cell the tank can stand on, rays are cast through the grid from points over
+ * the cell, at the heights the camera reaches, to the tops of the cells in each chunk within
+ * the view distance. A chunk is in the cell's set once any ray reaches it. The sets are kept as
+ * run lengths of hidden and visible chunks, built as jobs and saved next to the
+ * level, so later runs only load them. At runtime the set of the cell under the camera rejects
+ * whole chunks before they are frustum or occlusion tested.
+ */
+class PotentiallyVisibleSet {
+public:
+	PotentiallyVisibleSet(JobSystem& jobSystem);
+	~PotentiallyVisibleSet(){};
+
+	void build(const LevelGrid& map, int chunkSize, float viewDistance);
+	bool load(const std::string& filename, const LevelGrid& map, int chunkSize, float viewDistance);	// false if missing or made for another map
+	bool save(const std::string& filename) const;
+
+	// Runtime - false when the camera is not over a walkable cell, leaving every chunk visible
+	bool setView(Vector3f camera);
+	bool isChunkVisible(int chunkX, int chunkZ) const { return viewCell < 0 || visible[chunkZ * chunksX + chunkX] != 0; }
+
+	// Statistics
+	double getBuildTime() const { return buildTime; }
+	int getCellCount() const { return cellCount; }					// Walkable cells with a set
+	int getChunkCount() const { return chunksX * chunksZ; }
+	double getAverageVisible() const { return averageVisible; }		// Chunks in the average set
+	long long getBytes() const { return (long long)(offsets.size() * sizeof(unsigned int) + runs.size()); }
+	long long getBitsetBytes() const { return (long long)cellCount * ((chunksX * chunksZ + 7) / 8); }	// As plain bitsets
+
+	static const float cellSize;
+	static const float viewLow;			// Heights over which the camera is covered
+	static const float viewHigh;
+
+private:
+	bool isVisible(int fromX, int fromZ, int toX, int toZ) const;
+	static void encode(const std::vector<unsigned char>& bits, std::vector<unsigned char>& out);
+	void decode(int cell, std::vector<unsigned char>& bits) const;
+	void setGrid(const LevelGrid& map, int chunkSize, float viewDistance);
+
+	JobSystem& jobSystem;
+
+	int width, depth;
+	std::vector<unsigned char> solid;		// Wall per cell, x fastest
+	unsigned long long mapHash;				// Of the walls, the chunk size and the view distance
+	int chunkSize;
+	int chunksX, chunksZ;
+	float viewDistance;
+
+	std::vector<unsigned int> offsets;		// Start of each cell's runs, one more than there are cells
+	std::vector<unsigned char> runs;		// Run lengths as 7 bit varints, hidden first, then alternating
+
+	int viewCell;							// Cell whose set is decoded, -1 for none
+	std::vector<unsigned char> visible;		// Decoded set, a byte per chunk
+
+	int cellCount;
+	double averageVisible;
+	double buildTime;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "Profiler.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+std::map<std::string, Profiler::Stat> Profiler::stats;
+std::mutex Profiler::statsMutex;
+int Profiler::framesInInterval = 0;
+int Profiler::reportInterval = 300;
+double Profiler::frameStarted = 0.0;
+
+
+double Profiler::now()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+long long Profiler::peakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return (long long)counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return (long long)usage.ru_maxrss * 1024;		// Kilobytes on Linux
+#endif
+}
+
+
+void Profiler::beginFrame()
+{
+	frameStarted = now();
+}
+
+
+void Profiler::endFrame()
+{
+	addTime("Frame", now() - frameStarted);
+
+	std::lock_guard<std::mutex> lock(statsMutex);
+
+	// Fold Frame Totals into the Interval
+	for (std::map<std::string, Stat>::iterator it = stats.begin(); it != stats.end(); ++it)
+	{
+		Stat& stat = it->second;
+		stat.intervalTotal += stat.frameTotal;
+		if (stat.frameTotal > stat.intervalMax)
+			stat.intervalMax = stat.frameTotal;
+		stat.frameTotal = 0.0;
+	}
+
+	framesInInterval++;
+	if (reportInterval > 0 && framesInInterval >= reportInterval)
+		report();
+}
+
+
+void Profiler::beginSection(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	Stat& stat = stats[name];
+	stat.isTime = true;
+	stat.running = true;
+	stat.started = now();
+}
+
+
+void Profiler::endSection(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	Stat& stat = stats[name];
+	if (!stat.running)
+		return;
+	stat.frameTotal += now() - stat.started;
+	stat.running = false;
+}
+
+
+void Profiler::addTime(const std::string& name, double milliseconds)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	Stat& stat = stats[name];
+	stat.isTime = true;
+	stat.frameTotal += milliseconds;
+}
+
+
+void Profiler::addCounter(const std::string& name, double value)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	stats[name].frameTotal += value;
+}
+
+
+double Profiler::average(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	std::map<std::string, Stat>::iterator it = stats.find(name);
+	return it != stats.end() ? it->second.lastAverage : 0.0;
+}
+
+// Print Averages over the Interval then Start a New One - statsMutex is held by the caller
+void Profiler::report()
+{
+	std::cout << "Frame Stats (average over " << framesInInterval << " frames)" << "\n";
+
+	for (std::map<std::string, Stat>::iterator it = stats.begin(); it != stats.end(); ++it)
+	{
+		Stat& stat = it->second;
+		stat.lastAverage = stat.intervalTotal / framesInInterval;
+
+		if (stat.isTime)
+			std::cout << "\t " << it->first << ": " << stat.lastAverage << " ms (max " << stat.intervalMax << " ms)" << "\n";
+		else
+			std::cout << "\t " << it->first << ": " << stat.lastAverage << "\n";
+
+		stat.intervalTotal = 0.0;
+		stat.intervalMax = 0.0;
+	}
+	std::cout << std::endl;
+
+	framesInInterval = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+/* Per Frame CPU Timings and Counters, Averaged and Printed every Report Interval */
+class Profiler {
+public:
+	static void beginFrame();
+	static void endFrame();		// Folds this frame into the interval and reports when the interval is full
+
+	static void beginSection(const std::string& name);
+	static void endSection(const std::string& name);
+
+	static void addTime(const std::string& name, double milliseconds);	// Adds an externally measured time
+	static void addCounter(const std::string& name, double value);		// Adds to a per frame counter
+
+	static double average(const std::string& name);		// Average per frame over the last report
+	static double now();								// Milliseconds since the profiler started
+	static long long peakMemory();						// Most bytes the process has held in memory at once
+
+	static void setReportInterval(int frames) { reportInterval = frames; }	// 0 disables reporting
+
+private:
+	// Statistic Accumulated per Frame and per Interval
+	struct Stat
+	{
+		Stat() : isTime(false), running(false), started(0), frameTotal(0), intervalTotal(0), intervalMax(0), lastAverage(0) {};
+
+		bool isTime;
+		bool running;
+		double started;
+		double frameTotal;
+		double intervalTotal;
+		double intervalMax;
+		double lastAverage;
+	};
+
+	static void report();
+
+	static std::map<std::string, Stat> stats;
+	static std::mutex statsMutex;
+	static int framesInInterval;
+	static int reportInterval;
+	static double frameStarted;
+};
+
+/* Times a Section for the Lifetime of the Scope */
+class ProfileScope {
+public:
+	ProfileScope(const std::string& name) : name(name) { Profiler::beginSection(name); };
+	~ProfileScope() { Profiler::endSection(name); };
+
+private:
+	std::string name;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "ProjectilePool.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Four shells are stepped at once with SSE2 where the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PROJECTILE_SSE2 1
+#endif
+
+
+ProjectilePool::ProjectilePool(JobSystem& jobSystem)
+	: jobSystem(jobSystem), capacity(0), highWater(0), liveCount(0), freeCount(0), landingCount(0)
+{
+}
+
+
+void ProjectilePool::setCapacity(int capacity)
+{
+	this->capacity = (std::max(capacity, 0) + 3) & ~3;
+
+	positionX.assign(this->capacity, 0.0f);
+	positionY.assign(this->capacity, 0.0f);
+	positionZ.assign(this->capacity, 0.0f);
+	velocityX.assign(this->capacity, 0.0f);
+	velocityY.assign(this->capacity, 0.0f);
+	velocityZ.assign(this->capacity, 0.0f);
+	lifetime.assign(this->capacity, 0.0f);
+	live.assign(this->capacity, 0);
+	freeSlots.assign(this->capacity, 0);
+	cellX.assign(this->capacity, 0);
+	cellZ.assign(this->capacity, 0);
+	landingX.assign(this->capacity, 0);
+	landingZ.assign(this->capacity, 0);
+	landingValue.assign(this->capacity, 0);
+	clear();
+}
+
+
+void ProjectilePool::clear()
+{
+	std::fill(live.begin(), live.end(), 0);
+	std::fill(velocityX.begin(), velocityX.end(), 0.0f);
+	std::fill(velocityY.begin(), velocityY.end(), 0.0f);
+	std::fill(velocityZ.begin(), velocityZ.end(), 0.0f);
+	highWater = 0;
+	liveCount = 0;
+	freeCount = 0;
+	landingCount = 0;
+}
+
+
+int ProjectilePool::fire(Vector3f position, Vector3f velocity, float lifetime)
+{
+	int slot;
+	if (freeCount > 0)
+		slot = freeSlots[--freeCount];
+	else if (highWater < capacity)
+		slot = highWater++;
+	else
+		return -1;
+
+	positionX[slot] = position.x;
+	positionY[slot] = position.y;
+	positionZ[slot] = position.z;
+	velocityX[slot] = velocity.x;
+	velocityY[slot] = velocity.y;
+	velocityZ[slot] = velocity.z;
+	this->lifetime[slot] = lifetime;
+	live[slot] = 1;
+	liveCount++;
+	return slot;
+}
+
+
+void ProjectilePool::release(int slot)
+{
+	live[slot] = 0;
+	velocityX[slot] = velocityY[slot] = velocityZ[slot] = 0.0f;
+	freeSlots[freeCount++] = slot;
+	liveCount--;
+
+	// Empty Again, so Later Shells Start from the Bottom
+	if (liveCount == 0)
+	{
+		highWater = 0;
+		freeCount = 0;
+	}
+}
+
+
+void ProjectilePool::integrate(float deltaTime, Vector3f gravity)
+{
+	// Free Slots below the High Water Mark are Stepped Too, which Costs Less than Skipping them
+	int groups = ((highWater + 3) & ~3) / 4;
+
+	// Groups of Four Shells are Shared Out as Jobs
+	jobSystem.parallelFor(groups, [&](int firstGroup, int endGroup)
+	{
+		int begin = firstGroup * 4;
+		int end = endGroup * 4;
+#ifdef PROJECTILE_SSE2
+		const __m128 step = _mm_set1_ps(deltaTime);
+		const __m128 gravityX = _mm_set1_ps(gravity.x * deltaTime);
+		const __m128 gravityY = _mm_set1_ps(gravity.y * deltaTime);
+		const __m128 gravityZ = _mm_set1_ps(gravity.z * deltaTime);
+		for (int i = begin; i < end; i += 4)
+		{
+			__m128 vx = _mm_add_ps(_mm_loadu_ps(&velocityX[i]), gravityX);
+			__m128 vy = _mm_add_ps(_mm_loadu_ps(&velocityY[i]), gravityY);
+			__m128 vz = _mm_add_ps(_mm_loadu_ps(&velocityZ[i]), gravityZ);
+			_mm_storeu_ps(&velocityX[i], vx);
+			_mm_storeu_ps(&velocityY[i], vy);
+			_mm_storeu_ps(&velocityZ[i], vz);
+			_mm_storeu_ps(&positionX[i], _mm_add_ps(_mm_loadu_ps(&positionX[i]), _mm_mul_ps(vx, step)));
+			_mm_storeu_ps(&positionY[i], _mm_add_ps(_mm_loadu_ps(&positionY[i]), _mm_mul_ps(vy, step)));
+			_mm_storeu_ps(&positionZ[i], _mm_add_ps(_mm_loadu_ps(&positionZ[i]), _mm_mul_ps(vz, step)));
+			_mm_storeu_ps(&lifetime[i], _mm_sub_ps(_mm_loadu_ps(&lifetime[i]), step));
+		}
+#else
+		for (int i = begin; i < end; i++)
+		{
+			velocityX[i] += gravity.x * deltaTime;
+			velocityY[i] += gravity.y * deltaTime;
+			velocityZ[i] += gravity.z * deltaTime;
+			positionX[i] += velocityX[i] * deltaTime;
+			positionY[i] += velocityY[i] * deltaTime;
+			positionZ[i] += velocityZ[i] * deltaTime;
+			lifetime[i] -= deltaTime;
+		}
+#endif
+	}, groupsPerJob);
+}
+
+
+void ProjectilePool::collide(const GridIndex& grid, float wallTop, float coinTop, float bottom)
+{
+	landingCount = 0;
+	int groups = ((highWater + 3) & ~3) / 4;
+
+	// Cell of Every Shell, -1 or the Map's Size where it is Off the Map, Worked Out in Jobs
+	float half = GridIndex::cellSize * 0.5f;
+	float width = (float)grid.getWidth();
+	float depth = (float)grid.getDepth();
+	jobSystem.parallelFor(groups, [&](int firstGroup, int endGroup)
+	{
+		int begin = firstGroup * 4;
+		int end = endGroup * 4;
+#ifdef PROJECTILE_SSE2
+		const __m128 offset = _mm_set1_ps(half);
+		const __m128 scale = _mm_set1_ps(1.0f / GridIndex::cellSize);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 limitX = _mm_set1_ps(width);
+		const __m128 limitZ = _mm_set1_ps(depth);
+		const __m128i oneInt = _mm_set1_epi32(1);
+		for (int i = begin; i < end; i += 4)
+		{
+			// Truncating after Moving Up by One Floors Everything from -1 Up
+			__m128 x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&positionX[i]), offset), scale), minusOne), limitX);
+			__m128 z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&positionZ[i]), offset), scale), minusOne), limitZ);
+			_mm_storeu_si128((__m128i*)&cellX[i], _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(x, one)), oneInt));
+			_mm_storeu_si128((__m128i*)&cellZ[i], _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(z, one)), oneInt));
+		}
+#else
+		for (int i = begin; i < end; i++)
+		{
+			cellX[i] = (int)floorf(std::min(std::max((positionX[i] + half) / GridIndex::cellSize, -1.0f), width));
+			cellZ[i] = (int)floorf(std::min(std::max((positionZ[i] + half) / GridIndex::cellSize, -1.0f), depth));
+		}
+#endif
+	}, groupsPerJob);
+
+	// Land, Drop or Expire the Live Shells, on this Thread so Landings Stay in Slot Order
+	for (int i = 0; i < highWater; i++)
+	{
+		if (!live[i])
+			continue;
+
+		int value = grid.getCell(cellX[i], cellZ[i]);
+		bool landed = value != 0 && positionY[i] < (value == 2 ? coinTop : wallTop);
+		if (landed)
+		{
+			landingX[landingCount] = cellX[i];
+			landingZ[landingCount] = cellZ[i];
+			landingValue[landingCount] = value;
+			landingCount++;
+		}
+		if (landed || positionY[i] < bottom || lifetime[i] <= 0.0f)
+			release(i);
+	}
+}
+
+
+void ProjectilePool::getPositions(std::vector<Vector3f>& positions) const
+{
+	positions.clear();
+	for (int i = 0; i < highWater; i++)
+		if (live[i])
+			positions.push_back(Vector3f(positionX[i], positionY[i], positionZ[i]));
+}
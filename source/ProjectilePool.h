@@ -0,0 +1,64 @@
+#ifndef PROJECTILEPOOL_H_
+#define PROJECTILEPOOL_H_
+
+#include <vector>
+
+#include "Vector.h"
+#include "GridIndex.h"
+#include "JobSystem.h"
+
+/*
+ * Shells in Flight, Kept in a Fixed Pool
+ * Each field of every shell is its own array, so a step walks straight through memory, four
+ * shells at a time with SSE2 where the compiler targets it. Slots are handed out from a free
+ * list and go back to it when a shell lands, falls or runs out of time, and nothing is allocated
+ * after the capacity is set. Collisions are found for all the shells at once: their cells are
+ * worked out in bulk, then a shell over a wall lower than its top lands there. Landings are kept
+ * for the game to read until the next collision pass. Stepping and finding cells are split into
+ * jobs of a few thousand shells.
+ */
+class ProjectilePool {
+public:
+	ProjectilePool(JobSystem& jobSystem);
+	~ProjectilePool(){};
+
+	void setCapacity(int capacity);		// Allocates the pool and clears it
+	void clear();
+
+	int fire(Vector3f position, Vector3f velocity, float lifetime);	// Slot of the new shell, -1 when the pool is full
+	void integrate(float deltaTime, Vector3f gravity);					// Units per millisecond
+	void collide(const GridIndex& grid, float wallTop, float coinTop, float bottom);	// Lands shells on cells lower than them, coins are cells of 2
+
+	// Cells Shells Landed on in the Last Collision Pass
+	int getLandingCount() const { return landingCount; }
+	void getLanding(int landing, int& x, int& z, int& value) const { x = landingX[landing]; z = landingZ[landing]; value = landingValue[landing]; }
+
+	void getPositions(std::vector<Vector3f>& positions) const;		// Live shells in slot order
+	int getLiveCount() const { return liveCount; }
+	int getCapacity() const { return capacity; }
+
+	static const int groupsPerJob = 1024;		// Of four shells
+
+private:
+	void release(int slot);
+
+	JobSystem& jobSystem;
+
+	int capacity;			// Rounded up to whole groups of four
+	int highWater;			// One past the highest slot in use since the pool was last empty
+	int liveCount;
+
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<float> lifetime;			// Milliseconds left
+	std::vector<unsigned char> live;
+
+	std::vector<int> freeSlots;				// Released slots below the high water mark, used as a stack
+	int freeCount;
+
+	std::vector<int> cellX, cellZ;			// Per slot scratch for the collision pass
+	std::vector<int> landingX, landingZ, landingValue;
+	int landingCount;
+};
+
+#endif
@@ -0,0 +1,402 @@
+#include "RenderGraph.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+
+#include <iostream>
+#include <set>
+
+
+RenderGraph::RenderGraph() : culledCount(0), requestedBytes(0), allocatedBytes(0)
+{
+}
+
+
+RenderGraph::~RenderGraph()
+{
+	// GL objects belong to the context, which is gone by the time globals are destroyed
+}
+
+
+void RenderGraph::reset()
+{
+	passes.clear();
+	resources.clear();
+	versions.clear();
+	order.clear();
+	culledCount = 0;
+	requestedBytes = 0;
+	allocatedBytes = 0;
+}
+
+
+int RenderGraph::createTexture(const std::string& name, const TextureDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resource.imported = false;
+	resource.framebuffer = 0;
+	resource.physical = -1;
+	resources.push_back(resource);
+
+	Version version;
+	version.resource = (int)resources.size() - 1;
+	version.writer = -1;
+	version.output = false;
+	versions.push_back(version);
+	return (int)versions.size() - 1;
+}
+
+
+int RenderGraph::importFramebuffer(const std::string& name, GLuint framebuffer, int width, int height)
+{
+	TextureDesc desc = { width, height, GL_RGBA8 };
+	int handle = createTexture(name, desc);
+	resources.back().imported = true;
+	resources.back().framebuffer = framebuffer;
+	return handle;
+}
+
+
+int RenderGraph::addPass(const std::string& name, Execute execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.sideEffect = false;
+	pass.live = false;
+	passes.push_back(pass);
+	return (int)passes.size() - 1;
+}
+
+
+void RenderGraph::read(int pass, int resource)
+{
+	passes[pass].reads.push_back(resource);
+	versions[resource].readers.push_back(pass);
+}
+
+
+int RenderGraph::write(int pass, int resource)
+{
+	// Drawing Keeps what was Already There, so the Previous Version is Read Too
+	if (versions[resource].writer >= 0)
+		read(pass, resource);
+
+	Version version;
+	version.resource = versions[resource].resource;
+	version.writer = pass;
+	version.output = false;
+	versions.push_back(version);
+
+	int handle = (int)versions.size() - 1;
+	passes[pass].writes.push_back(handle);
+	return handle;
+}
+
+
+void RenderGraph::markOutput(int resource)
+{
+	versions[resource].output = true;
+}
+
+
+void RenderGraph::setSideEffect(int pass)
+{
+	passes[pass].sideEffect = true;
+}
+
+
+bool RenderGraph::compile()
+{
+	// Cull: Walk Back from the Outputs, Keeping Only the Passes they Need
+	std::vector<int> pending;
+	for (int i = 0; i < versions.size(); i++)
+		if (versions[i].output)
+			pending.push_back(i);
+	for (int i = 0; i < passes.size(); i++)
+	{
+		passes[i].live = passes[i].sideEffect;
+		if (passes[i].live)
+			pending.insert(pending.end(), passes[i].reads.begin(), passes[i].reads.end());
+	}
+
+	while (!pending.empty())
+	{
+		int writer = versions[pending.back()].writer;
+		pending.pop_back();
+		if (writer < 0 || passes[writer].live)
+			continue;
+		passes[writer].live = true;
+		pending.insert(pending.end(), passes[writer].reads.begin(), passes[writer].reads.end());
+	}
+
+	// Dependencies: Writers before their Readers, Readers before the Next Writer of the Same Resource
+	std::vector<std::vector<int> > dependents(passes.size());
+	std::vector<int> dependencies(passes.size(), 0);
+	for (int p = 0; p < passes.size(); p++)
+	{
+		if (!passes[p].live)
+			continue;
+
+		for (int i = 0; i < passes[p].reads.size(); i++)
+		{
+			int writer = versions[passes[p].reads[i]].writer;
+			if (writer >= 0 && writer != p)
+			{
+				dependents[writer].push_back(p);
+				dependencies[p]++;
+			}
+		}
+
+		for (int i = 0; i < passes[p].writes.size(); i++)
+		{
+			// Earlier Versions of the Same Resource, whose Readers must Finish before it is Overwritten
+			int written = passes[p].writes[i];
+			for (int v = 0; v < written; v++)
+			{
+				if (versions[v].resource != versions[written].resource)
+					continue;
+				for (int r = 0; r < versions[v].readers.size(); r++)
+				{
+					int reader = versions[v].readers[r];
+					if (reader != p && passes[reader].live)
+					{
+						dependents[reader].push_back(p);
+						dependencies[p]++;
+					}
+				}
+			}
+		}
+	}
+
+	// Topological Sort, Ties Broken by Declaration Order so Frames are Repeatable
+	culledCount = 0;
+	std::set<int> ready;
+	for (int p = 0; p < passes.size(); p++)
+	{
+		if (!passes[p].live)
+			culledCount++;
+		else if (dependencies[p] == 0)
+			ready.insert(p);
+	}
+
+	order.clear();
+	while (!ready.empty())
+	{
+		int p = *ready.begin();
+		ready.erase(ready.begin());
+		order.push_back(p);
+		for (int i = 0; i < dependents[p].size(); i++)
+			if (--dependencies[dependents[p][i]] == 0)
+				ready.insert(dependents[p][i]);
+	}
+
+	if (order.size() + culledCount != passes.size())
+	{
+		std::cout << "Render graph has a cycle, nothing drawn" << std::endl;
+		order.clear();
+		return false;
+	}
+
+	// Lifetimes of Each Resource over the Sorted Passes
+	for (int r = 0; r < resources.size(); r++)
+	{
+		resources[r].firstUse = -1;
+		resources[r].lastUse = -1;
+		resources[r].physical = -1;
+	}
+	for (int i = 0; i < order.size(); i++)
+	{
+		const Pass& pass = passes[order[i]];
+		std::vector<int> used = pass.reads;
+		used.insert(used.end(), pass.writes.begin(), pass.writes.end());
+		for (int j = 0; j < used.size(); j++)
+		{
+			Resource& resource = resources[versions[used[j]].resource];
+			if (resource.firstUse < 0)
+				resource.firstUse = i;
+			resource.lastUse = i;
+		}
+	}
+
+	// Alias: Give Each Transient, in Order of First Use, a Pooled Texture Free by Then
+	for (int i = 0; i < pool.size(); i++)
+		pool[i].busyUntil = -1;
+	requestedBytes = 0;
+	allocatedBytes = 0;
+
+	std::vector<bool> used(pool.size(), false);
+	for (int i = 0; i < order.size(); i++)
+	{
+		for (int r = 0; r < resources.size(); r++)
+		{
+			Resource& resource = resources[r];
+			if (resource.imported || resource.firstUse != i)
+				continue;
+
+			requestedBytes += (long long)resource.desc.width * resource.desc.height * bytesPerPixel(resource.desc.format);
+
+			for (int j = 0; j < pool.size() && resource.physical < 0; j++)
+				if (pool[j].busyUntil < i && sameDesc(pool[j].desc, resource.desc))
+					resource.physical = j;
+
+			if (resource.physical < 0)
+			{
+				Physical physical;
+				physical.desc = resource.desc;
+				glGenTextures(1, &physical.texture);
+				GLState::bindTexture(GL_TEXTURE_2D, physical.texture);
+
+				GLenum filter = isDepth(resource.desc.format) ? GL_NEAREST : GL_LINEAR;
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				if (isDepth(resource.desc.format))
+					glTexImage2D(GL_TEXTURE_2D, 0, resource.desc.format, resource.desc.width, resource.desc.height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+				else
+					glTexImage2D(GL_TEXTURE_2D, 0, resource.desc.format, resource.desc.width, resource.desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+				pool.push_back(physical);
+				used.push_back(false);
+				resource.physical = (int)pool.size() - 1;
+			}
+
+			pool[resource.physical].busyUntil = resource.lastUse;
+			if (!used[resource.physical])
+			{
+				used[resource.physical] = true;
+				allocatedBytes += (long long)resource.desc.width * resource.desc.height * bytesPerPixel(resource.desc.format);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void RenderGraph::execute()
+{
+	for (int i = 0; i < order.size(); i++)
+	{
+		Pass& pass = passes[order[i]];
+
+		Profiler::beginSection(pass.name);
+		GpuProfiler::beginSection(pass.name);
+
+		int width, height;
+		if (bindTargets(pass, width, height))
+			glViewport(0, 0, width, height);
+		pass.execute(*this);
+
+		GpuProfiler::endSection(pass.name);
+		Profiler::endSection(pass.name);
+	}
+}
+
+
+GLuint RenderGraph::getTexture(int resource) const
+{
+	int physical = resources[versions[resource].resource].physical;
+	return physical < 0 ? 0 : pool[physical].texture;
+}
+
+
+void RenderGraph::release()
+{
+	for (int i = 0; i < pool.size(); i++)
+		glDeleteTextures(1, &pool[i].texture);
+	for (std::map<std::vector<GLuint>, GLuint>::iterator it = framebuffers.begin(); it != framebuffers.end(); ++it)
+		glDeleteFramebuffers(1, &it->second);
+	pool.clear();
+	framebuffers.clear();
+	GLState::invalidate();
+}
+
+
+/* Bind the framebuffer for the targets a pass writes, false if it writes none */
+bool RenderGraph::bindTargets(const Pass& pass, int& width, int& height)
+{
+	// Passes Only Reading, such as Readbacks, Get the Imported Framebuffer they Read
+	if (pass.writes.empty())
+	{
+		for (int i = 0; i < pass.reads.size(); i++)
+		{
+			const Resource& resource = resources[versions[pass.reads[i]].resource];
+			if (resource.imported)
+				glBindFramebuffer(GL_FRAMEBUFFER, resource.framebuffer);
+		}
+		return false;
+	}
+
+	// Imported Framebuffers are Bound as they are
+	std::vector<GLuint> colour;
+	GLuint depth = 0;
+	for (int i = 0; i < pass.writes.size(); i++)
+	{
+		const Resource& resource = resources[versions[pass.writes[i]].resource];
+		width = resource.desc.width;
+		height = resource.desc.height;
+		if (resource.imported)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, resource.framebuffer);
+			return true;
+		}
+
+		if (isDepth(resource.desc.format))
+			depth = pool[resource.physical].texture;
+		else
+			colour.push_back(pool[resource.physical].texture);
+	}
+
+	// Framebuffers are Made Once for Each Set of Textures
+	std::vector<GLuint> key = colour;
+	key.push_back(depth);
+	std::map<std::vector<GLuint>, GLuint>::iterator it = framebuffers.find(key);
+	if (it != framebuffers.end())
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, it->second);
+		return true;
+	}
+
+	GLuint framebuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	std::vector<GLenum> drawBuffers;
+	for (int i = 0; i < colour.size(); i++)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colour[i], 0);
+		drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+	}
+	if (depth != 0)
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+	if (drawBuffers.empty())
+		glDrawBuffer(GL_NONE);
+	else
+		glDrawBuffers((GLsizei)drawBuffers.size(), &drawBuffers[0]);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Render graph framebuffer for " << pass.name << " is incomplete" << std::endl;
+
+	framebuffers[key] = framebuffer;
+	return true;
+}
+
+
+int RenderGraph::bytesPerPixel(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RGBA16F: return 8;
+	default: return 4;
+	}
+}
+
+
+bool RenderGraph::sameDesc(const TextureDesc& a, const TextureDesc& b)
+{
+	return a.width == b.width && a.height == b.height && a.format == b.format;
+}
@@ -0,0 +1,118 @@
+#ifndef RENDERGRAPH_H_
+#define RENDERGRAPH_H_
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Frame Graph of Render Passes and the Targets they Draw Into
+ * Each frame the passes are declared with the resources they read and write, then compiled:
+ * passes are ordered by their dependencies, passes whose results nothing uses are culled, and
+ * transient targets whose lifetimes do not overlap share the same texture. Writing a resource
+ * returns a new version of it, so a pass drawing over an earlier pass's output depends on it.
+ * Textures and framebuffers are pooled and kept between frames, so steady frames allocate no
+ * GL objects. Imported framebuffers, such as the window's, are written but never allocated.
+ */
+class RenderGraph {
+public:
+	RenderGraph();
+	~RenderGraph();
+
+	// Size and Format of a Transient Target
+	struct TextureDesc
+	{
+		int width;
+		int height;
+		GLenum format;		// GL_RGBA8, GL_RGBA16F or GL_DEPTH_COMPONENT24
+	};
+
+	typedef std::function<void(RenderGraph&)> Execute;
+
+	void reset();		// Forgets the passes of the last frame, keeping pooled textures
+
+	// Declaring the Frame - Resource Handles are Versions, Returned by create, import and write
+	int createTexture(const std::string& name, const TextureDesc& desc);
+	int importFramebuffer(const std::string& name, GLuint framebuffer, int width, int height);
+	int addPass(const std::string& name, Execute execute);
+	void read(int pass, int resource);
+	int write(int pass, int resource);		// Returns the version the pass produces
+	void markOutput(int resource);			// Keeps the passes producing it from being culled
+	void setSideEffect(int pass);			// Never culled, for passes with effects outside the graph
+
+	bool compile();		// Orders, culls and aliases - false if the passes have a cycle
+	void execute();		// Runs the passes in order, each drawing into the targets it writes
+
+	GLuint getTexture(int resource) const;	// Texture holding a transient resource, valid while executing
+	void release();							// Deletes pooled GL objects - needs the context
+
+	// Statistics of the Last Compile
+	int getPassCount() const { return (int)passes.size(); }
+	int getCulledCount() const { return culledCount; }
+	long long getRequestedBytes() const { return requestedBytes; }	// Transient memory without aliasing
+	long long getAllocatedBytes() const { return allocatedBytes; }	// Transient memory actually used
+
+private:
+	// Declared Pass
+	struct Pass
+	{
+		std::string name;
+		Execute execute;
+		std::vector<int> reads;
+		std::vector<int> writes;
+		bool sideEffect;
+		bool live;
+	};
+
+	// Texture or Imported Framebuffer, Shared by All its Versions
+	struct Resource
+	{
+		std::string name;
+		TextureDesc desc;
+		bool imported;
+		GLuint framebuffer;		// Imported only
+		int firstUse;			// Index into the sorted passes
+		int lastUse;
+		int physical;			// Index into the pool, transient only
+	};
+
+	// One Version of a Resource
+	struct Version
+	{
+		int resource;
+		int writer;				// Pass producing it, -1 for the initial contents
+		std::vector<int> readers;
+		bool output;
+	};
+
+	// Pooled Texture
+	struct Physical
+	{
+		TextureDesc desc;
+		GLuint texture;
+		int busyUntil;			// Last sorted pass using it this frame, -1 when free
+	};
+
+	static bool isDepth(GLenum format) { return format == GL_DEPTH_COMPONENT24; }
+	static int bytesPerPixel(GLenum format);
+	static bool sameDesc(const TextureDesc& a, const TextureDesc& b);
+
+	bool bindTargets(const Pass& pass, int& width, int& height);
+
+	std::vector<Pass> passes;
+	std::vector<Resource> resources;
+	std::vector<Version> versions;
+	std::vector<int> order;				// Live passes, sorted
+
+	std::vector<Physical> pool;
+	std::map<std::vector<GLuint>, GLuint> framebuffers;		// By attached textures, depth last
+
+	int culledCount;
+	long long requestedBytes;
+	long long allocatedBytes;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "ClusteredLighting.h"
+
+/* Phong Material, as set through Ambient_uniform, Specular_uniform and SpecularPower_uniform */
+struct Material
+{
+	float ambient[4];
+	float specular[4];
+	float specularPower;
+};
+
+/* The Subset of Rendering the Game Uses: Textured, Phong Lit Meshes with Depth Testing */
+class Renderer {
+public:
+	virtual ~Renderer(){};
+
+	virtual void beginFrame(int width, int height, Vector3f clearColour) = 0;	// Sets the viewport and clears colour and depth
+	virtual void endFrame() = 0;												// Finishes drawing the frame
+
+	virtual void setProjection(Matrix4x4 projection) = 0;
+	virtual void setLight(Vector3f lightPosition) = 0;
+	virtual void setMaterial(const Material& material) = 0;
+	virtual void setTexture(unsigned int texture) = 0;
+	virtual void setPointLights(const ClusteredLighting&) {}				// Ignored by renderers without point lights
+
+	virtual void drawMesh(Mesh& mesh, Matrix4x4 modelView) = 0;
+
+	virtual unsigned int createTexture(int width, int height, const char* rgbData) = 0;	// Returns a handle for setTexture
+};
+
+#endif
@@ -1,38 +1,40 @@
 #include "Shader.h"
+#include "Profiler.h"
+
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::string Shader::cacheDirectory = "shadercache";
+std::map<GLuint, Shader::PendingProgram> Shader::pending;
+std::map<std::string, GLuint> Shader::preloaded;
+bool Shader::binaryCache = false;
+int Shader::programCount = 0;
+int Shader::cachedCount = 0;
+double Shader::firstStarted = -1.0;
+double Shader::lastFinished = 0.0;
 
 
 /* Load shaders from file function */
 GLuint Shader::LoadFromFile(std::string vertexFile, std::string fragmentFile)
 {
-	// Read the Vertex Shader code from the file
-	std::cout << "Loading "  << vertexFile << std::endl;
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertexFile.c_str(), std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}else{
-		std::cout << "Cannot open "  << vertexFile << "Please check input!" << std::endl;
-		getchar();
-		return 0;
+	// Program Already Started by Preload
+	std::map<std::string, GLuint>::iterator it = preloaded.find(vertexFile + "\n" + fragmentFile);
+	if (it != preloaded.end())
+	{
+		GLuint ProgramID = it->second;
+		preloaded.erase(it);
+		return Finish(ProgramID);
 	}
 
-	// Read the Fragment Shader code from the file
-	std::cout << "Loading "  << fragmentFile << std::endl;
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragmentFile.c_str(), std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
-	}else{
-		std::cout << "Cannot open "  << fragmentFile << "Please check input!" << std::endl;
-		getchar();
+	// Read the shader code from the files
+	std::string VertexShaderCode, FragmentShaderCode;
+	if (!ReadFile(vertexFile, VertexShaderCode) || !ReadFile(fragmentFile, FragmentShaderCode))
 		return 0;
-	}
 
     // Now use compile from src function
 	return Shader::LoadFromSrc(VertexShaderCode, FragmentShaderCode);
@@ -42,71 +44,305 @@ GLuint Shader::LoadFromFile(std::string vertexFile, std::string fragmentFile)
 /* Load shaders from src function */
 GLuint Shader::LoadFromSrc(std::string vertexSrc, std::string fragmentSrc)
 {
-	// Create the shaders
-	std::cout << vertexSrc << std::endl;
-	std::cout << fragmentSrc << std::endl;
+	GLuint ProgramID = Begin(vertexSrc, fragmentSrc);
+	return Finish(ProgramID);
+}
+
+
+/* Load compute shader from file function */
+GLuint Shader::LoadComputeFromFile(std::string computeFile)
+{
+	std::string ComputeShaderCode;
+	if (!ReadFile(computeFile, ComputeShaderCode))
+		return 0;
+
+	// Compile Compute Shader
+	char const * ComputeSourcePointer = ComputeShaderCode.c_str();
+	GLuint ComputeShaderID = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(ComputeShaderID, 1, &ComputeSourcePointer, NULL);
+	glCompileShader(ComputeShaderID);
+
+	// Link the program
+	GLuint ProgramID = glCreateProgram();
+	glAttachShader(ProgramID, ComputeShaderID);
+	glLinkProgram(ProgramID);
 
-    // Variables used to check and debug shaders
 	GLint Result = GL_FALSE;
-	int InfoLogLength;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if (Result == GL_FALSE)
+	{
+		printf("Failed to build compute program %s\n", computeFile.c_str());
+		PrintLog(ComputeShaderID, false);
+		PrintLog(ProgramID, true);
+		glDeleteShader(ComputeShaderID);
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
 
-	// Compile Vertex Shader
-	char const * VertexSourcePointer = vertexSrc.c_str();
-	GLuint VertexShaderID   = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
-
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("%s\n", &VertexShaderErrorMessage[0]);
+	// Clean up memory
+	glDetachShader(ProgramID, ComputeShaderID);
+	glDeleteShader(ComputeShaderID);
+	return ProgramID;
+}
+
+
+/* Start building a program so it compiles alongside others */
+void Shader::Preload(std::string vertexFile, std::string fragmentFile)
+{
+	std::string VertexShaderCode, FragmentShaderCode;
+	if (!ReadFile(vertexFile, VertexShaderCode) || !ReadFile(fragmentFile, FragmentShaderCode))
+		return;
+
+	preloaded[vertexFile + "\n" + fragmentFile] = Begin(VertexShaderCode, FragmentShaderCode);
+}
+
+
+/* Print how many programs were built and how long it took */
+void Shader::PrintStats()
+{
+	double milliseconds = firstStarted < 0.0 ? 0.0 : lastFinished - firstStarted;
+	std::cout << "Shaders: " << programCount << " programs in " << milliseconds << " ms, "
+		<< cachedCount << " from the binary cache" << (cachedCount == programCount ? " (warm)" : " (cold)") << std::endl;
+}
+
+
+/* Read a whole file into a string */
+bool Shader::ReadFile(std::string filename, std::string& contents)
+{
+	std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!stream.is_open())
+	{
+		std::cout << "Cannot open " << filename << " Please check input!" << std::endl;
+		return false;
+	}
+
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+
+/* Load the program from the cache or start compiling and linking it, without waiting for either */
+GLuint Shader::Begin(std::string vertexSrc, std::string fragmentSrc)
+{
+	static bool initialised = false;
+	if (!initialised)
+	{
+		// Let the Driver Choose how many Compiler Threads to Use
+		if (GLEW_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+		// Some Drivers Expose the Extension with No Binary Formats
+		GLint formats = 0;
+		if (GLEW_ARB_get_program_binary)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		binaryCache = formats > 0;
+
+		initialised = true;
 	}
 
+	double started = Profiler::now();
+	if (firstStarted < 0.0)
+		firstStarted = started;
 
-	// Compile Fragment Shader
-	char const * FragmentSourcePointer = fragmentSrc.c_str();
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
-
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("%s\n", &FragmentShaderErrorMessage[0]);
+	PendingProgram program;
+	program.vertexShader = 0;
+	program.fragmentShader = 0;
+	program.vertexSrc = vertexSrc;
+	program.fragmentSrc = fragmentSrc;
+	program.fromCache = false;
+
+	// Cache Key: FNV-1a Hash of Both Sources and the Driver
+	const char* driver[3] = {
+		(const char*)glGetString(GL_VENDOR),
+		(const char*)glGetString(GL_RENDERER),
+		(const char*)glGetString(GL_VERSION)
+	};
+	std::string key = vertexSrc + '\0' + fragmentSrc;
+	for (int i = 0; i < 3; i++)
+		key += std::string("\0", 1) + (driver[i] ? driver[i] : "");
+
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < key.size(); i++)
+	{
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ULL;
 	}
 
+	char filename[32];
+	sprintf_s(filename, "%016llx.bin", hash);
+	program.cacheFile = cacheDirectory + "/" + filename;
 
-	// Link the program
-	printf("Linking program\n");
 	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
-	glLinkProgram(ProgramID);
+	if (binaryCache && LoadBinary(ProgramID, program.cacheFile))
+		program.fromCache = true;
+	else
+		Compile(ProgramID, program);
+
+	pending[ProgramID] = program;
+	return ProgramID;
+}
+
 
+/* Wait for a program started by Begin, log any errors and cache it */
+GLuint Shader::Finish(GLuint ProgramID)
+{
+	std::map<GLuint, PendingProgram>::iterator it = pending.find(ProgramID);
+	if (it == pending.end())
+		return 0;
+	PendingProgram program = it->second;
+	pending.erase(it);
 
-	// Check the program
+	// Blocks until the Driver has Finished Linking
+	GLint Result = GL_FALSE;
 	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
-	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
-		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
-		printf("%s\n", &ProgramErrorMessage[0]);
+
+	// Binary Rejected by the Driver, Compile from Source Instead
+	if (Result == GL_FALSE && program.fromCache)
+	{
+		glDeleteProgram(ProgramID);
+		ProgramID = glCreateProgram();
+		program.fromCache = false;
+		Compile(ProgramID, program);
+		glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
 	}
-	printf("Shader Linked\n");
 
+	if (Result == GL_FALSE)
+	{
+		printf("Failed to build shader program\n");
 
-    // Clean up memory
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
+		// Only Now Read the Logs, so Compiling did not Wait on Them
+		GLint CompileResult = GL_FALSE;
+		glGetShaderiv(program.vertexShader, GL_COMPILE_STATUS, &CompileResult);
+		if (CompileResult == GL_FALSE)
+			PrintLog(program.vertexShader, false);
+		glGetShaderiv(program.fragmentShader, GL_COMPILE_STATUS, &CompileResult);
+		if (CompileResult == GL_FALSE)
+			PrintLog(program.fragmentShader, false);
+		PrintLog(ProgramID, true);
+
+		glDeleteShader(program.vertexShader);
+		glDeleteShader(program.fragmentShader);
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
 
-	printf("Shader Program Compiled\n");
+	if (!program.fromCache)
+	{
+		if (binaryCache)
+			SaveBinary(ProgramID, program.cacheFile);
+
+		// Clean up memory
+		glDetachShader(ProgramID, program.vertexShader);
+		glDetachShader(ProgramID, program.fragmentShader);
+		glDeleteShader(program.vertexShader);
+		glDeleteShader(program.fragmentShader);
+	}
+
+	programCount++;
+	if (program.fromCache)
+		cachedCount++;
+	lastFinished = Profiler::now();
 
     // Return program ID
 	return ProgramID;
 }
+
+
+/* Start compiling both stages and linking, without querying the results */
+void Shader::Compile(GLuint ProgramID, PendingProgram& program)
+{
+	// Compile Vertex Shader
+	char const * VertexSourcePointer = program.vertexSrc.c_str();
+	program.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(program.vertexShader, 1, &VertexSourcePointer, NULL);
+	glCompileShader(program.vertexShader);
+
+	// Compile Fragment Shader
+	char const * FragmentSourcePointer = program.fragmentSrc.c_str();
+	program.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(program.fragmentShader, 1, &FragmentSourcePointer, NULL);
+	glCompileShader(program.fragmentShader);
+
+	// Link the program
+	glAttachShader(ProgramID, program.vertexShader);
+	glAttachShader(ProgramID, program.fragmentShader);
+	if (binaryCache)
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(ProgramID);
+}
+
+
+/* Load a linked program binary written by SaveBinary */
+bool Shader::LoadBinary(GLuint ProgramID, const std::string& cacheFile)
+{
+	std::ifstream input(cacheFile.c_str(), std::ios::in | std::ios::binary);
+	if (!input.is_open())
+		return false;
+
+	GLenum format;
+	GLint length;
+	input.read((char*)&format, sizeof(format));
+	input.read((char*)&length, sizeof(length));
+	if (!input || length <= 0)
+		return false;
+
+	std::vector<char> binary(length);
+	input.read(&binary[0], length);
+	if (!input)
+		return false;
+
+	glProgramBinary(ProgramID, format, &binary[0], length);
+	return true;
+}
+
+
+/* Write the linked program to the cache directory */
+void Shader::SaveBinary(GLuint ProgramID, const std::string& cacheFile)
+{
+	GLint length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format;
+	glGetProgramBinary(ProgramID, length, &length, &format, &binary[0]);
+
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+
+	std::ofstream output(cacheFile.c_str(), std::ios::out | std::ios::binary);
+	if (!output.is_open())
+	{
+		std::cout << "Cannot write shader cache " << cacheFile << std::endl;
+		return;
+	}
+	output.write((const char*)&format, sizeof(format));
+	output.write((const char*)&length, sizeof(length));
+	output.write(&binary[0], length);
+}
+
+
+/* Print the info log of a shader or program */
+void Shader::PrintLog(GLuint object, bool program)
+{
+	int InfoLogLength = 0;
+	if (program)
+		glGetProgramiv(object, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	else
+		glGetShaderiv(object, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if (InfoLogLength <= 0)
+		return;
+
+	std::vector<char> ErrorMessage(InfoLogLength + 1);
+	if (program)
+		glGetProgramInfoLog(object, InfoLogLength, NULL, &ErrorMessage[0]);
+	else
+		glGetShaderInfoLog(object, InfoLogLength, NULL, &ErrorMessage[0]);
+	printf("%s\n", &ErrorMessage[0]);
+}
@@ -10,8 +10,15 @@
 #include <fstream>
 #include <algorithm>
 #include <stdlib.h>
+#include <map>
 
-/* Handles input of Vertex and Fragment Shaders from file and src */
+/*
+ * Handles input of Vertex and Fragment Shaders from file and src
+ * Linked programs are cached on disk with glGetProgramBinary, keyed by a hash of the sources and
+ * the driver, so later runs skip compilation. Programs started with Preload compile in parallel
+ * on drivers with GL_KHR_parallel_shader_compile while the caller does other work. Nothing is
+ * printed unless a shader fails to compile or link.
+ */
 class Shader {
 public:
 	// Load shaders from file
@@ -19,6 +26,46 @@ public:
 
 	// Load shaders from src
 	static GLuint LoadFromSrc(std::string vertexFile, std::string fragmentFile);
+
+	// Load a compute shader from file, compiled each run without the binary cache
+	static GLuint LoadComputeFromFile(std::string computeFile);
+
+	// Starts building a program, finished by the matching LoadFromFile
+	static void Preload(std::string vertexFile, std::string fragmentFile);
+
+	static void PrintStats();		// Programs built, how many came from the cache and the time taken
+
+	static std::string cacheDirectory;
+
+private:
+	// Program being Compiled or Loaded from the Cache
+	struct PendingProgram
+	{
+		GLuint vertexShader;
+		GLuint fragmentShader;
+		std::string vertexSrc;
+		std::string fragmentSrc;
+		std::string cacheFile;
+		bool fromCache;
+	};
+
+	static bool ReadFile(std::string filename, std::string& contents);
+	static GLuint Begin(std::string vertexSrc, std::string fragmentSrc);
+	static GLuint Finish(GLuint program);
+	static void Compile(GLuint program, PendingProgram& pending);
+	static bool LoadBinary(GLuint program, const std::string& cacheFile);
+	static void SaveBinary(GLuint program, const std::string& cacheFile);
+	static void PrintLog(GLuint object, bool program);
+
+	static std::map<GLuint, PendingProgram> pending;
+	static std::map<std::string, GLuint> preloaded;
+	static bool binaryCache;		// Program binaries supported with at least one format
+
+	// Statistics
+	static int programCount;
+	static int cachedCount;
+	static double firstStarted;
+	static double lastFinished;
 };
 
 #endif
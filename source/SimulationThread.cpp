@@ -0,0 +1,126 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <iostream>
+
+const int SimulationThread::maxCatchUp = 5;
+
+
+SimulationThread::SimulationThread()
+	: stopping(false), tickInterval(0.0), ticks(0), tickMicroseconds(0), droppedTicks(0),
+	reportInterval(300), frames(0), intervalStarted(0.0), intervalTicks(0), intervalTickMicroseconds(0), intervalDroppedTicks(0),
+	lastInputTime(0.0), latencyCount(0), latencyTotal(0.0), latencyMax(0.0)
+{
+}
+
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+
+void SimulationThread::start(double tickRate, const std::function<void()>& tick)
+{
+	stop();
+
+	this->tick = tick;
+	tickInterval = 1000.0 / tickRate;
+	stopping = false;
+	intervalStarted = Profiler::now();
+
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+
+void SimulationThread::stop()
+{
+	if (!thread.joinable())
+		return;
+
+	stopping = true;
+	thread.join();
+}
+
+
+void SimulationThread::run()
+{
+	double nextTick = Profiler::now();
+	while (!stopping)
+	{
+		double started = Profiler::now();
+		tick();
+		double finished = Profiler::now();
+
+		ticks++;
+		tickMicroseconds += (long long)((finished - started) * 1000.0);
+
+		// Drop the Backlog when Too Far Behind to Catch Up
+		nextTick += tickInterval;
+		if (finished - nextTick > tickInterval * maxCatchUp)
+		{
+			droppedTicks += (long long)((finished - nextTick) / tickInterval);
+			nextTick = finished;
+		}
+
+		// Sleep Until the Next Tick is Due
+		double remaining = nextTick - Profiler::now();
+		while (remaining > 0.0 && !stopping)
+		{
+			if (remaining > 1.0)
+				std::this_thread::sleep_for(std::chrono::microseconds((long long)((remaining - 0.5) * 1000.0)));
+			else
+				std::this_thread::yield();
+			remaining = nextTick - Profiler::now();
+		}
+	}
+}
+
+
+void SimulationThread::frameDrawn(double inputTime)
+{
+	double time = Profiler::now();
+
+	// First Frame Showing a Tick that Saw New Input
+	if (inputTime > lastInputTime)
+	{
+		double latency = time - inputTime;
+		latencyCount++;
+		latencyTotal += latency;
+		if (latency > latencyMax)
+			latencyMax = latency;
+		lastInputTime = inputTime;
+	}
+
+	frames++;
+	if (reportInterval > 0 && frames >= reportInterval)
+		report(time);
+}
+
+
+void SimulationThread::report(double time)
+{
+	long long totalTicks = ticks;
+	long long totalMicroseconds = tickMicroseconds;
+	long long totalDropped = droppedTicks;
+
+	double seconds = (time - intervalStarted) / 1000.0;
+	long long tickCount = totalTicks - intervalTicks;
+
+	std::cout << "Simulation: " << tickCount / seconds << " ticks/s, "
+		<< (tickCount > 0 ? (totalMicroseconds - intervalTickMicroseconds) / 1000.0 / tickCount : 0.0) << " ms per tick, "
+		<< totalDropped - intervalDroppedTicks << " dropped, render " << frames / seconds << " fps";
+	if (latencyCount > 0)
+		std::cout << ", input to photon " << latencyTotal / latencyCount << " ms mean, " << latencyMax << " ms max over " << latencyCount << " inputs";
+	std::cout << std::endl;
+
+	frames = 0;
+	intervalStarted = time;
+	intervalTicks = totalTicks;
+	intervalTickMicroseconds = totalMicroseconds;
+	intervalDroppedTicks = totalDropped;
+	latencyCount = 0;
+	latencyTotal = 0.0;
+	latencyMax = 0.0;
+}
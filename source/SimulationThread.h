@@ -0,0 +1,59 @@
+#ifndef SIMULATIONTHREAD_H_
+#define SIMULATIONTHREAD_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/*
+ * Runs the Game Simulation on its Own Thread at a Fixed Tick Rate
+ * Ticks are scheduled against an absolute clock so the rate does not drift. If the thread falls
+ * more than maxCatchUp ticks behind, for example while the process was suspended, the backlog
+ * is dropped rather than run all at once. The render thread reports after each swap so tick
+ * rate, render rate and input to photon latency, from an input event to the first swapped frame
+ * drawn from a tick that saw it, are printed side by side every report interval.
+ */
+class SimulationThread {
+public:
+	SimulationThread();
+	~SimulationThread();
+
+	void start(double tickRate, const std::function<void()>& tick);		// tick is called on the new thread
+	void stop();
+
+	bool isRunning() const { return thread.joinable(); }
+	double getTickInterval() const { return tickInterval; }
+
+	void frameDrawn(double inputTime);		// Render thread, after the swap, with the input time of the drawn tick
+	void setReportInterval(int frames) { reportInterval = frames; }		// 0 disables reporting
+
+	static const int maxCatchUp;
+
+private:
+	void run();
+	void report(double time);
+
+	std::thread thread;
+	std::atomic<bool> stopping;
+	std::function<void()> tick;
+	double tickInterval;
+
+	// Written by the Simulation Thread
+	std::atomic<long long> ticks;
+	std::atomic<long long> tickMicroseconds;	// Time spent inside tick()
+	std::atomic<long long> droppedTicks;
+
+	// Render Thread Statistics for the Current Report Interval
+	int reportInterval;
+	int frames;
+	double intervalStarted;
+	long long intervalTicks;
+	long long intervalTickMicroseconds;
+	long long intervalDroppedTicks;
+	double lastInputTime;
+	int latencyCount;
+	double latencyTotal;
+	double latencyMax;
+};
+
+#endif
@@ -0,0 +1,528 @@
+#include "SoftwareRenderer.h"
+#include "Profiler.h"
+#include "Image.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// Four pixels are rasterised at once with SSE2 where the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_SSE2 1
+#endif
+
+
+static unsigned int packColour(float r, float g, float b)
+{
+	r = r < 0.0f ? 0.0f : (r > 1.0f ? 1.0f : r);
+	g = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+	b = b < 0.0f ? 0.0f : (b > 1.0f ? 1.0f : b);
+	return (unsigned int)(r * 255.0f + 0.5f) | ((unsigned int)(g * 255.0f + 0.5f) << 8) |
+		((unsigned int)(b * 255.0f + 0.5f) << 16) | 0xFF000000u;
+}
+
+
+SoftwareRenderer::SoftwareRenderer(JobSystem& jobSystem)
+	: jobSystem(jobSystem), width(0), height(0), stride(0), tilesX(0), tilesY(0), clearColour(0xFF000000u), texture(0)
+{
+	Matrix4x4 identity;
+	memcpy(projection, identity.getPtr(), sizeof(projection));
+	light[0] = light[1] = light[2] = 0.0f;
+	memset(&material, 0, sizeof(material));
+}
+
+
+void SoftwareRenderer::beginFrame(int width, int height, Vector3f clearColour)
+{
+	// Resize Buffers to Whole Tiles
+	if (width != this->width || height != this->height)
+	{
+		this->width = width;
+		this->height = height;
+		tilesX = (width + tileSize - 1) / tileSize;
+		tilesY = (height + tileSize - 1) / tileSize;
+		stride = tilesX * tileSize;
+
+		int pixels = stride * tilesY * tileSize;
+		colour.assign(pixels, 0);
+		depth.assign(pixels, 1.0f);
+		pixelTriangle.assign(pixels, -1);
+		pixelB1.assign(pixels, 0.0f);
+		pixelB2.assign(pixels, 0.0f);
+		tileBins.assign(tilesX * tilesY, std::vector<int>());
+	}
+
+	this->clearColour = packColour(clearColour.x, clearColour.y, clearColour.z);
+	draws.clear();
+}
+
+
+void SoftwareRenderer::setProjection(Matrix4x4 projection)
+{
+	memcpy(this->projection, projection.getPtr(), sizeof(this->projection));
+}
+
+
+void SoftwareRenderer::setLight(Vector3f lightPosition)
+{
+	light[0] = lightPosition.x;
+	light[1] = lightPosition.y;
+	light[2] = lightPosition.z;
+}
+
+
+void SoftwareRenderer::setMaterial(const Material& material)
+{
+	this->material = material;
+}
+
+
+void SoftwareRenderer::setTexture(unsigned int texture)
+{
+	this->texture = texture;
+}
+
+
+void SoftwareRenderer::drawMesh(Mesh& mesh, Matrix4x4 modelView)
+{
+	DrawCommand draw;
+	draw.mesh = &mesh;
+	memcpy(draw.modelView, modelView.getPtr(), sizeof(draw.modelView));
+	memcpy(draw.projection, projection, sizeof(draw.projection));
+	memcpy(draw.light, light, sizeof(draw.light));
+	draw.material = material;
+	draw.texture = texture;
+	draws.push_back(draw);
+}
+
+
+unsigned int SoftwareRenderer::createTexture(int width, int height, const char* rgbData)
+{
+	SoftwareTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.rgb.assign((const unsigned char*)rgbData, (const unsigned char*)rgbData + width * height * 3);
+	textures.push_back(texture);
+	return (unsigned int)textures.size();
+}
+
+
+void SoftwareRenderer::endFrame()
+{
+	// Vertex Stage, One Draw per Task
+	double started = Profiler::now();
+	if (drawTriangles.size() < draws.size())
+		drawTriangles.resize(draws.size());
+	jobSystem.parallelFor((int)draws.size(), [this](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			processDraw(i);
+	}, 16);
+
+	triangles.clear();
+	for (unsigned int i = 0; i < draws.size(); i++)
+		triangles.insert(triangles.end(), drawTriangles[i].begin(), drawTriangles[i].end());
+	Profiler::addTime("Software Vertex", Profiler::now() - started);
+
+	// Binning
+	started = Profiler::now();
+	binTriangles();
+	Profiler::addTime("Software Bin", Profiler::now() - started);
+
+	// Rasterise and Shade Tiles in Parallel
+	started = Profiler::now();
+	jobSystem.parallelFor(tilesX * tilesY, [this](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			rasteriseTile(i);
+	});
+	Profiler::addTime("Software Raster", Profiler::now() - started);
+	Profiler::addCounter("Software Triangles", (double)triangles.size());
+}
+
+// Matches shader.vert: clip position, view space normal and direction to the eye
+void SoftwareRenderer::processDraw(int drawIndex)
+{
+	const DrawCommand& draw = draws[drawIndex];
+	std::vector<Triangle>& output = drawTriangles[drawIndex];
+	output.clear();
+
+	const std::vector<GLfloat>& positions = draw.mesh->getPositionData();
+	const std::vector<GLfloat>& normals = draw.mesh->getNormalData();
+	const std::vector<GLfloat>& texcoords = draw.mesh->getTexcoordData();
+	int vertexCount = (int)positions.size() / 3;
+
+	const float* mv = draw.modelView;
+	const float* p = draw.projection;
+
+	ClipVertex triangle[3];
+	for (int vertex = 0; vertex + 2 < vertexCount; vertex += 3)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			int index = vertex + i;
+			float px = positions[index * 3], py = positions[index * 3 + 1], pz = positions[index * 3 + 2];
+
+			float vx = mv[0] * px + mv[4] * py + mv[8] * pz + mv[12];
+			float vy = mv[1] * px + mv[5] * py + mv[9] * pz + mv[13];
+			float vz = mv[2] * px + mv[6] * py + mv[10] * pz + mv[14];
+			float vw = mv[3] * px + mv[7] * py + mv[11] * pz + mv[15];
+
+			ClipVertex& c = triangle[i];
+			c.x = p[0] * vx + p[4] * vy + p[8] * vz + p[12] * vw;
+			c.y = p[1] * vx + p[5] * vy + p[9] * vz + p[13] * vw;
+			c.z = p[2] * vx + p[6] * vy + p[10] * vz + p[14] * vw;
+			c.w = p[3] * vx + p[7] * vy + p[11] * vz + p[15] * vw;
+
+			c.attributes[0] = texcoords.empty() ? 0.0f : texcoords[index * 2];
+			c.attributes[1] = texcoords.empty() ? 0.0f : texcoords[index * 2 + 1];
+
+			float nx = normals.empty() ? 0.0f : normals[index * 3];
+			float ny = normals.empty() ? 0.0f : normals[index * 3 + 1];
+			float nz = normals.empty() ? 0.0f : normals[index * 3 + 2];
+			c.attributes[2] = mv[0] * nx + mv[4] * ny + mv[8] * nz;
+			c.attributes[3] = mv[1] * nx + mv[5] * ny + mv[9] * nz;
+			c.attributes[4] = mv[2] * nx + mv[6] * ny + mv[10] * nz;
+
+			c.attributes[5] = -vx;
+			c.attributes[6] = -vy;
+			c.attributes[7] = -vz;
+		}
+		clipTriangle(triangle, output, drawIndex);
+	}
+}
+
+// Rejects triangles outside a frustum plane and clips the rest against the near plane
+void SoftwareRenderer::clipTriangle(const ClipVertex* vertices, std::vector<Triangle>& output, int drawIndex)
+{
+	int outside[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 3; i++)
+	{
+		const ClipVertex& c = vertices[i];
+		if (c.x > c.w) outside[0]++;
+		if (c.x < -c.w) outside[1]++;
+		if (c.y > c.w) outside[2]++;
+		if (c.y < -c.w) outside[3]++;
+		if (c.z > c.w) outside[4]++;
+		if (c.z < -c.w) outside[5]++;
+	}
+	for (int plane = 0; plane < 6; plane++)
+		if (outside[plane] == 3)
+			return;
+
+	if (outside[5] == 0)
+	{
+		setupTriangle(vertices, output, drawIndex);
+		return;
+	}
+
+	// Sutherland Hodgman Against z = -w
+	ClipVertex polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const ClipVertex& current = vertices[i];
+		const ClipVertex& next = vertices[(i + 1) % 3];
+		float currentDistance = current.z + current.w;
+		float nextDistance = next.z + next.w;
+
+		if (currentDistance >= 0.0f)
+			polygon[count++] = current;
+
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			ClipVertex& v = polygon[count++];
+			v.x = current.x + (next.x - current.x) * t;
+			v.y = current.y + (next.y - current.y) * t;
+			v.z = current.z + (next.z - current.z) * t;
+			v.w = current.w + (next.w - current.w) * t;
+			for (int a = 0; a < attributeCount; a++)
+				v.attributes[a] = current.attributes[a] + (next.attributes[a] - current.attributes[a]) * t;
+		}
+	}
+
+	ClipVertex fan[3];
+	for (int i = 1; i + 1 < count; i++)
+	{
+		fan[0] = polygon[0];
+		fan[1] = polygon[i];
+		fan[2] = polygon[i + 1];
+		setupTriangle(fan, output, drawIndex);
+	}
+}
+
+
+void SoftwareRenderer::setupTriangle(const ClipVertex* vertices, std::vector<Triangle>& output, int drawIndex)
+{
+	Triangle t;
+	float z[3];
+	for (int i = 0; i < 3; i++)
+	{
+		float invW = 1.0f / vertices[i].w;
+		t.x[i] = (vertices[i].x * invW * 0.5f + 0.5f) * width;
+		t.y[i] = (vertices[i].y * invW * 0.5f + 0.5f) * height;
+		z[i] = vertices[i].z * invW;
+		t.invW[i] = invW;
+		for (int a = 0; a < attributeCount; a++)
+			t.attributes[i][a] = vertices[i].attributes[a] * invW;
+	}
+
+	// Both Windings are Drawn, as Face Culling is not Enabled in the Game
+	float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+	if (fabs(area) < 1e-8f)
+		return;
+	float sign = area > 0.0f ? 1.0f : -1.0f;
+
+	float minX = std::min(t.x[0], std::min(t.x[1], t.x[2]));
+	float maxX = std::max(t.x[0], std::max(t.x[1], t.x[2]));
+	float minY = std::min(t.y[0], std::min(t.y[1], t.y[2]));
+	float maxY = std::max(t.y[0], std::max(t.y[1], t.y[2]));
+	t.minX = std::max(0, (int)floor(minX));
+	t.maxX = std::min(width - 1, (int)ceil(maxX));
+	t.minY = std::max(0, (int)floor(minY));
+	t.maxY = std::min(height - 1, (int)ceil(maxY));
+	if (t.minX > t.maxX || t.minY > t.maxY)
+		return;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		t.edgeA[i] = -(t.y[j] - t.y[i]) * sign;
+		t.edgeB[i] = (t.x[j] - t.x[i]) * sign;
+		t.edgeC[i] = -t.edgeA[i] * t.x[i] - t.edgeB[i] * t.y[i];
+	}
+	t.invArea = 1.0f / (area * sign);
+
+	float dz1 = z[1] - z[0];
+	float dz2 = z[2] - z[0];
+	t.zA = (dz1 * (t.y[2] - t.y[0]) - dz2 * (t.y[1] - t.y[0])) / area;
+	t.zB = (dz2 * (t.x[1] - t.x[0]) - dz1 * (t.x[2] - t.x[0])) / area;
+	t.zC = z[0] - t.zA * t.x[0] - t.zB * t.y[0];
+
+	t.draw = drawIndex;
+	output.push_back(t);
+}
+
+
+void SoftwareRenderer::binTriangles()
+{
+	for (unsigned int i = 0; i < tileBins.size(); i++)
+		tileBins[i].clear();
+
+	for (unsigned int i = 0; i < triangles.size(); i++)
+	{
+		const Triangle& t = triangles[i];
+		for (int ty = t.minY / tileSize; ty <= t.maxY / tileSize; ty++)
+			for (int tx = t.minX / tileSize; tx <= t.maxX / tileSize; tx++)
+				tileBins[ty * tilesX + tx].push_back(i);
+	}
+}
+
+// Depth tests every triangle in the tile into a visibility buffer, then shades each covered pixel once
+void SoftwareRenderer::rasteriseTile(int tileIndex)
+{
+	int tileX0 = (tileIndex % tilesX) * tileSize;
+	int tileY0 = (tileIndex / tilesX) * tileSize;
+	int tileX1 = std::min(tileX0 + tileSize, width) - 1;
+	int tileY1 = std::min(tileY0 + tileSize, height) - 1;
+
+	for (int y = tileY0; y < tileY0 + tileSize; y++)
+	{
+		std::fill(&depth[y * stride + tileX0], &depth[y * stride + tileX0] + tileSize, 1.0f);
+		std::fill(&pixelTriangle[y * stride + tileX0], &pixelTriangle[y * stride + tileX0] + tileSize, -1);
+	}
+
+	const std::vector<int>& bin = tileBins[tileIndex];
+	for (unsigned int b = 0; b < bin.size(); b++)
+	{
+		const Triangle& t = triangles[bin[b]];
+		int minX = std::max(tileX0, t.minX) & ~3;
+		int maxX = std::min(tileX1, t.maxX);
+		int minY = std::max(tileY0, t.minY);
+		int maxY = std::min(tileY1, t.maxY);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float py = y + 0.5f;
+			float rowE0 = t.edgeB[0] * py + t.edgeC[0];
+			float rowE1 = t.edgeB[1] * py + t.edgeC[1];
+			float rowE2 = t.edgeB[2] * py + t.edgeC[2];
+			float rowZ = t.zB * py + t.zC;
+			int rowStart = y * stride;
+
+#ifdef SOFTWARE_SSE2
+			const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 invArea = _mm_set1_ps(t.invArea);
+			const __m128i triangleIndex = _mm_set1_epi32(bin[b]);
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[0]), px), _mm_set1_ps(rowE0));
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[1]), px), _mm_set1_ps(rowE1));
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[2]), px), _mm_set1_ps(rowE2));
+				__m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(mask) == 0)
+					continue;
+
+				// Depth Test, GL_LESS
+				__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.zA), px), _mm_set1_ps(rowZ));
+				__m128 previous = _mm_loadu_ps(&depth[rowStart + x]);
+				mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmplt_ps(z, previous), _mm_cmple_ps(z, one)));
+				if (_mm_movemask_ps(mask) == 0)
+					continue;
+
+				_mm_storeu_ps(&depth[rowStart + x], _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, previous)));
+
+				__m128i maskInt = _mm_castps_si128(mask);
+				__m128i* idAddress = (__m128i*)&pixelTriangle[rowStart + x];
+				__m128i previousId = _mm_loadu_si128(idAddress);
+				_mm_storeu_si128(idAddress, _mm_or_si128(_mm_and_si128(maskInt, triangleIndex), _mm_andnot_si128(maskInt, previousId)));
+
+				__m128 b1 = _mm_mul_ps(e2, invArea);
+				__m128 b2 = _mm_mul_ps(e0, invArea);
+				__m128 previousB1 = _mm_loadu_ps(&pixelB1[rowStart + x]);
+				__m128 previousB2 = _mm_loadu_ps(&pixelB2[rowStart + x]);
+				_mm_storeu_ps(&pixelB1[rowStart + x], _mm_or_ps(_mm_and_ps(mask, b1), _mm_andnot_ps(mask, previousB1)));
+				_mm_storeu_ps(&pixelB2[rowStart + x], _mm_or_ps(_mm_and_ps(mask, b2), _mm_andnot_ps(mask, previousB2)));
+			}
+#else
+			for (int x = minX; x <= maxX; x++)
+			{
+				float px = x + 0.5f;
+				float e0 = t.edgeA[0] * px + rowE0;
+				float e1 = t.edgeA[1] * px + rowE1;
+				float e2 = t.edgeA[2] * px + rowE2;
+				if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+					continue;
+
+				float z = t.zA * px + rowZ;
+				if (z >= depth[rowStart + x] || z > 1.0f)
+					continue;
+
+				depth[rowStart + x] = z;
+				pixelTriangle[rowStart + x] = bin[b];
+				pixelB1[rowStart + x] = e2 * t.invArea;
+				pixelB2[rowStart + x] = e0 * t.invArea;
+			}
+#endif
+		}
+	}
+
+	// Shade Visible Pixels
+	for (int y = tileY0; y <= tileY1; y++)
+	{
+		for (int x = tileX0; x <= tileX1; x++)
+		{
+			int pixel = y * stride + x;
+			int triangleIndex = pixelTriangle[pixel];
+			colour[pixel] = triangleIndex < 0 ? clearColour : shadePixel(triangles[triangleIndex], pixelB1[pixel], pixelB2[pixel]);
+		}
+	}
+}
+
+// Matches shader.frag: LightPosition_uniform is used as a view space light direction
+unsigned int SoftwareRenderer::shadePixel(const Triangle& t, float b1, float b2)
+{
+	const DrawCommand& draw = draws[t.draw];
+	float b0 = 1.0f - b1 - b2;
+
+	// Perspective Correct Attributes
+	float w = 1.0f / (b0 * t.invW[0] + b1 * t.invW[1] + b2 * t.invW[2]);
+	float a[attributeCount];
+	for (int i = 0; i < attributeCount; i++)
+		a[i] = (b0 * t.attributes[0][i] + b1 * t.attributes[1][i] + b2 * t.attributes[2][i]) * w;
+
+	float lightLength = sqrt(draw.light[0] * draw.light[0] + draw.light[1] * draw.light[1] + draw.light[2] * draw.light[2]);
+	float lx = draw.light[0], ly = draw.light[1], lz = draw.light[2];
+	if (lightLength > 0.0f)
+	{
+		lx /= lightLength; ly /= lightLength; lz /= lightLength;
+	}
+
+	float normalLength = sqrt(a[2] * a[2] + a[3] * a[3] + a[4] * a[4]);
+	float nx = a[2], ny = a[3], nz = a[4];
+	if (normalLength > 0.0f)
+	{
+		nx /= normalLength; ny /= normalLength; nz /= normalLength;
+	}
+
+	float nDotL = nx * lx + ny * ly + nz * lz;
+
+	// Texture
+	float texel[3] = { 1.0f, 1.0f, 1.0f };
+	if (draw.texture > 0 && draw.texture <= textures.size())
+		sampleTexture(textures[draw.texture - 1], a[0], a[1], texel);
+
+	float r = draw.material.ambient[0] + nDotL * texel[0];
+	float g = draw.material.ambient[1] + nDotL * texel[1];
+	float b = draw.material.ambient[2] + nDotL * texel[2];
+
+	// Specular, Skipped for Materials without it
+	const float* specular = draw.material.specular;
+	if (specular[0] != 0.0f || specular[1] != 0.0f || specular[2] != 0.0f)
+	{
+		float rx = 2.0f * nx * nDotL - lx;
+		float ry = 2.0f * ny * nDotL - ly;
+		float rz = 2.0f * nz * nDotL - lz;
+		float reflectionLength = sqrt(rx * rx + ry * ry + rz * rz);
+
+		float viewLength = sqrt(a[5] * a[5] + a[6] * a[6] + a[7] * a[7]);
+		float rDotV = 0.0f;
+		if (reflectionLength > 0.0f && viewLength > 0.0f)
+			rDotV = (rx * a[5] + ry * a[6] + rz * a[7]) / (reflectionLength * viewLength);
+
+		float highlight = rDotV > 0.0f ? pow(rDotV, draw.material.specularPower) : 0.0f;
+		r += specular[0] * highlight;
+		g += specular[1] * highlight;
+		b += specular[2] * highlight;
+	}
+
+	return packColour(r, g, b);
+}
+
+// Bilinear filtering with repeat wrapping, as the GL textures are set up
+void SoftwareRenderer::sampleTexture(const SoftwareTexture& texture, float u, float v, float result[3])
+{
+	if (texture.width <= 0 || texture.height <= 0)
+		return;
+
+	float fx = u * texture.width - 0.5f;
+	float fy = v * texture.height - 0.5f;
+	float x0f = floor(fx);
+	float y0f = floor(fy);
+	float tx = fx - x0f;
+	float ty = fy - y0f;
+
+	int x0 = ((int)x0f % texture.width + texture.width) % texture.width;
+	int y0 = ((int)y0f % texture.height + texture.height) % texture.height;
+	int x1 = (x0 + 1) % texture.width;
+	int y1 = (y0 + 1) % texture.height;
+
+	const unsigned char* p00 = &texture.rgb[(y0 * texture.width + x0) * 3];
+	const unsigned char* p10 = &texture.rgb[(y0 * texture.width + x1) * 3];
+	const unsigned char* p01 = &texture.rgb[(y1 * texture.width + x0) * 3];
+	const unsigned char* p11 = &texture.rgb[(y1 * texture.width + x1) * 3];
+
+	for (int c = 0; c < 3; c++)
+	{
+		float top = p00[c] + (p10[c] - p00[c]) * tx;
+		float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+		result[c] = (top + (bottom - top) * ty) / 255.0f;
+	}
+}
+
+
+bool SoftwareRenderer::writePPM(const std::string& filename)
+{
+	return Image::WritePPM(filename, width, height, (const unsigned char*)&colour[0], stride);
+}
+
+
+bool SoftwareRenderer::writePNG(const std::string& filename)
+{
+	return Image::WritePNG(filename, width, height, (const unsigned char*)&colour[0], stride);
+}
@@ -0,0 +1,121 @@
+#ifndef SOFTWARERENDERER_H_
+#define SOFTWARERENDERER_H_
+
+#include <string>
+#include <vector>
+
+#include "Renderer.h"
+#include "JobSystem.h"
+
+/*
+ * CPU Renderer for Machines without a GPU
+ * Draws textured, Phong lit triangles with depth testing the same way as shader.vert and
+ * shader.frag. Meshes are transformed in parallel per draw, triangles are binned into screen
+ * tiles and each tile is rasterised (four pixels at a time with SSE2) and shaded on the thread
+ * pool into an in memory framebuffer that can be written out as PPM or PNG.
+ */
+class SoftwareRenderer : public Renderer {
+public:
+	SoftwareRenderer(JobSystem& jobSystem);
+	~SoftwareRenderer(){};
+
+	void beginFrame(int width, int height, Vector3f clearColour);
+	void endFrame();		// Rasterises everything drawn since beginFrame
+
+	void setProjection(Matrix4x4 projection);
+	void setLight(Vector3f lightPosition);
+	void setMaterial(const Material& material);
+	void setTexture(unsigned int texture);
+
+	void drawMesh(Mesh& mesh, Matrix4x4 modelView);
+
+	unsigned int createTexture(int width, int height, const char* rgbData);
+
+	bool writePPM(const std::string& filename);		// Writes the last frame, top row first
+	bool writePNG(const std::string& filename);
+
+	const std::vector<unsigned int>& getColourBuffer() const { return colour; }	// RGBA8, bottom row first, getStride() pixels per row
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getStride() const { return stride; }
+	int getTriangleCount() const { return (int)triangles.size(); }
+
+	static const int tileSize = 32;		// Tile size in pixels, a multiple of 4
+
+private:
+	// Attributes Interpolated per Pixel: Texture Coordinate, View Space Normal, View Direction
+	static const int attributeCount = 8;
+
+	// Mesh Drawn with the State Current at the Time
+	struct DrawCommand
+	{
+		Mesh* mesh;
+		float modelView[16];
+		float projection[16];
+		Material material;
+		unsigned int texture;
+		float light[3];
+	};
+
+	// Vertex after the Vertex Stage
+	struct ClipVertex
+	{
+		float x, y, z, w;
+		float attributes[attributeCount];
+	};
+
+	// Screen Space Triangle Ready to Rasterise
+	struct Triangle
+	{
+		float x[3], y[3];
+		float invW[3];
+		float attributes[3][attributeCount];	// Divided by w for perspective correct interpolation
+		float edgeA[3], edgeB[3], edgeC[3];		// Edge functions, positive inside
+		float zA, zB, zC;						// NDC depth plane
+		float invArea;
+		int minX, minY, maxX, maxY;
+		int draw;
+	};
+
+	// Texture Kept on the CPU
+	struct SoftwareTexture
+	{
+		int width, height;
+		std::vector<unsigned char> rgb;
+	};
+
+	void processDraw(int drawIndex);
+	void clipTriangle(const ClipVertex* vertices, std::vector<Triangle>& output, int drawIndex);
+	void setupTriangle(const ClipVertex* vertices, std::vector<Triangle>& output, int drawIndex);
+	void binTriangles();
+	void rasteriseTile(int tileIndex);
+	unsigned int shadePixel(const Triangle& triangle, float b1, float b2);
+	void sampleTexture(const SoftwareTexture& texture, float u, float v, float result[3]);
+
+	JobSystem& jobSystem;
+
+	int width, height;		// Visible framebuffer size
+	int stride;				// Pixels per row, padded to whole tiles
+	int tilesX, tilesY;
+	unsigned int clearColour;
+
+	std::vector<unsigned int> colour;	// RGBA8 colour buffer
+	std::vector<float> depth;			// NDC depth buffer
+	std::vector<int> pixelTriangle;		// Visible triangle per pixel, -1 for background
+	std::vector<float> pixelB1;			// Screen space barycentrics of the visible triangle
+	std::vector<float> pixelB2;
+
+	// Current State
+	float projection[16];
+	float light[3];
+	Material material;
+	unsigned int texture;
+
+	std::vector<DrawCommand> draws;
+	std::vector<std::vector<Triangle> > drawTriangles;	// Triangles produced by each draw
+	std::vector<Triangle> triangles;					// All triangles this frame
+	std::vector<std::vector<int> > tileBins;			// Triangle indices per tile
+	std::vector<SoftwareTexture> textures;
+};
+
+#endif
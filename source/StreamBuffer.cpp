@@ -0,0 +1,141 @@
+#include "StreamBuffer.h"
+#include "Profiler.h"
+#include "GLState.h"
+
+#include <iostream>
+
+
+StreamBuffer::StreamBuffer()
+	: buffer(0), persistent(false), frameSize(0), frame(0), head(0), flushed(0), mapped(NULL), bytesStreamed(0), failedAllocations(0)
+{
+	for (int i = 0; i < frameCount; i++)
+		fences[i] = 0;
+}
+
+
+StreamBuffer::~StreamBuffer()
+{
+	// GL objects belong to the context, which is gone by the time globals are destroyed
+}
+
+
+bool StreamBuffer::init(int frameSize)
+{
+	this->frameSize = frameSize;
+	persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+	glGenBuffers(1, &buffer);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	if (persistent)
+	{
+		// Immutable Storage Mapped Once for the Lifetime of the Buffer
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)frameSize * frameCount, NULL, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)frameSize * frameCount, flags);
+		if (mapped == NULL)
+		{
+			std::cout << "Failed to map stream buffer, using glBufferSubData" << std::endl;
+			glDeleteBuffers(1, &buffer);
+			GLState::invalidate();		// The name may be handed out again
+			glGenBuffers(1, &buffer);
+			GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+			persistent = false;
+		}
+	}
+
+	if (!persistent)
+	{
+		glBufferData(GL_ARRAY_BUFFER, frameSize, NULL, GL_STREAM_DRAW);
+		shadow.resize(frameSize);
+	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+
+StreamBuffer::Allocation StreamBuffer::allocate(int bytes, int alignment)
+{
+	Allocation allocation;
+	allocation.pointer = NULL;
+	allocation.offset = 0;
+
+	int start = (head + alignment - 1) / alignment * alignment;
+	if (buffer == 0 || start + bytes > frameSize)
+	{
+		failedAllocations++;
+		return allocation;
+	}
+	head = start + bytes;
+	bytesStreamed += bytes;
+
+	if (persistent)
+	{
+		allocation.offset = (GLintptr)frame * frameSize + start;
+		allocation.pointer = mapped + allocation.offset;
+	}
+	else
+	{
+		allocation.offset = start;
+		allocation.pointer = &shadow[start];
+	}
+	return allocation;
+}
+
+
+void StreamBuffer::flush()
+{
+	// Coherent Mapping Needs No Flush
+	if (persistent || head == flushed)
+		return;
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, flushed, head - flushed, &shadow[flushed]);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	flushed = head;
+}
+
+
+void StreamBuffer::endFrame()
+{
+	if (buffer == 0)
+		return;
+
+	Profiler::addCounter("Stream Bytes", bytesStreamed);
+	if (failedAllocations > 0)
+		Profiler::addCounter("Stream Allocations Failed", failedAllocations);
+	bytesStreamed = 0;
+	failedAllocations = 0;
+	head = 0;
+	flushed = 0;
+
+	if (!persistent)
+	{
+		// Orphan the Storage so the Driver Hands Back Fresh Memory Instead of Waiting
+		GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, frameSize, NULL, GL_STREAM_DRAW);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+
+	// Fence the Region Just Written and Move to the Next
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % frameCount;
+
+	// Wait for the GPU to Finish Reading the Next Region from Three Frames Ago
+	if (fences[frame] != 0)
+	{
+		GLenum result = glClientWaitSync(fences[frame], 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			double started = Profiler::now();
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			Profiler::addCounter("Stream Stalls", 1);
+			Profiler::addTime("Stream Stall", Profiler::now() - started);
+		}
+		glDeleteSync(fences[frame]);
+		fences[frame] = 0;
+	}
+}
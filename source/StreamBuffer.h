@@ -0,0 +1,57 @@
+#ifndef STREAMBUFFER_H_
+#define STREAMBUFFER_H_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/*
+ * Ring Buffer for Data Written Every Frame
+ * One buffer object is split into three frame regions and persistently mapped, so allocations
+ * are written straight into GPU visible memory with no map or upload calls. A fence is placed
+ * after each frame's commands and a region is only reused once its fence has signalled, which
+ * is counted as a stall if the CPU has to wait. Without ARB_buffer_storage allocations go to a
+ * CPU copy that is uploaded with glBufferSubData into a buffer orphaned every frame.
+ */
+class StreamBuffer {
+public:
+	StreamBuffer();
+	~StreamBuffer();
+
+	bool init(int frameSize = 1 << 20);		// Bytes available per frame - needs a current GL context
+
+	// Space Allocated for this Frame
+	struct Allocation
+	{
+		void* pointer;		// CPU address to write to, NULL if the frame's region is full
+		GLintptr offset;	// Offset into getBuffer() for the GPU to read from
+	};
+
+	Allocation allocate(int bytes, int alignment = 16);
+	void flush();			// Makes writes since the last flush visible - call before the GPU reads them
+	void endFrame();		// Fences this frame's region and waits, if needed, for the next one
+
+	GLuint getBuffer() const { return buffer; }
+	bool isPersistent() const { return persistent; }
+
+	static const int frameCount = 3;
+
+private:
+	GLuint buffer;
+	bool persistent;
+
+	int frameSize;
+	int frame;				// Region being written
+	int head;				// Next free byte in the region
+	int flushed;			// Bytes of the region already uploaded, fallback only
+
+	unsigned char* mapped;					// Persistent mapping of all regions
+	std::vector<unsigned char> shadow;		// CPU copy of the region, fallback only
+	GLsync fences[frameCount];
+
+	// Statistics for the Current Frame
+	int bytesStreamed;
+	int failedAllocations;
+};
+
+#endif
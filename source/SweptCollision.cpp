@@ -0,0 +1,86 @@
+#include "SweptCollision.h"
+#include "GridRay.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+bool SweptCollision::sweep(const GridIndex& grid, Vector3f from, Vector3f to, Vector3f wallMin, Vector3f wallMax,
+	Vector3f coinMin, Vector3f coinMax, Hit& hit, int& cellsCrossed)
+{
+	cellsCrossed = 0;
+	float cellSize = GridIndex::cellSize;
+	float o[3] = { from.x, from.y, from.z };
+	float d[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+
+	// Through the Cells the Step Crosses, Testing the Wall and Coin of Each, whichever the Step Reaches First
+	return GridRay::traverse(grid.getWidth(), grid.getDepth(), cellSize, from, to - from, 0.0, 1.0, [&](int x, int z)
+	{
+		cellsCrossed++;
+		int value = grid.getCell(x, z);
+		if (value == 0)
+			return false;
+
+		float centre[3] = { x * cellSize, 0.0, z * cellSize };
+		float minimum[3] = { centre[0] + wallMin.x, wallMin.y, centre[2] + wallMin.z };
+		float maximum[3] = { centre[0] + wallMax.x, wallMax.y, centre[2] + wallMax.z };
+		float time;
+		int axis;
+		bool found = false;
+		if (enters(o, d, minimum, maximum, time, axis))
+		{
+			hit.time = time;
+			hit.axis = axis;
+			hit.coin = false;
+			found = true;
+		}
+
+		float coinMinimum[3] = { centre[0] + coinMin.x, coinMin.y, centre[2] + coinMin.z };
+		float coinMaximum[3] = { centre[0] + coinMax.x, coinMax.y, centre[2] + coinMax.z };
+		if (value == 2 && enters(o, d, coinMinimum, coinMaximum, time, axis) && (!found || time <= hit.time))
+		{
+			hit.time = time;
+			hit.axis = axis;
+			hit.coin = true;
+			found = true;
+		}
+
+		if (found)
+		{
+			hit.x = x;
+			hit.z = z;
+		}
+		return found;
+	});
+}
+
+
+/* Slab test of the step against a box, true only if it crosses a face into it, not if it starts inside or on one */
+bool SweptCollision::enters(const float* origin, const float* delta, const float* minimum, const float* maximum, float& time, int& axis)
+{
+	float tEnter = 0.0, tExit = 1.0;
+	axis = -1;
+	for (int a = 0; a < 3; a++)
+	{
+		if (fabsf(delta[a]) < GridRay::parallel)
+		{
+			if (origin[a] < minimum[a] || origin[a] > maximum[a])
+				return false;
+			continue;
+		}
+		float t0 = (minimum[a] - origin[a]) / delta[a];
+		float t1 = (maximum[a] - origin[a]) / delta[a];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > tEnter)
+		{
+			tEnter = t0;
+			axis = a;
+		}
+		tExit = std::min(tExit, t1);
+		if (tEnter > tExit)
+			return false;
+	}
+	time = tEnter;
+	return axis >= 0;
+}
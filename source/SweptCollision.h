@@ -0,0 +1,34 @@
+#ifndef SWEPTCOLLISION_H_
+#define SWEPTCOLLISION_H_
+
+#include "Vector.h"
+#include "GridIndex.h"
+
+/*
+ * Swept Tests of a Moving Point Against the Maze
+ * A step from one position to the next is walked through the cells its path crosses with
+ * GridRay::traverse, and only the boxes of those cells are tested, so nothing is missed however
+ * fast the point moves and the cost follows the cells crossed. Every wall cell has the same box
+ * around its centre, and so does every coin, both already grown by the size of whatever moves.
+ * The boxes must stay inside their cells, so the first cell with a hit holds the earliest one.
+ * Only boxes the step crosses into are hit, so something resting on a wall moves off it freely.
+ */
+class SweptCollision {
+public:
+	struct Hit
+	{
+		float time;			// Fraction of the step
+		int x, z;			// Cell
+		bool coin;			// Else the wall
+		int axis;			// Of the face entered, 0 x, 1 y, 2 z
+	};
+
+	// Boxes are Relative to the Centre of a Cell in x and z, and Absolute in y
+	static bool sweep(const GridIndex& grid, Vector3f from, Vector3f to, Vector3f wallMin, Vector3f wallMax,
+		Vector3f coinMin, Vector3f coinMax, Hit& hit, int& cellsCrossed);
+
+private:
+	static bool enters(const float* origin, const float* delta, const float* minimum, const float* maximum, float& time, int& axis);
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "TextRenderer.h"
+#include "Shader.h"
+#include "GLState.h"
+
+#include <math.h>
+#include <string.h>
+
+#define GLYPH_PADDING 2		// Pixels left of the pen position inside each cell
+
+
+TextRenderer::TextRenderer()
+	: screenWidth(0), screenHeight(0), atlasWidth(0), atlasHeight(0), batchDirty(true), uploadNeeded(true), rebuiltCount(0),
+	atlasTexture(0), vertexBuffer(0), shaderProgramID(0), streamBuffer(NULL),
+	positionAttribute(-1), texCoordAttribute(-1), colourAttribute(-1), atlasUniformLocation(-1)
+{
+}
+
+
+TextRenderer::~TextRenderer()
+{
+	// GL objects belong to the context, which is gone by the time globals are destroyed
+}
+
+
+bool TextRenderer::init(int screenWidth, int screenHeight)
+{
+	this->screenWidth = screenWidth;
+	this->screenHeight = screenHeight;
+
+	// Text Shader
+	shaderProgramID = Shader::LoadFromFile("shaders/text.vert", "shaders/text.frag");
+	if (shaderProgramID == 0)
+		return false;
+
+	positionAttribute = glGetAttribLocation(shaderProgramID, "aPosition");
+	texCoordAttribute = glGetAttribLocation(shaderProgramID, "aTexCoord");
+	colourAttribute = glGetAttribLocation(shaderProgramID, "aColour");
+	atlasUniformLocation = glGetUniformLocation(shaderProgramID, "Atlas_uniform");
+
+	bakeAtlas();
+
+	glGenBuffers(1, &vertexBuffer);
+
+	return true;
+}
+
+// Draws every glyph once with glutBitmapCharacter into an offscreen framebuffer and reads the cells back into a texture
+void TextRenderer::bakeAtlas()
+{
+	int atlasRows = (characterCount + atlasColumns - 1) / atlasColumns;
+	atlasWidth = atlasColumns * cellWidth;
+	atlasHeight = atlasRows * cellHeight;
+
+	// Offscreen Target for Baking
+	GLuint framebuffer, colourbuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colourbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colourbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, atlasWidth, atlasHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colourbuffer);
+
+	glViewport(0, 0, atlasWidth, atlasHeight);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glUseProgram(0);
+	glDisable(GL_DEPTH_TEST);
+	glColor3f(1.0, 1.0, 1.0);
+
+	// Draw Glyphs into Cells
+	for (int i = 0; i < characterCount; i++)
+	{
+		int cellX = (i % atlasColumns) * cellWidth;
+		int cellY = (i / atlasColumns) * cellHeight;
+
+		glWindowPos2i(cellX + GLYPH_PADDING, cellY + baselineOffset);
+		glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, firstCharacter + i);
+
+		glyphs[i].advance = glutBitmapWidth(GLUT_BITMAP_HELVETICA_18, firstCharacter + i);
+		glyphs[i].u0 = (float)cellX / atlasWidth;
+		glyphs[i].v0 = (float)cellY / atlasHeight;
+		glyphs[i].u1 = (float)(cellX + cellWidth) / atlasWidth;
+		glyphs[i].v1 = (float)(cellY + cellHeight) / atlasHeight;
+	}
+
+	// Read Coverage Back
+	std::vector<unsigned char> coverage(atlasWidth * atlasHeight);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, atlasWidth, atlasHeight, GL_RED, GL_UNSIGNED_BYTE, &coverage[0]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(1, &colourbuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	glEnable(GL_DEPTH_TEST);
+
+	// Upload as Alpha Texture
+	glGenTextures(1, &atlasTexture);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, atlasWidth, atlasHeight, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, &coverage[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// Baking Changed State Behind the Cache's Back
+	GLState::invalidate();
+}
+
+
+int TextRenderer::createString()
+{
+	Slot slot;
+	slot.r = slot.g = slot.b = 1.0;
+	slot.x = slot.y = 0.0;
+	slot.visible = false;
+	slots.push_back(slot);
+	return (int)slots.size() - 1;
+}
+
+
+void TextRenderer::setString(int handle, const std::string& text, float r, float g, float b, float x, float y)
+{
+	Slot& slot = slots[handle];
+
+	// Unchanged Strings Keep their Quads
+	if (slot.visible && slot.text == text && slot.r == r && slot.g == g && slot.b == b && slot.x == x && slot.y == y)
+		return;
+
+	slot.text = text;
+	slot.r = r; slot.g = g; slot.b = b;
+	slot.x = x; slot.y = y;
+	slot.visible = true;
+	buildSlot(slot);
+
+	batchDirty = true;
+}
+
+
+void TextRenderer::setVisible(int handle, bool visible)
+{
+	if (slots[handle].visible == visible)
+		return;
+
+	slots[handle].visible = visible;
+	batchDirty = true;
+}
+
+// Two triangles per character, laid out from the pen position in pixels and converted to NDC
+void TextRenderer::buildSlot(Slot& slot)
+{
+	rebuiltCount++;
+	slot.vertices.clear();
+	slot.vertices.reserve(slot.text.size() * 6 * floatsPerVertex);
+
+	// Snap the Start to a Whole Pixel so Glyphs Stay Sharp
+	float penX = floor((slot.x * 0.5f + 0.5f) * screenWidth + 0.5f);
+	float baselineY = floor((slot.y * 0.5f + 0.5f) * screenHeight + 0.5f);
+
+	for (unsigned int i = 0; i < slot.text.size(); i++)
+	{
+		int character = (unsigned char)slot.text[i] - firstCharacter;
+		if (character < 0 || character >= characterCount)
+			continue;
+		const Glyph& glyph = glyphs[character];
+
+		float px0 = ((penX - GLYPH_PADDING) / screenWidth) * 2.0f - 1.0f;
+		float px1 = ((penX - GLYPH_PADDING + cellWidth) / screenWidth) * 2.0f - 1.0f;
+		float py0 = ((baselineY - baselineOffset) / screenHeight) * 2.0f - 1.0f;
+		float py1 = ((baselineY - baselineOffset + cellHeight) / screenHeight) * 2.0f - 1.0f;
+
+		GLfloat quad[6][4] =
+		{
+			{ px0, py0, glyph.u0, glyph.v0 },
+			{ px1, py0, glyph.u1, glyph.v0 },
+			{ px1, py1, glyph.u1, glyph.v1 },
+			{ px0, py0, glyph.u0, glyph.v0 },
+			{ px1, py1, glyph.u1, glyph.v1 },
+			{ px0, py1, glyph.u0, glyph.v1 }
+		};
+		for (int v = 0; v < 6; v++)
+		{
+			slot.vertices.insert(slot.vertices.end(), quad[v], quad[v] + 4);
+			slot.vertices.push_back(slot.r);
+			slot.vertices.push_back(slot.g);
+			slot.vertices.push_back(slot.b);
+		}
+
+		penX += glyph.advance;
+	}
+}
+
+
+void TextRenderer::draw()
+{
+	// Rebuild the Batch only when a Slot Changed
+	if (batchDirty)
+	{
+		batch.clear();
+		for (unsigned int i = 0; i < slots.size(); i++)
+			if (slots[i].visible)
+				batch.insert(batch.end(), slots[i].vertices.begin(), slots[i].vertices.end());
+
+		batchDirty = false;
+		uploadNeeded = true;
+	}
+	rebuiltCount = 0;
+
+	if (batch.empty())
+		return;
+
+	// Stream the Batch into this Frame's Part of the Ring Buffer
+	GLuint sourceBuffer = vertexBuffer;
+	GLintptr sourceOffset = 0;
+	StreamBuffer::Allocation allocation = { NULL, 0 };
+	if (streamBuffer != NULL)
+		allocation = streamBuffer->allocate((int)(batch.size() * sizeof(GLfloat)), sizeof(GLfloat));
+
+	if (allocation.pointer != NULL)
+	{
+		memcpy(allocation.pointer, &batch[0], batch.size() * sizeof(GLfloat));
+		streamBuffer->flush();
+		sourceBuffer = streamBuffer->getBuffer();
+		sourceOffset = allocation.offset;
+	}
+
+	// Otherwise Keep the Batch in its Own Buffer, Uploaded when it Changes
+	else if (uploadNeeded)
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, batch.size() * sizeof(GLfloat), &batch[0], GL_DYNAMIC_DRAW);
+		uploadNeeded = false;
+	}
+
+	GLState::useProgram(shaderProgramID);
+	GLState::disable(GL_DEPTH_TEST);
+	GLState::enable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, atlasTexture);
+	GLState::uniform1i(atlasUniformLocation, 0);
+
+	GLsizei stride = floatsPerVertex * sizeof(GLfloat);
+	GLState::useVertexAttribArrays((1u << positionAttribute) | (1u << texCoordAttribute) | (1u << colourAttribute));
+	GLState::bindBuffer(GL_ARRAY_BUFFER, sourceBuffer);
+	GLState::vertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, stride, sourceOffset);
+	GLState::vertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, stride, sourceOffset + 2 * sizeof(GLfloat));
+	GLState::vertexAttribPointer(colourAttribute, 3, GL_FLOAT, GL_FALSE, stride, sourceOffset + 4 * sizeof(GLfloat));
+
+	// One Draw Call for the Whole HUD
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(batch.size() / floatsPerVertex));
+
+	GLState::disable(GL_BLEND);
+	GLState::enable(GL_DEPTH_TEST);
+}
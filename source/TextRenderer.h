@@ -0,0 +1,85 @@
+#ifndef TEXTRENDERER_H_
+#define TEXTRENDERER_H_
+
+#include <GL/glew.h>
+#include <GL/glut.h>
+
+#include <string>
+#include <vector>
+
+#include "StreamBuffer.h"
+
+/*
+ * Batched Bitmap Font Text
+ * The GLUT bitmap font is baked into a glyph atlas texture once, every string is kept as a
+ * slot holding its own quads and all visible slots are drawn from one vertex buffer in a
+ * single draw call. A slot's quads are only rebuilt when its text, colour or position changes.
+ */
+class TextRenderer {
+public:
+	TextRenderer();
+	~TextRenderer();
+
+	bool init(int screenWidth, int screenHeight);	// Bakes the atlas and loads the text shader - needs a current GL context
+
+	int createString();		// Returns a handle to a new, hidden string slot
+	void setString(int handle, const std::string& text, float r, float g, float b, float x, float y);	// x, y in NDC, like glRasterPos2f
+	void setVisible(int handle, bool visible);
+
+	void draw();			// Uploads changed vertices and draws all visible strings
+
+	void setStreamBuffer(StreamBuffer* streamBuffer) { this->streamBuffer = streamBuffer; }	// Vertices are streamed through it each frame when set
+
+	int getRebuiltCount() const { return rebuiltCount; }	// Slots rebuilt since the last draw
+
+private:
+	// Glyph in the Atlas
+	struct Glyph
+	{
+		int advance;			// Pen advance in pixels
+		float u0, v0, u1, v1;	// Atlas texture coordinates of the glyph cell
+	};
+
+	// String Slot
+	struct Slot
+	{
+		std::string text;
+		float r, g, b;
+		float x, y;
+		bool visible;
+		std::vector<GLfloat> vertices;	// Cached quads: position xy, texcoord uv, colour rgb
+	};
+
+	void bakeAtlas();
+	void buildSlot(Slot& slot);
+
+	static const int firstCharacter = 32;
+	static const int characterCount = 95;
+	static const int atlasColumns = 16;
+	static const int cellWidth = 20;
+	static const int cellHeight = 24;
+	static const int baselineOffset = 6;	// Pixels from the bottom of a cell to the baseline
+	static const int floatsPerVertex = 7;
+
+	int screenWidth, screenHeight;
+	int atlasWidth, atlasHeight;
+
+	Glyph glyphs[characterCount];
+	std::vector<Slot> slots;
+	std::vector<GLfloat> batch;		// All visible slot vertices, as last uploaded
+	bool batchDirty;
+	bool uploadNeeded;				// vertexBuffer is behind the batch
+	int rebuiltCount;
+
+	GLuint atlasTexture;
+	GLuint vertexBuffer;
+	GLuint shaderProgramID;
+	StreamBuffer* streamBuffer;
+
+	GLint positionAttribute;
+	GLint texCoordAttribute;
+	GLint colourAttribute;
+	GLint atlasUniformLocation;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TRIPLEBUFFER_H_
+#define TRIPLEBUFFER_H_
+
+#include <atomic>
+
+/*
+ * Lock Free Hand Off of the Latest Value from One Writer Thread to One Reader Thread
+ * Three slots: the writer fills its back slot and swaps it with the middle one, the reader swaps
+ * its front slot with the middle one when a newer value is waiting. Neither side ever waits and
+ * values the reader was too slow to see are overwritten. Slots are reused, so anything they own,
+ * such as vector capacity, is only allocated while they warm up.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : back(0), middle(1), front(2) {}
+
+	// Writer Thread
+	T& write() { return slots[back]; }
+	void publish() { back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask; }
+
+	// Reader Thread
+	bool update()		// Takes the newest published value, false if there is nothing new
+	{
+		if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	const T& read() const { return slots[front]; }
+
+private:
+	static const int indexMask = 3;
+	static const int freshBit = 4;		// Set on the middle index when the writer published into it
+
+	T slots[3];
+	int back;
+	std::atomic<int> middle;
+	int front;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef WORLDSNAPSHOT_H_
+#define WORLDSNAPSHOT_H_
+
+#include "Vector.h"
+
+#include <vector>
+
+// Map Cell Changed by the Simulation
+struct MapChange
+{
+	int x;
+	int z;
+	int value;
+};
+
+/*
+ * Everything Drawn for One Simulation Tick
+ * Copied out of the game state at the end of a tick so drawing never reads state the simulation
+ * is changing. The maze is not copied: the renderer keeps its own copy of the loaded map and
+ * applies mapChanges, every cell changed since the map was last loaded, which stays small.
+ */
+struct WorldSnapshot
+{
+	WorldSnapshot() : tick(-1), time(0.0), inputTime(0.0) {}
+
+	long long tick;
+	double time;				// When the tick was taken, on the profiler clock
+	double inputTime;			// Newest input event the tick has seen, 0 if none
+
+	Vector3f tankPosition;
+	float tankRotationDegrees;
+	float turretRotationDegrees;
+
+	Vector3f ballPosition;
+	bool launchBall;
+	std::vector<Vector3f> shellPositions;	// Live shells, drawn where the latest tick left them
+	std::vector<Vector3f> wandererPositions;	// Wandering ball entities, likewise
+
+	Vector3f cameraPosition;
+	Vector3f cameraTarget;
+	bool thirdPersonCamera;
+	bool firstPersonCamera;
+	bool freeThirdPersonCamera;
+
+	float coinRotation;
+	int coinsRemaining;
+	float timeRemaining;
+
+	bool playerWon;
+	bool outOfTime;
+	bool tankFell;
+
+	int mapVersion;				// Incremented whenever the map is reloaded
+	std::vector<MapChange> mapChanges;
+};
+
+#endif
@@ -6,30 +6,122 @@
 #include "Matrix.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "OcclusionCuller.h"
+#include "TextRenderer.h"
+#include "Renderer.h"
+#include "GLRenderer.h"
+#include "SoftwareRenderer.h"
+#include "FramePacer.h"
+#include "ClusteredLighting.h"
+#include "StreamBuffer.h"
+#include "HeadlessContext.h"
+#include "FrameReadback.h"
+#include "EntityWorld.h"
+#include "Image.h"
+#include "GpuProfiler.h"
+#include "GLState.h"
+#include "RenderGraph.h"
+#include "PostProcess.h"
+#include "GpuCulling.h"
+#include "GridIndex.h"
+#include "LevelGrid.h"
+#include "LightmapBaker.h"
+#include "MeshBVH.h"
+#include "PotentiallyVisibleSet.h"
+#include "ProjectilePool.h"
+#include "SimulationThread.h"
+#include "SweptCollision.h"
+#include "TripleBuffer.h"
+#include "WorldSnapshot.h"
+#include "InputRecorder.h"
+#include "MazeGenerator.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <math.h>
+#include <mutex>
+#include <stdlib.h>
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
 #define PI 3.14159265358979323846
 
 // ------------------------------- FUNCTION PROTOTYPES ------------------------------- //
 
 bool initGL(int argc, char** argv);
-void initShader();
-void initTexture(std::string filename, GLuint& textureID);
+unsigned int loadTexture(std::string filename);
 bool loadMap(std::string filename);
 void display(void);
+void idle(void);
+void updateGame();
+void takeSnapshot(WorldSnapshot& snapshot);
+void applyMapChanges(const WorldSnapshot& snapshot);
+void simulationTick();
+void stopSimulationThread();
+void interpolateWorld();
+void blendTicks(const WorldSnapshot& previous, const WorldSnapshot& latest, float t, WorldSnapshot& blended);
+void stepSimulation(double milliseconds);
+void runTick();
+bool replayFinished();
+bool replayRecording();
+bool checkReplay();
+void feedRecordedInput();
+void finishRecording();
+void updateShells();
+void spawnEntities();
+void updateTanks();
+void updateBalls();
+void takeCoin(int x, int z);
+bool tankTouchesPickup(Entity collector, const Pickup& pickup);
+void tankMatrices(Entity tank, Matrix4x4& body, Matrix4x4& turret);
+void tankBounds(Entity tank, Vector3f& min, Vector3f& max);
+bool tankTouchesBox(Entity tank, Vector3f min, Vector3f max);
+unsigned long long stateChecksum();
+void renderScene(Renderer& renderer, const WorldSnapshot& world);
+void renderMaze(Renderer& renderer, const WorldSnapshot& world, Matrix4x4 viewMatrix);
+void renderBalls(Renderer& renderer, const std::vector<Vector3f>& positions, Matrix4x4 viewMatrix);
+void renderMazeIndirect(const WorldSnapshot& world, Matrix4x4 viewMatrix);
+void renderFrame(const WorldSnapshot& world, GLuint backbuffer, FrameReadback* readback, int frame);
+void updateCoinLights(const WorldSnapshot& world);
+std::vector<PointLight> gatherCoinLights();
+void updateLightmap();
+void renderBakedWalls(Matrix4x4 viewMatrix);
+void renderSoftware(int frames, std::string filename);
+bool renderHeadless(int frames);
+bool captureFrame(int frame, const std::vector<unsigned char>& pixels);
+bool generateLevel(int width, int depth, std::string filename);
+bool runScenarios(int argc, char** argv);
+int runProcess(const std::vector<std::string>& arguments);
+void writeScenarioResult(double meanFrameTime, double p95FrameTime);
+long long mapBytes();
 void Timer(int value);
+void timerTick();
+void advanceTimer(float milliseconds);
 
 // Keyboard Interaction
 void keyDown(unsigned char key, int x, int y);
 void keyUp(unsigned char key, int x, int y);
+void liveKeyDown(unsigned char key, int x, int y);
+void liveKeyUp(unsigned char key, int x, int y);
 void handleKeys();
 
 // Mouse Interaction
 void mouse(int button, int state, int x, int y);
 void motion(int x, int y);
+void liveMouse(int button, int state, int x, int y);
+void liveMotion(int x, int y);
 
 // Collision Detection
 bool AABBintersectAABB(Mesh& mesh, Vector3f max, Vector3f min);
@@ -38,6 +130,9 @@ bool AABBintersectLine(Mesh& mesh, Vector2f line);
 
 // 2D Text
 void render2dText(std::string text, float r, float g, float b, float x, float y);
+void initHud();
+void updateHud(const WorldSnapshot& world);
+void renderLegacyHud(const WorldSnapshot& world);
 
 // ------------------------------- GLOBAL VARIABLES ------------------------------- //
 
@@ -45,28 +140,22 @@ void render2dText(std::string text, float r, float g, float b, float x, float y)
 int screenWidth = 720;
 int screenHeight = 720;
 
-GLuint textureCube;             // Texture for Cube
-GLuint textureCoin;             // Texture for Coin
-GLuint textureBall;             // Texture for Ball
-GLuint textureTank;             // Texture for Tank
-
-GLuint shaderProgramID;
-
-GLuint vertexPositionAttribute;         // Vertex Position Attribute Location
-GLuint vertexNormalAttribute;           // Vertex Normal Attribute Location
-
-GLuint vertexTexCoordAttribute;         // Vertex Texture Coordinate Attribute Location
-GLuint TextureMapUniformLocation;       // Texture Map Uniform Location
+unsigned int textureCube;       // Texture for Cube
+unsigned int textureCoin;       // Texture for Coin
+unsigned int textureBall;       // Texture for Ball
+unsigned int textureTank;       // Texture for Tank
 
-Matrix4x4 ModelViewMatrix;              // Model View Matrix
-GLuint ModelViewMatrixUniformLocation;  // Model View Matrix Uniform Location
+Matrix4x4 ModelViewMatrix;      // Model View Matrix
+Matrix4x4 ProjectionMatrix;     // Projection Matrix
 
-Matrix4x4 ProjectionMatrix;             // Projection Matrix
-GLuint ProjectionMatrixUniformLocation; // Projection Matrix Uniform Location
+Vector3f clearColour = Vector3f(0.086, 0.603, 0.854);
 
 // Maze Map
 std::string mapFile = "levels/level1.txt";
-std::vector<std::vector<int>> map;
+LevelGrid map;                             // Keeps the level as loaded, for restarts
+std::vector<MapChange> mapChanges;         // Cells changed since the map was last loaded
+int mapVersion = 0;
+GridIndex mapGrid;                         // Cells by position, for the tank, ball and coin tests
 float timeLimit = 60.0;
 
 // Game State
@@ -79,6 +168,7 @@ float timeRemaining = timeLimit;
 float deltaTime;
 float currentTime;
 float lastTime;
+float timerTime = 0.0;          // Simulated milliseconds not yet handed to timerTick
 
 // Physics
 Vector3f gravity = Vector3f(0.0, -0.0001, 0.0);
@@ -86,6 +176,7 @@ const float groundY = 14.5;
 
 // Array of Key States
 bool keyStates[256];
+double lastInputTime = 0.0;     // Newest input event, for measuring input to photon latency
 
 // Camera
 Vector3f cameraPosition;
@@ -111,44 +202,55 @@ int currentState = 0;
 
 bool reset;
 
-// Coins
+// Coins - Counted by their Pickups
 float coinRotation;
-int coinsRemaining = 0;
 std::vector<Vector3f> collisionPoints;
 
-// Tank
-Vector3f tankPosition;
-Vector3f tankVelocity;
-Vector3f tankForce;
-float tankMass = 48000.0;
-
-float tankRotationDegrees;
-float tankRotationRadians;
-float turretRotationDegrees;
-float turretRotationRadians;
-
-bool tankFalling = false;
-bool tankSet = false;
+// Tank - Where it is, its Heading, Turret and Motion are Components of its Entity
+const float tankMass = 48000.0;
 
 // Ball
-Vector3f ballPosition;
-Vector3f ballVelocity;
-Vector3f ballForce;
 const float ballMass = 1.0;
 
 float ballRotationDegrees;
 
-bool launchBall = false;
+bool sweptCollision = true;     // true sweeps each ball step through the cells it crosses, false tests only where the step ends, so a fast ball can pass through a wall
+
+// Worker Threads
+JobSystem jobSystem;
+
+// Shells Fired while E is Held, from a Pool
+ProjectilePool projectiles(jobSystem);
+bool shells = false;            // true fires shells from a fixed pool with E, false launches the tank's single ball
+int shellCapacity = 1024;
+int shellBarrage = 0;           // Shells kept in flight from the tank, for measuring, 0 for none
+long long shellsFired = 0;
+bool shellTrigger = false;      // E held this update
+float shellCooldown = 0.0;
+const float shellInterval = 100.0;      // Milliseconds between shells while E is held
+const float shellSpeed = 0.1;           // Units per millisecond, along the turret
+const float shellLift = 0.05;
+const float shellLifetime = 5000.0;
+std::vector<GLfloat> ballInstances;     // Placement of each shell or wandering ball drawn, reused every frame
+
+// Tank, Ball and Coins as Entities, with Balls Wandering the Maze
+EntityWorld entities(jobSystem);
+int wandererCount = 0;          // Balls bouncing about the maze collecting coins, for measuring
+const float wandererSpeed = 0.05;       // Units per millisecond
+const int ballMeshId = 0;               // Renderable mesh of the wandering balls
+Entity tankEntity = 0;          // The player's, driven by the keys and followed by the camera
+Entity ballEntity = 0;          // Launched from the player's tank
+std::vector<EntityWorld::Collection> coinCollections;
 
 // Lighting - Phong Reflection Model
-GLuint LightPositionUniformLocation;
-GLuint AmbientUniformLocation;
-GLuint SpecularUniformLocation;
-GLuint SpecularPowerUniformLocation;
-
 Vector3f lightPosition;
 bool lightSet = false;
 
+const Material cubeMaterial = { { 0.1, 0.1, 0.1, 1.0 }, { 0.0, 0.0, 0.0, 1.0 }, 10.0 };
+const Material coinMaterial = { { 0.24725, 0.1995, 0.0745, 1.0 }, { 0.628281, 0.555802, 0.366065, 1.0 }, 51.2 };
+const Material tankMaterial = { { 0.135, 0.2225, 0.1575, 0.95 }, { 0.316228, 0.316228, 0.316228, 0.95 }, 12.8 };
+const Material ballMaterial = { { 0.02, 0.02, 0.02, 1.0 }, { 0.4, 0.4, 0.4, 1.0 }, 10.0 };
+
 // Mesh Object
 Mesh meshCube;
 Mesh meshCoin;
@@ -158,67 +260,548 @@ Mesh meshBackWheel;
 Mesh meshFrontWheel;
 Mesh meshTurret;
 
+// Triangles of the Tank, for Hits Against its Shape Rather than its Box
+MeshBVH chassisBVH;
+MeshBVH backWheelBVH;
+MeshBVH frontWheelBVH;
+MeshBVH turretBVH;
+bool preciseHits = true;        // true collects coins the tank's triangles touch, false coins its bounding box touches
+
 float aabbOffset = 3.0;
 
+// Occlusion Culling
+OcclusionCuller occlusionCuller(jobSystem);
+bool occlusionCulling = true;   // true skips chunks and cells hidden behind nearer walls in the software depth buffer
+const int chunkSize = 8;        // Map cells per side of a culling chunk
+const int occluderRange = 12;   // Cells from the camera whose walls are drawn as occluders - nearer walls hide the most
+
+// Cubes and Coins of a Row of Chunks that Passed Culling, in Drawing Order
+struct VisibleCells
+{
+    std::vector<Matrix4x4> cubes;               // Model view of each cube
+    std::vector<std::pair<int, int>> coins;
+    int pvsRejected;
+};
+std::vector<VisibleCells> visibleRows;          // One per row of chunks, reused every frame
+
+// Chunks Seen from Each Walkable Cell, Built Once per Level and Saved Beside it
+PotentiallyVisibleSet potentiallyVisible(jobSystem);
+bool pvsCulling = false;        // true skips chunks the camera's cell cannot see by the precomputed sets, false leaves them to the occlusion test
+const float viewDistance = 1000.0 * sqrt(3.0);    // Frustum corner at the far plane, for the 90 degree square view
+
+// Maze Culled and Drawn by Indirect Draws, One per Material
+GpuCulling gpuCulling;
+bool indirectDrawing = false;   // true submits the maze with multi draw indirect, false draws each visible cell
+bool computeCulling = true;     // true builds the indirect draw commands in a compute shader, false on the CPU
+int cubeMeshIndex = -1;
+int coinMeshIndex = -1;
+int culledMapVersion = -1;      // Map the instances were last built from
+int culledMapChanges = -1;
+
+// Clustered Point Lights, One Above Each Coin
+ClusteredLighting clusteredLighting(jobSystem);
+bool pointLights = true;        // true lights the scene with a point light above each coin, false with the sun alone
+int litCoins = -1;              // Coins remaining when the lights were last gathered
+const float coinLightRadius = 45.0;
+const Vector3f coinLightColour = Vector3f(0.9, 0.7, 0.3);
+
+// Wall Lighting Baked into an Atlas, Redone when the Map or its Coins Change
+LightmapBaker lightmapBaker(jobSystem);
+bool lightmaps = false;         // true lights the walls from the baked lightmap atlas with ambient occlusion, false per fragment
+int bakedMapVersion = -1;       // Map the lightmap was last baked from
+int bakedMapChanges = -1;
+int reportedBakes = 0;
+const Vector3f sunDirection = Vector3f(0.5, 1.0, 0.3);  // The per fragment light follows the view, so baking uses a fixed sun
+const Vector3f sunColour = Vector3f(0.8, 0.8, 0.8);
+const Vector3f skyColour = Vector3f(0.35, 0.35, 0.4);
+
+// Renderers
+GLRenderer glRenderer;
+SoftwareRenderer softwareRenderer(jobSystem);
+Renderer* renderer = &glRenderer;
+
+// GPU Pass Timings from Timer Queries, Reported with the Profiler's Stats
+bool gpuTiming = true;          // true times GPU passes with timer queries alongside the CPU sections
+
+// Skip GL Calls that would Not Change the Bound State
+bool stateCache = true;         // true skips calls that would not change the bound state, false issues every call, still counted
+
+// Render Passes, Declared and Compiled Every Frame
+RenderGraph renderGraph;
+PostProcess postProcess;
+bool bloom = false;             // true draws the scene into transient targets and adds a bloom chain
+float bloomThreshold = 0.9;
+float bloomIntensity = 0.6;
+
+// Ring Buffer for Per Frame Uploads
+StreamBuffer streamBuffer;
+bool streaming = true;          // true writes per frame data into the persistently mapped ring, false uploads it with glBufferData and glTexSubImage2D
+
+// Headless Rendering
+HeadlessContext headlessContext;
+float fixedFrameTime = 0.0;             // Milliseconds per frame when non zero, so runs are repeatable
+std::vector<int> dumpFrames;            // Frames written to dumpDirectory
+std::string dumpDirectory = "frames";
+std::string goldenDirectory;            // Dumped frames are compared with the same files here when set
+int compareTolerance = 2;               // Channel difference allowed per pixel
+double compareMaxDiffering = 0.001;     // Fraction of pixels allowed to differ by more than the tolerance
+std::string statsFile;                  // Frame times are written here as CSV when set
+bool followTank = false;                // true keeps the game's camera instead of orbiting the maze
+
+// Generated Levels and Scaling Scenarios
+std::string generateFile;               // A generated level is written here and the program exits, when set
+int generateWidth = 64;
+int generateDepth = 64;
+unsigned int generateSeed = 1;
+float coinDensity = 0.05;               // Chance of a coin on each passage cell of a generated level
+std::vector<int> scenarioSizes;         // Levels of each size are generated and run in a process of their own, when set
+std::string scenarioResults;            // Load, memory, tick and frame statistics of the run are added here as CSV, when set
+bool binaryLevels = false;              // true writes scenario levels as binary .lvl files, false as text
+const int scenarioFrames = 120;
+double mapLoadTime = 0.0;
+double startupTime = 0.0;
+double tickTimeSpent = 0.0;             // Inside ticks, for the mean tick time
+
+// Frame Pacing
+FramePacer framePacer;
+double targetFps = 60.0;        // 0 draws as fast as redisplays are requested
+bool vsync = false;             // true waits for the display's refresh on each swap
+bool frameLimiter = true;       // true sleeps then spins until each frame is due, false redraws as soon as a frame is drawn
+
+// HUD Text
+TextRenderer textRenderer;
+bool batchedText = true;        // true draws the HUD from the baked glyph atlas in one call, false a character at a time with glutBitmapCharacter
+
+int hudTimeText;
+int hudCoinsText;
+int hudCameraText;
+int hudHelpText[3];
+int hudResultText[3];           // Won or out of time messages
+int hudFallText[2];             // Fell off the maze messages
+
+int shownTimeCentiseconds = -1; // Values last formatted into the HUD
+int shownCoinsRemaining = -1;
+int shownResult = -1;
+
+// State Drawn this Frame, Taken from the Game after Updating or from the Simulation Thread
+WorldSnapshot world;
+LevelGrid renderMap;                        // Maze as drawn, the level as loaded with world.mapChanges applied
+int renderMapVersion = -1;
+int renderMapChanges = 0;
+
+// Simulation Thread: Game Ticks Run Apart from Drawing, Publishing Snapshots Lock Free
+double simulationRate = 0.0;    // Ticks per second on the simulation thread, 0 runs the game's ticks in display() instead
+TripleBuffer<WorldSnapshot> snapshots;
+WorldSnapshot previousTick;     // Ticks the render thread interpolates between
+WorldSnapshot latestTick;
+std::mutex gameMutex;           // Held by each tick and by input callbacks, never while drawing
+SimulationThread simulationThread;    // After what its ticks use, so is destroyed first
+
+// Fixed Timestep: Whole Ticks Run for the Time Each Frame Took, Drawn Blended Between the Last Two
+bool fixedStep = true;          // false updates once per frame with the frame's time, which only --variable-step asks for, to measure how play depends on frame rate
+double tickRate = 100.0;        // Ticks per second, 100 runs the 10 ms timer once per tick
+int maxCatchUpTicks = 5;        // Ticks run for one frame at most, time beyond that is dropped
+double tickMilliseconds = 10.0;
+double tickAccumulator = 0.0;   // Frame time not yet run as ticks
+long long ticksRun = 0;
+
+// Input Recording: Live Input Saved with the Tick it Arrived Before, or a Recording Played Back in its Place
+InputRecorder inputRecorder;
+std::string recordFile;         // Input is recorded into this file when set
+std::string replayFile;         // Input is played back from this file, ignoring the keyboard and mouse, when set
+bool replayFast = false;        // true runs the recorded ticks back to back without drawing, false keeps to real time
+bool replayChecked = false;     // The recording has run out and the state was checked against it
+bool replayMatched = false;
+
 // ------------------------------- MAIN PROGRAM ENTRY ------------------------------- //
 int main(int argc, char** argv)
 {
+    double startupStarted = Profiler::now();
+
+    // Software Rendering: --software [frames] [output.png|output.ppm]
+    bool software = false;
+    int softwareFrames = 1;
+    std::string softwareOutput = "frame.png";
+
+    // Headless Rendering: --headless [frames] [--dump 0,30,59] [--dump-dir dir] [--compare dir]
+    //                     [--tolerance 2] [--max-differing 0.001] [--stats frames.csv] [--follow-tank]
+    bool headless = false;
+    int headlessFrames = 300;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--software")
+        {
+            software = true;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                softwareFrames = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                softwareOutput = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--headless")
+        {
+            headless = true;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                headlessFrames = atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--dump" && i + 1 < argc)
+        {
+            // Comma Separated Frame Numbers
+            std::istringstream frames(argv[++i]);
+            std::string frame;
+            while (std::getline(frames, frame, ','))
+                dumpFrames.push_back(atoi(frame.c_str()));
+        }
+        else if (std::string(argv[i]) == "--dump-dir" && i + 1 < argc)
+            dumpDirectory = argv[++i];
+        else if (std::string(argv[i]) == "--compare" && i + 1 < argc)
+            goldenDirectory = argv[++i];
+        else if (std::string(argv[i]) == "--tolerance" && i + 1 < argc)
+            compareTolerance = atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--max-differing" && i + 1 < argc)
+            compareMaxDiffering = atof(argv[++i]);
+        else if (std::string(argv[i]) == "--stats" && i + 1 < argc)
+            statsFile = argv[++i];
+        else if (std::string(argv[i]) == "--sim-thread")
+        {
+            simulationRate = 120.0;
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.0)
+                simulationRate = atof(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--fixed-step")
+        {
+            fixedStep = true;
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.0)
+                tickRate = atof(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--variable-step")
+            fixedStep = false;
+        else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+            recordFile = argv[++i];
+        else if (std::string(argv[i]) == "--replay" && i + 1 < argc)
+        {
+            replayFile = argv[++i];
+            if (i + 1 < argc && std::string(argv[i + 1]) == "fast")
+            {
+                replayFast = true;
+                i++;
+            }
+        }
+        else if (std::string(argv[i]) == "--generate" && i + 2 < argc)
+        {
+            // Size as 512 or 512x256, then the File
+            std::string size = argv[++i];
+            generateWidth = generateDepth = atoi(size.c_str());
+            if (size.find('x') != std::string::npos)
+                generateDepth = atoi(size.c_str() + size.find('x') + 1);
+            generateFile = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--seed" && i + 1 < argc)
+            generateSeed = (unsigned int)atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--coin-density" && i + 1 < argc)
+            coinDensity = atof(argv[++i]);
+        else if (std::string(argv[i]) == "--scenarios")
+        {
+            // Comma Separated Sizes, 10 to 4096 when None are Given
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+            {
+                std::istringstream sizes(argv[++i]);
+                std::string size;
+                while (std::getline(sizes, size, ','))
+                    scenarioSizes.push_back(atoi(size.c_str()));
+            }
+            else
+                scenarioSizes = { 10, 32, 128, 512, 1024, 2048, 4096 };
+        }
+        else if (std::string(argv[i]) == "--scenario-results" && i + 1 < argc)
+            scenarioResults = argv[++i];
+        else if (std::string(argv[i]) == "--binary-levels")
+            binaryLevels = true;
+        else if (std::string(argv[i]) == "--max-catch-up" && i + 1 < argc)
+            maxCatchUpTicks = std::max(1, atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--shells")
+        {
+            shells = true;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                shellCapacity = atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--barrage" && i + 1 < argc)
+        {
+            shells = true;
+            shellBarrage = std::max(0, atoi(argv[++i]));
+        }
+        else if (std::string(argv[i]) == "--no-swept-collision")
+            sweptCollision = false;
+        else if (std::string(argv[i]) == "--no-precise-hits")
+            preciseHits = false;
+        else if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+            jobSystem.setThreadCount(std::max(0, atoi(argv[++i])));
+        else if (std::string(argv[i]) == "--wanderers" && i + 1 < argc)
+            wandererCount = std::max(0, atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--no-gpu-timing")
+            gpuTiming = false;
+        else if (std::string(argv[i]) == "--no-state-cache")
+            stateCache = false;
+        else if (std::string(argv[i]) == "--no-streaming")
+            streaming = false;
+        else if (std::string(argv[i]) == "--map" && i + 1 < argc)
+            mapFile = argv[++i];
+        else if (std::string(argv[i]) == "--no-occlusion")
+            occlusionCulling = false;
+        else if (std::string(argv[i]) == "--no-point-lights")
+            pointLights = false;
+        else if (std::string(argv[i]) == "--bloom")
+            bloom = true;
+        else if (std::string(argv[i]) == "--lightmaps")
+            lightmaps = true;
+        else if (std::string(argv[i]) == "--pvs")
+            pvsCulling = true;
+        else if (std::string(argv[i]) == "--follow-tank")
+            followTank = true;
+        else if (std::string(argv[i]) == "--gpu-culling")
+        {
+            indirectDrawing = true;
+            if (i + 1 < argc && std::string(argv[i + 1]) == "cpu")
+            {
+                computeCulling = false;
+                i++;
+            }
+        }
+        else if (std::string(argv[i]) == "--fps" && i + 1 < argc)
+            targetFps = atof(argv[++i]);
+        else if (std::string(argv[i]) == "--vsync")
+            vsync = true;
+        else if (std::string(argv[i]) == "--no-limiter")
+            frameLimiter = false;
+    }
+
+    // Write a Generated Level, or Generate and Run Levels of Rising Size, and Exit
+    if (!generateFile.empty())
+        return generateLevel(generateWidth, generateDepth, generateFile) ? 0 : 1;
+    if (!scenarioSizes.empty())
+        return runScenarios(argc, argv) ? 0 : 1;
+
     // Initialise OpenGL
-    if (!initGL(argc, argv))
+    if (software)
+        renderer = &softwareRenderer;
+    else if (headless)
+    {
+        if (!headlessContext.init(screenWidth, screenHeight))
+            return -1;
+        GLState::enable(GL_DEPTH_TEST);
+
+        // Simulate at the Target Frame Rate Regardless of how Long Frames Take
+        fixedFrameTime = 1000.0 / (targetFps > 0.0 ? targetFps : 60.0);
+    }
+    else if (!initGL(argc, argv))
         return -1;
 
+    // Start Building Shaders so they Compile while Assets Load
+    if (!software)
+    {
+        Shader::Preload("shaders/shader.vert", "shaders/shader.frag");
+        if (!headless)
+            Shader::Preload("shaders/text.vert", "shaders/text.frag");
+        if (bloom)
+            Shader::Preload("shaders/post.vert", "shaders/post.frag");
+        if (lightmaps)
+            Shader::Preload("shaders/lightmap.vert", "shaders/lightmap.frag");
+    }
+
     // Initialise Key States to false
     for (int i = 0; i < 256; i++)
         keyStates[i] = false;
 
     // Load Map from File
+    double loadStarted = Profiler::now();
     if (!loadMap(mapFile))
         return -1;
+    mapLoadTime = Profiler::now() - loadStarted;
+    renderMap = map;
 
-    // Initialise OpenGL Shader
-    initShader();
+    // Set Aside Every Shell Slot Now, so Firing Never Allocates
+    if (shells)
+        projectiles.setCapacity(std::max(shellCapacity, shellBarrage));
+
+    // Load the Level's Visible Sets, Building and Saving them if they are Missing or Out of Date
+    if (pvsCulling)
+    {
+        std::string pvsFile = mapFile + ".pvs";
+        if (potentiallyVisible.load(pvsFile, map, chunkSize, viewDistance))
+            std::cout << "PVS loaded from " << pvsFile << " in " << potentiallyVisible.getBuildTime() << " ms" << std::endl;
+        else
+        {
+            potentiallyVisible.build(map, chunkSize, viewDistance);
+            std::cout << "PVS built in " << potentiallyVisible.getBuildTime() << " ms on " << jobSystem.size() << " threads" << std::endl;
+            if (!potentiallyVisible.save(pvsFile))
+                std::cout << "Could not save " << pvsFile << std::endl;
+        }
+        std::cout << "PVS: " << potentiallyVisible.getCellCount() << " cells, " << potentiallyVisible.getAverageVisible()
+            << " of " << potentiallyVisible.getChunkCount() << " chunks visible on average, "
+            << potentiallyVisible.getBytes() / 1024 << " KB run length encoded, "
+            << potentiallyVisible.getBitsetBytes() / 1024 << " KB as bitsets" << std::endl;
+    }
 
-    // Intialise Mesh Geometry
-    meshCube.loadOBJ("models/cube.obj");
-    meshCoin.loadOBJ("models/coin.obj");
-    meshBall.loadOBJ("models/ball.obj");
-    meshChassis.loadOBJ("models/chassis.obj");
-    meshBackWheel.loadOBJ("models/back_wheel.obj");
-    meshFrontWheel.loadOBJ("models/front_wheel.obj");
-    meshTurret.loadOBJ("models/turret.obj");
+    // Intialise Mesh Geometry, GPU Buffers are only Created for OpenGL
+    meshCube.loadOBJ("models/cube.obj", !software);
+    meshCoin.loadOBJ("models/coin.obj", !software);
+    meshBall.loadOBJ("models/ball.obj", !software);
+    meshChassis.loadOBJ("models/chassis.obj", !software);
+    meshBackWheel.loadOBJ("models/back_wheel.obj", !software);
+    meshFrontWheel.loadOBJ("models/front_wheel.obj", !software);
+    meshTurret.loadOBJ("models/turret.obj", !software);
+
+    // Build Hierarchies over the Tank's Triangles
+    if (preciseHits)
+    {
+        chassisBVH.build(meshChassis.getPositionData());
+        backWheelBVH.build(meshBackWheel.getPositionData());
+        frontWheelBVH.build(meshFrontWheel.getPositionData());
+        turretBVH.build(meshTurret.getPositionData());
+
+        const MeshBVH* tankBVHs[4] = { &chassisBVH, &backWheelBVH, &frontWheelBVH, &turretBVH };
+        const char* tankParts[4] = { "Chassis", "Back Wheel", "Front Wheel", "Turret" };
+        for (int i = 0; i < 4; i++)
+            std::cout << tankParts[i] << " BVH: " << tankBVHs[i]->getTriangleCount() << " triangles, " << tankBVHs[i]->getNodeCount() << " nodes, "
+                << tankBVHs[i]->getBuildTime() << " ms" << std::endl;
+    }
 
     // Initialise Textures
-    initTexture("models/cube.bmp", textureCube);
-    initTexture("models/coin.bmp", textureCoin);
-    initTexture("models/ball.bmp", textureBall);
-    initTexture("models/tank.bmp", textureTank);
+    textureCube = loadTexture("models/cube.bmp");
+    textureCoin = loadTexture("models/coin.bmp");
+    textureBall = loadTexture("models/ball.bmp");
+    textureTank = loadTexture("models/tank.bmp");
+
+    // Initialise OpenGL Shader and HUD Text
+    if (!software)
+    {
+        GLState::setFiltering(stateCache);
+        if (!glRenderer.init())
+            return -1;
+
+        // GLUT Fonts Need a Window, so Headless Frames have No HUD
+        if (!headless)
+        {
+            if (!textRenderer.init(screenWidth, screenHeight))
+                return -1;
+            initHud();
+        }
+
+        if (bloom && !postProcess.init())
+            return -1;
+
+        if (lightmaps && !glRenderer.initLightmapped())
+            return -1;
+
+        // Fall Back to CPU Built Commands, or to Drawing Each Cell, on Older Contexts
+        if (indirectDrawing && !GpuCulling::isSupported())
+        {
+            std::cout << "Multi draw indirect is not supported, drawing each cell" << std::endl;
+            indirectDrawing = false;
+        }
+        if (indirectDrawing && computeCulling && !GpuCulling::isComputeSupported())
+        {
+            std::cout << "Compute shaders are not supported, culling on the CPU" << std::endl;
+            computeCulling = false;
+        }
+        if (indirectDrawing)
+        {
+            if (!gpuCulling.init(computeCulling))
+                return -1;
+            cubeMeshIndex = gpuCulling.addMesh(meshCube);
+            coinMeshIndex = gpuCulling.addMesh(meshCoin);
+            std::cout << "Maze drawn with multi draw indirect, culled on the " << (computeCulling ? "GPU" : "CPU") << std::endl;
+        }
+
+        if (gpuTiming && !GpuProfiler::init())
+            std::cout << "Timer queries are not supported, no GPU timings" << std::endl;
+
+        if (streaming && streamBuffer.init())
+        {
+            glRenderer.setStreamBuffer(&streamBuffer);
+            textRenderer.setStreamBuffer(&streamBuffer);
+        }
+
+        Shader::PrintStats();
+    }
     
-    // Sets Tank Position, Light Position and Counts Coins
-    for (int z = 0; z < map.size(); z++) {
-        for (int x = 0; x < map[z].size(); x++) {
-            if (map[z][x] == 1 && !tankSet)
-            {
-                tankPosition = Vector3f(x * 2 * 15, groundY, z * 2 * 15);
-                tankSet = true;
-            }
-            if (map[z][x] == 2)
-            {
-                coinsRemaining++;
-            }
-            if (z != 0 && x != 0 && !lightSet)
-            {
-                lightPosition = Vector3f(x * 2 * 15, groundY, z * 2 * 15);
-                lightSet = true;
-            }
+    // Sets Light Position, and Places the Tank and a Pickup on Each Coin, as Found when the Map was Loaded
+    if (map.getWidth() > 1 && map.getDepth() > 1)
+    {
+        lightPosition = Vector3f(1 * 2 * 15, groundY, 1 * 2 * 15);
+        lightSet = true;
+    }
+    spawnEntities();
+
+    // Render Frames on the CPU and Exit
+    if (software)
+    {
+        renderSoftware(softwareFrames, softwareOutput);
+        return 0;
+    }
+
+    startupTime = Profiler::now() - startupStarted;
+    std::cout << "Startup: " << startupTime << " ms" << std::endl;
+
+    // Recorded Input is Stamped with Ticks, so Recording and Playing Back Run Fixed Ticks
+    if (!recordFile.empty() || !replayFile.empty())
+    {
+        if (simulationRate > 0.0)
+            std::cout << "Input is recorded and played back on fixed ticks, --sim-thread ignored" << std::endl;
+        simulationRate = 0.0;
+        fixedStep = true;
+    }
+
+    // Run the Game on its Own Thread, the Main Thread Keeps the GL Context and Input - the Thread Runs its Own Fixed Ticks
+    if (simulationRate > 0.0)
+        fixedStep = false;
+    if (fixedStep)
+    {
+        tickMilliseconds = 1000.0 / tickRate;
+        takeSnapshot(latestTick);
+        previousTick = latestTick;
+        world = latestTick;
+    }
+
+    // Play Back Recorded Input in Place of the Keyboard and Mouse, with Ticks as Long as when it was Recorded
+    if (!replayFile.empty())
+    {
+        if (!inputRecorder.load(replayFile))
+        {
+            std::cout << "Cannot read the recording " << replayFile << std::endl;
+            return -1;
         }
+        tickMilliseconds = inputRecorder.getTickMilliseconds();
+        std::cout << "Replaying " << inputRecorder.getEventCount() << " events over " << inputRecorder.getTickCount() << " ticks of "
+            << tickMilliseconds << " ms from " << replayFile << (replayFast ? ", as fast as possible" : ", in real time") << std::endl;
+        if (inputRecorder.getStartChecksum() != stateChecksum())
+            std::cout << "The recording started from another state, made with a different map or options" << std::endl;
+
+        if (replayFast)
+            return replayRecording() ? 0 : 1;
+    }
+
+    // Record Input, Saving it when the Program Exits
+    else if (!recordFile.empty())
+    {
+        inputRecorder.start(tickMilliseconds, stateChecksum());
+        atexit(finishRecording);
+    }
+    if (simulationRate > 0.0)
+    {
+        fixedFrameTime = 1000.0 / simulationRate;
+        takeSnapshot(latestTick);
+        previousTick = latestTick;
+        simulationThread.start(simulationRate, simulationTick);
+        atexit(stopSimulationThread);
     }
 
+    // Render Frames into the Headless Framebuffer and Exit, Failing if Frames Differ from the Golden Images
+    if (headless)
+        return renderHeadless(headlessFrames) ? 0 : 1;
+
     // Enter Main Loop
     glutMainLoop();
 
-    // Delete Shader Program
-    glDeleteProgram(shaderProgramID);
-
     return 0;
 }
 
@@ -247,20 +830,27 @@ bool initGL(int argc, char** argv)
         return false;
     }
 
-    // Set Display Function
+    // Set Display and Idle Functions
     glutDisplayFunc(display);
+    glutIdleFunc(idle);
+
+    // Set Frame Pacing
+    framePacer.setTargetFps(targetFps);
+    framePacer.setLimiter(frameLimiter);
+    if (vsync && !framePacer.setVsync(true))
+        std::cout << "Swap control is not supported, vsync is off" << std::endl;
 
     glEnable(GL_TEXTURE_2D);
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
 
     // Set Keyboard Interaction Functions
-    glutKeyboardFunc(keyDown);
-    glutKeyboardUpFunc(keyUp);
+    glutKeyboardFunc(liveKeyDown);
+    glutKeyboardUpFunc(liveKeyUp);
 
     // Set Mouse Interaction Functions
-    glutMouseFunc(mouse);
-    glutPassiveMotionFunc(motion);
-    glutMotionFunc(motion);
+    glutMouseFunc(liveMouse);
+    glutPassiveMotionFunc(liveMotion);
+    glutMotionFunc(liveMotion);
     
     // Start Timer Function After 100 milliseconds
     glutTimerFunc(100, Timer, 0);
@@ -268,89 +858,503 @@ bool initGL(int argc, char** argv)
     return true;
 }
 
-// ------------ FUNCTION TO LOAD MAP FROM TEXTFILE ------------ //
+// ------------ FUNCTION TO LOAD MAP FROM TEXTFILE OR BINARY LEVEL ------------ //
 bool loadMap(std::string filename)
 {
-    std::ifstream inputFile(filename);
-    std::string tempString;
-    int tempInt;
+    if (!map.load(filename))
+    {
+        std::cout << "Failed to load " << filename << std::endl;
+        return 0;
+    }
 
-    std::vector<std::vector<int>> tempMap;
+    mapGrid.build(map);
 
-    if (!inputFile.is_open())
-        return 0;
+    return 1;
+}
+
+
+// ------------------------------- FUNCTION TO LOAD TEXTURES ------------------------------- //
+unsigned int loadTexture(std::string filename)
+{
+    // Get Texture Data
+    int width, height;
+    char* data;
+    Texture::LoadBMP(filename, width, height, data);
+
+    unsigned int textureID = renderer->createTexture(width, height, data);
+
+    // Cleanup Data as Copied to the Renderer
+    delete[] data;
+
+    return textureID;
+}
+
+// ------------------------------- FUNCTION TO RENDER FRAMES WITH THE SOFTWARE RENDERER ------------------------------- //
+void renderSoftware(int frames, std::string filename)
+{
+    double startTime = Profiler::now();
+
+    for (int i = 0; i < frames; i++)
+    {
+        Profiler::beginFrame();
+
+        updateGame();
+        takeSnapshot(world);
+        applyMapChanges(world);
+
+        renderer->beginFrame(screenWidth, screenHeight, clearColour);
+        renderScene(*renderer, world);
+        renderer->endFrame();
+
+        Profiler::endFrame();
+    }
+
+    double totalTime = Profiler::now() - startTime;
+    std::cout << "Software renderer: " << frames << " frames at " << screenWidth << "x" << screenHeight
+        << " on " << jobSystem.size() << " threads, " << totalTime / frames << " ms per frame, "
+        << softwareRenderer.getTriangleCount() << " triangles in the last frame" << std::endl;
+
+    // Write the Last Frame
+    bool written;
+    if (filename.size() > 4 && filename.substr(filename.size() - 4) == ".ppm")
+        written = softwareRenderer.writePPM(filename);
+    else
+        written = softwareRenderer.writePNG(filename);
+
+    if (written)
+        std::cout << "Wrote " << filename << std::endl;
+    else
+        std::cout << "Failed to write " << filename << std::endl;
+}
+
+// ------------------------------- FUNCTION TO DECLARE AND RUN THE FRAME'S RENDER PASSES ------------------------------- //
+void renderFrame(const WorldSnapshot& world, GLuint backbuffer, FrameReadback* readback, int frame)
+{
+    renderGraph.reset();
+    int target = renderGraph.importFramebuffer("Backbuffer", backbuffer, screenWidth, screenHeight);
+
+    // Scene, Straight into the Backbuffer Unless it is Post Processed
+    int scene = renderGraph.addPass("Scene", [&world](RenderGraph&) {
+        renderer->beginFrame(screenWidth, screenHeight, clearColour);
+        renderScene(*renderer, world);
+        renderer->endFrame();
+    });
+
+    if (bloom)
+    {
+        RenderGraph::TextureDesc full = { screenWidth, screenHeight, GL_RGBA8 };
+        RenderGraph::TextureDesc depth = { screenWidth, screenHeight, GL_DEPTH_COMPONENT24 };
+        RenderGraph::TextureDesc half = { screenWidth / 2, screenHeight / 2, GL_RGBA8 };
+
+        int sceneColour = renderGraph.write(scene, renderGraph.createTexture("Scene Colour", full));
+        renderGraph.write(scene, renderGraph.createTexture("Scene Depth", depth));
+
+        // Bright Parts at Half Size, Blurred Across then Down - the Last Target Reuses the First's Memory
+        int bright = renderGraph.addPass("Bloom Bright", [sceneColour](RenderGraph& graph) {
+            postProcess.brightPass(graph.getTexture(sceneColour), bloomThreshold);
+        });
+        renderGraph.read(bright, sceneColour);
+        int brightColour = renderGraph.write(bright, renderGraph.createTexture("Bloom Bright", half));
+
+        int blurAcross = renderGraph.addPass("Bloom Blur Across", [brightColour, half](RenderGraph& graph) {
+            postProcess.blur(graph.getTexture(brightColour), 1.0 / half.width, 0.0);
+        });
+        renderGraph.read(blurAcross, brightColour);
+        int acrossColour = renderGraph.write(blurAcross, renderGraph.createTexture("Bloom Across", half));
+
+        int blurDown = renderGraph.addPass("Bloom Blur Down", [acrossColour, half](RenderGraph& graph) {
+            postProcess.blur(graph.getTexture(acrossColour), 0.0, 1.0 / half.height);
+        });
+        renderGraph.read(blurDown, acrossColour);
+        int bloomColour = renderGraph.write(blurDown, renderGraph.createTexture("Bloom", half));
+
+        int composite = renderGraph.addPass("Bloom Composite", [sceneColour, bloomColour](RenderGraph& graph) {
+            postProcess.composite(graph.getTexture(sceneColour), graph.getTexture(bloomColour), bloomIntensity);
+        });
+        renderGraph.read(composite, sceneColour);
+        renderGraph.read(composite, bloomColour);
+        target = renderGraph.write(composite, target);
+    }
+    else
+        target = renderGraph.write(scene, target);
+
+    // 2D Text, GLUT Fonts Need a Window so there is None Headless
+    if (readback == NULL)
+    {
+        int hud = renderGraph.addPass("HUD", [&world](RenderGraph&) {
+            if (batchedText)
+            {
+                updateHud(world);
+                textRenderer.draw();
+            }
+            else
+                renderLegacyHud(world);
+        });
+        target = renderGraph.write(hud, target);
+    }
+    renderGraph.markOutput(target);
+
+    // Copy the Finished Frame Back without Waiting for it
+    if (readback != NULL)
+    {
+        int capture = renderGraph.addPass("Readback", [readback, frame](RenderGraph&) {
+            readback->read(frame);
+        });
+        renderGraph.read(capture, target);
+        renderGraph.setSideEffect(capture);
+    }
+
+    if (!renderGraph.compile())
+        return;
+
+    // Report the Layout whenever it Changes
+    static long long reportedAllocated = -1;
+    static int reportedPasses = -1;
+    if (renderGraph.getAllocatedBytes() != reportedAllocated || renderGraph.getPassCount() != reportedPasses)
+    {
+        reportedAllocated = renderGraph.getAllocatedBytes();
+        reportedPasses = renderGraph.getPassCount();
+        std::cout << "Render graph: " << renderGraph.getPassCount() << " passes, " << renderGraph.getCulledCount() << " culled, transient targets "
+            << renderGraph.getRequestedBytes() / 1024 << " KB requested, " << renderGraph.getAllocatedBytes() / 1024 << " KB allocated, "
+            << (renderGraph.getRequestedBytes() - renderGraph.getAllocatedBytes()) / 1024 << " KB saved by aliasing" << std::endl;
+    }
+
+    renderGraph.execute();
+}
+
+// ------------------------------- FUNCTION TO RENDER FRAMES WITHOUT A WINDOW ------------------------------- //
+bool renderHeadless(int frames)
+{
+    FrameReadback readback;
+    readback.init(screenWidth, screenHeight);
+
+    if (!dumpFrames.empty())
+    {
+#ifdef _WIN32
+        _mkdir(dumpDirectory.c_str());
+#else
+        mkdir(dumpDirectory.c_str(), 0755);
+#endif
+    }
 
-    while (std::getline(inputFile, tempString))
+    // Centre and Size of the Maze for the Scripted Camera
+    Vector3f mazeCentre = Vector3f((map.getWidth() - 1) * 15.0, 0.0, (map.getDepth() - 1) * 15.0);
+    float orbitRadius = std::max(map.getWidth(), map.getDepth()) * 15.0 + 30.0;
+
+    std::vector<double> frameTimes;
+    std::vector<unsigned char> pixels;
+    int capturedFrame;
+    int failures = 0;
+
+    double startTime = Profiler::now();
+    for (int i = 0; i < frames; i++)
     {
-        std::istringstream iss(tempString);
-        std::vector<int> rows;
+        double frameStarted = Profiler::now();
+        Profiler::beginFrame();
+        GpuProfiler::beginFrame();
+
+        if (simulationThread.isRunning())
+            interpolateWorld();
+        else if (fixedStep)
+            stepSimulation(fixedFrameTime);
+        else
+        {
+            updateGame();
+            advanceTimer(fixedFrameTime);
+            takeSnapshot(world);
+        }
+        applyMapChanges(world);
 
-        while (iss >> tempInt)
+        // Scripted Camera: One Orbit Around the Maze, Rising and Falling Twice
+        if (!followTank)
         {
-            rows.push_back(tempInt);
+            float angle = 2.0 * PI * i / frames;
+            world.cameraPosition = Vector3f(mazeCentre.x + orbitRadius * sin(angle), 120.0 + 40.0 * cos(2.0 * angle), mazeCentre.z + orbitRadius * cos(angle));
+            world.cameraTarget = mazeCentre;
         }
-        tempMap.push_back(rows);
+
+        // Collect Finished Frames, Waiting only when Every Readback Buffer is in Use
+        while (readback.retrieve(capturedFrame, pixels, readback.isFull()))
+            if (!captureFrame(capturedFrame, pixels))
+                failures++;
+
+        renderFrame(world, headlessContext.getFramebuffer(), &readback, i);
+
+        if (streaming)
+            streamBuffer.endFrame();
+
+        GpuProfiler::endFrame();
+        GLState::endFrame();
+        Profiler::endFrame();
+        frameTimes.push_back(Profiler::now() - frameStarted);
+        if (simulationThread.isRunning())
+            simulationThread.frameDrawn(world.inputTime);
     }
 
-    map = tempMap;
+    while (readback.retrieve(capturedFrame, pixels, true))
+        if (!captureFrame(capturedFrame, pixels))
+            failures++;
+    double totalTime = Profiler::now() - startTime;
+
+    // Frame Time Statistics
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (int i = 0; i < sorted.size(); i++)
+        sum += sorted[i];
+    int last = sorted.size() - 1;
+
+    std::cout << "Headless: " << frames << " frames at " << screenWidth << "x" << screenHeight << " in " << totalTime << " ms, "
+        << frames * 1000.0 / totalTime << " fps, " << readback.getStalls() << " readback stalls" << std::endl;
+    std::cout << "Frame time (ms): min " << sorted[0] << ", mean " << sum / frames << ", p50 " << sorted[last / 2]
+        << ", p95 " << sorted[last * 95 / 100] << ", p99 " << sorted[last * 99 / 100] << ", max " << sorted[last] << std::endl;
+    std::cout << "Jobs: " << jobSystem.getJobCount() << " run on " << jobSystem.size() << " threads, " << jobSystem.getStealCount() << " stolen" << std::endl;
+
+    if (!scenarioResults.empty())
+        writeScenarioResult(sum / frames, sorted[last * 95 / 100]);
+
+    if (!statsFile.empty())
+    {
+        std::ofstream output(statsFile.c_str());
+        output << "frame,milliseconds\n";
+        for (int i = 0; i < frameTimes.size(); i++)
+            output << i << "," << frameTimes[i] << "\n";
+        if (output)
+            std::cout << "Wrote " << statsFile << std::endl;
+        else
+            std::cout << "Failed to write " << statsFile << std::endl;
+    }
 
-    return 1;
+    // Same Inputs and Ticks Give the Same Checksum, Whatever the Frame Rate
+    if (fixedStep)
+        std::cout << "Simulation: " << ticksRun << " ticks of " << tickMilliseconds << " ms, state checksum "
+            << std::hex << stateChecksum() << std::dec << std::endl;
+    if (inputRecorder.isPlaying() && !replayChecked)
+        std::cout << "Replay: stopped at tick " << ticksRun << " of " << inputRecorder.getTickCount() << ", more frames are needed to reach the end" << std::endl;
+    if (replayChecked && !replayMatched)
+        failures++;
+
+    if (failures > 0)
+        std::cout << failures << " frames failed" << std::endl;
+    return failures == 0;
+}
+
+// ------------------------------- FUNCTION TO WRITE AND COMPARE A READ BACK FRAME ------------------------------- //
+bool captureFrame(int frame, const std::vector<unsigned char>& pixels)
+{
+    if (std::find(dumpFrames.begin(), dumpFrames.end(), frame) == dumpFrames.end())
+        return true;
+
+    char name[32];
+    sprintf_s(name, "frame_%04d.ppm", frame);
+    if (pixels.empty())
+    {
+        std::cout << "Failed to read back " << name << std::endl;
+        return false;
+    }
+
+    std::string filename = dumpDirectory + "/" + name;
+    if (!Image::WritePPM(filename, screenWidth, screenHeight, &pixels[0], screenWidth))
+    {
+        std::cout << "Failed to write " << filename << std::endl;
+        return false;
+    }
+    if (goldenDirectory.empty())
+    {
+        std::cout << "Wrote " << filename << std::endl;
+        return true;
+    }
+
+    // Pixel Difference Against the Golden Image
+    int width, height;
+    std::vector<unsigned char> golden;
+    if (!Image::ReadPPM(goldenDirectory + "/" + name, width, height, golden))
+    {
+        std::cout << "Cannot read " << goldenDirectory << "/" << name << std::endl;
+        return false;
+    }
+    if (width != screenWidth || height != screenHeight)
+    {
+        std::cout << name << ": golden image is " << width << "x" << height << std::endl;
+        return false;
+    }
+
+    int maxDifference;
+    double differing = Image::Compare(&pixels[0], &golden[0], width, height, compareTolerance, maxDifference);
+    bool passed = differing <= compareMaxDiffering;
+    std::cout << name << ": " << differing * 100.0 << "% of pixels differ by more than " << compareTolerance
+        << ", largest difference " << maxDifference << (passed ? ", pass" : ", FAIL") << std::endl;
+    return passed;
 }
 
+// ------------------------------- FUNCTION TO WRITE A GENERATED LEVEL ------------------------------- //
+bool generateLevel(int width, int depth, std::string filename)
+{
+    MazeGenerator generator(generateSeed);
+    generator.generate(width, depth, coinDensity);
+
+    // Binary Levels Load without Parsing
+    bool saved;
+    if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".lvl") == 0)
+    {
+        LevelGrid level;
+        level.setLevel(generator.getWidth(), generator.getDepth(), &generator.getCells()[0]);
+        saved = level.save(filename);
+    }
+    else
+        saved = generator.save(filename);
+    if (!saved)
+    {
+        std::cout << "Failed to write " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "Generated " << filename << ": " << generator.getWidth() << "x" << generator.getDepth() << ", "
+        << generator.getPassageCount() << " wall cells, " << generator.getCoinCount() << " coins, seed " << generateSeed
+        << ", in " << generator.getGenerateTime() << " ms" << std::endl;
+    return true;
+}
 
-// ------------------------------- FUNCTION TO INITIALISE SHADERS ------------------------------- //
-void initShader()
+// ------------------------------- FUNCTION TO RUN EVERY SCENARIO IN A PROCESS OF ITS OWN ------------------------------- //
+bool runScenarios(int argc, char** argv)
 {
-    // Create Shader
-    shaderProgramID = Shader::LoadFromFile("shaders/shader.vert", "shaders/shader.frag");
+#ifdef _WIN32
+    _mkdir("levels/generated");
+#else
+    mkdir("levels/generated", 0755);
+#endif
+
+    // Other Options are Passed On, so Features can be Compared at Every Size
+    std::vector<std::string> options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--scenarios")
+        {
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                i++;
+            continue;
+        }
+        options.push_back(argv[i]);
+    }
+    if (scenarioResults.empty())
+        scenarioResults = "scenarios.csv";
+    remove(scenarioResults.c_str());
 
-    // Attribute Locations
-    vertexPositionAttribute = glGetAttribLocation(shaderProgramID, "aVertexPosition");
-    vertexNormalAttribute = glGetAttribLocation(shaderProgramID, "aVertexNormal");
-    vertexTexCoordAttribute = glGetAttribLocation(shaderProgramID, "aVertexTexCoord");
-    
-    // Uniform Locations
-    ModelViewMatrixUniformLocation = glGetUniformLocation(shaderProgramID, "ModelViewMatrix_uniform");
-    ProjectionMatrixUniformLocation = glGetUniformLocation(shaderProgramID, "ProjectionMatrix_uniform");
+    // A Fresh Process per Level, so Load Times and Peak Memory are its Own
+    int failures = 0;
+    for (int i = 0; i < scenarioSizes.size(); i++)
+    {
+        std::string level = "levels/generated/maze_" + std::to_string(scenarioSizes[i]) + (binaryLevels ? ".lvl" : ".txt");
+        if (!generateLevel(scenarioSizes[i], scenarioSizes[i], level))
+        {
+            failures++;
+            continue;
+        }
+
+        std::vector<std::string> arguments = { argv[0], "--headless", std::to_string(scenarioFrames), "--fixed-step", "--follow-tank",
+            "--map", level, "--scenario-results", scenarioResults };
+        arguments.insert(arguments.end(), options.begin(), options.end());
+        if (runProcess(arguments) != 0)
+        {
+            std::cout << "Scenario " << level << " failed" << std::endl;
+            failures++;
+        }
+    }
 
-    TextureMapUniformLocation = glGetUniformLocation(shaderProgramID, "TextureMap_uniform");
+    // The Scaling Curve
+    std::ifstream results(scenarioResults.c_str());
+    std::string line;
+    std::cout << std::endl;
+    while (std::getline(results, line))
+        std::cout << line << std::endl;
+    std::cout << "Written to " << scenarioResults << std::endl;
+    return failures == 0;
+}
 
-    LightPositionUniformLocation = glGetUniformLocation(shaderProgramID, "LightPosition_uniform");
+// ------------------------------- FUNCTION TO RUN A PROGRAM WITHOUT A SHELL AND WAIT FOR ITS EXIT CODE ------------------------------- //
+int runProcess(const std::vector<std::string>& arguments)
+{
+    // The Arguments Reach the Program as Given, Never Read by a Shell
+#ifdef _WIN32
+    // Windows Hands Over One Command Line, so Each Argument is Quoted as the C Runtime Splits it Back Up -
+    // Backslashes are Doubled Only Before a Quote, which is Escaped
+    std::vector<std::string> quoted(arguments.size());
+    for (int i = 0; i < arguments.size(); i++)
+    {
+        int backslashes = 0;
+        quoted[i] = "\"";
+        for (int c = 0; c < arguments[i].size(); c++)
+        {
+            if (arguments[i][c] == '\\')
+                backslashes++;
+            else
+            {
+                if (arguments[i][c] == '"')
+                    quoted[i].append(backslashes + 1, '\\');
+                backslashes = 0;
+            }
+            quoted[i] += arguments[i][c];
+        }
+        quoted[i].append(backslashes, '\\');
+        quoted[i] += "\"";
+    }
 
-    AmbientUniformLocation = glGetUniformLocation(shaderProgramID, "Ambient_uniform");
-    SpecularUniformLocation = glGetUniformLocation(shaderProgramID, "Specular_uniform");
-    SpecularPowerUniformLocation = glGetUniformLocation(shaderProgramID, "SpecularPower_uniform");
+    std::vector<const char*> pointers;
+    for (int i = 0; i < quoted.size(); i++)
+        pointers.push_back(quoted[i].c_str());
+    pointers.push_back(0);
+    return (int)_spawnvp(_P_WAIT, arguments[0].c_str(), &pointers[0]);
+#else
+    std::vector<char*> pointers;
+    for (int i = 0; i < arguments.size(); i++)
+        pointers.push_back(const_cast<char*>(arguments[i].c_str()));
+    pointers.push_back(0);
+
+    pid_t child;
+    int status;
+    if (posix_spawnp(&child, pointers[0], 0, 0, &pointers[0], environ) != 0)
+        return -1;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status))
+        return -1;
+    return WEXITSTATUS(status);
+#endif
 }
 
-// ------------------------------- FUNCTION TO INITIALISE TEXTURES ------------------------------- //
-void initTexture(std::string filename, GLuint& textureID)
+// ------------------------------- FUNCTION TO ADD THIS RUN'S STATISTICS TO THE SCENARIO RESULTS ------------------------------- //
+void writeScenarioResult(double meanFrameTime, double p95FrameTime)
 {
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    double tickTime = ticksRun > 0 ? tickTimeSpent / ticksRun : 0.0;
+    double peakMegabytes = Profiler::peakMemory() / (1024.0 * 1024.0);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // Restart a Copy, so the Run's Map is Left as it Ended
+    LevelGrid restarted = map;
+    restarted.restart();
 
-    // Get Texture Data
-    int width, height;
-    char* data;
-    Texture::LoadBMP(filename, width, height, data);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGB,
-        width,
-        height,
-        0,
-        GL_RGB,
-        GL_UNSIGNED_BYTE,
-        data
-    );
-
-    // Cleanup Data as Copied to GPU
-    delete[] data;
+    std::cout << "Scenario: " << map.getWidth() << "x" << map.getDepth() << ", loaded in " << mapLoadTime << " ms, map " << mapBytes() / 1024
+        << " KB, restart " << restarted.getRestartTime() << " ms, peak memory " << peakMegabytes << " MB, tick " << tickTime
+        << " ms, frame " << meanFrameTime << " ms" << std::endl;
+
+    // Header Only in a New File
+    bool started;
+    {
+        std::ifstream existing(scenarioResults.c_str());
+        started = existing.peek() != std::ifstream::traits_type::eof();
+    }
+    std::ofstream output(scenarioResults.c_str(), std::ios::app);
+    if (!started)
+        output << "level,width,depth,coins,load_ms,startup_ms,map_kb,restart_ms,peak_memory_mb,ticks,tick_ms,frame_ms,frame_p95_ms\n";
+    output << mapFile << "," << map.getWidth() << "," << map.getDepth() << "," << map.getLevelCoinCount() << "," << mapLoadTime << "," << startupTime << ","
+        << mapBytes() / 1024 << "," << restarted.getRestartTime() << "," << peakMegabytes << "," << ticksRun << "," << tickTime << ","
+        << meanFrameTime << "," << p95FrameTime << "\n";
+    if (!output)
+        std::cout << "Failed to write " << scenarioResults << std::endl;
+}
+
+// ------------------------------- FUNCTION TO COUNT THE BYTES HELD BY THE MAP ------------------------------- //
+long long mapBytes()
+{
+    // The Game's Map and the Map as Drawn, Each with the Level as Loaded
+    return map.getBytes() + renderMap.getBytes();
 }
 
 // Collision Detection Algorithms
@@ -379,68 +1383,98 @@ bool AABBintersectLine(Mesh& mesh, Vector2f line)
 // ------------------------------- DISPLAY LOOP ------------------------------- //
 void display(void)
 {
-    // Handle Keys
-    handleKeys();
+    Profiler::beginFrame();
+    GpuProfiler::beginFrame();
+
+    // Update Input, Camera and Physics, Unless the Simulation Thread is Doing it
+    static double lastFrameStarted = Profiler::now();
+    double frameStarted = Profiler::now();
+    if (simulationThread.isRunning())
+        interpolateWorld();
+    else if (fixedStep)
+        stepSimulation(frameStarted - lastFrameStarted);
+    else
+    {
+        updateGame();
+        takeSnapshot(world);
+    }
+    applyMapChanges(world);
+    lastFrameStarted = frameStarted;
 
-    // Set Viewport
-    glViewport(0, 0, screenWidth, screenHeight);
+    // A Replay Ends the Run Once its Ticks are Done
+    if (replayChecked)
+        exit(replayMatched ? 0 : 1);
 
-    // Clear the Screen
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-   
-    // Set Background Colour
-    glClearColor(0.086, 0.603, 0.854, 1.0);
+    // Draw the Scene and HUD into the Window
+    renderFrame(world, 0, NULL, 0);
 
-    // Use Shader
-    glUseProgram(shaderProgramID);
+    // Fence this Frame's Uploads
+    if (streaming)
+        streamBuffer.endFrame();
+
+    GpuProfiler::endFrame();
+    GLState::endFrame();
+    Profiler::endFrame();
+
+    // Swap Buffers and Schedule the Next Frame
+    glutSwapBuffers();
+    framePacer.frameDrawn();
+    if (simulationThread.isRunning())
+        simulationThread.frameDrawn(world.inputTime);
+}
+
+// ------------------------------- IDLE FUNCTION ------------------------------- //
+void idle(void)
+{
+    // Waits for the Next Frame and Posts a Redisplay if One was Requested
+    framePacer.idle();
+}
+
+// ------------------------------- FUNCTION TO UPDATE THE GAME FOR ONE FRAME ------------------------------- //
+void updateGame()
+{
+    Profiler::beginSection("Game Update");
+
+    // Handle Keys
+    handleKeys();
 
     // Convert Degrees to Radians
-    tankRotationRadians = (tankRotationDegrees * PI) / 180;
-    turretRotationRadians = (turretRotationDegrees * PI) / 180;
+    float turretRotationRadians = (entities.tanks.get(tankEntity).turretRotationDegrees * PI) / 180;
     cameraPanRadians = (cameraPanDegrees * PI) / 180;
     cameraTiltRadians = (cameraTiltDegrees * PI) / 180;
 
     // Calculate Delta Time
-    currentTime = glutGet(GLUT_ELAPSED_TIME);
-    deltaTime = currentTime - lastTime;
-    lastTime = currentTime;
-
-    // Projection Matrix - Perspective Projection
-    ProjectionMatrix.perspective(90, 1.0, 0.1, 1000.0);
-    glUniformMatrix4fv(ProjectionMatrixUniformLocation, 1, false, ProjectionMatrix.getPtr());
-
-    // Set Lighting of Scene
-    glUniform3f(LightPositionUniformLocation, lightPosition.x, lightPosition.y, lightPosition.z);
+    if (fixedStep)
+        deltaTime = tickMilliseconds;
+    else if (fixedFrameTime > 0.0)
+        deltaTime = fixedFrameTime;
+    else
+    {
+        currentTime = Profiler::now();
+        deltaTime = currentTime - lastTime;
+        lastTime = currentTime;
+    }
 
     // Restart the Game
     if (restart && gameOver)
     {      
-        // Reset Map
-        loadMap(mapFile);
+        // Reset Map to the Level as Loaded, without Reading it Again
+        map.restart();
+        mapChanges.clear();
+        mapVersion++;
+        Profiler::addTime("Map Restart", map.getRestartTime());
 
-        // Reset Time and Coins Count
+        // Reset Time, Tank Position and Coins
         timeRemaining = timeLimit;
-        coinsRemaining = 0;
-
-        // Reset Tank Position and Count Coins
-        tankSet = false;
-        for (int z = 0; z < map.size(); z++) {
-            for (int x = 0; x < map[z].size(); x++) {
-                if (map[z][x] == 1 && !tankSet)
-                {
-                    tankPosition = Vector3f(x * 2 * 15, groundY, z * 2 * 15);
-                    tankSet = true;
-                }
-                if (map[z][x] == 2)
-                    coinsRemaining++;
-            }
-        }
+        projectiles.clear();
+        spawnEntities();
 
         restart = false;
         gameOver = false;
     }
     
-    // Calculate Camera Position and Camera Target
+    // Calculate Camera Position and Camera Target, Following the Player's Tank
+    Vector3f tankPosition = entities.transforms.get(tankEntity).position;
     if (thirdPersonCamera)
     {
         // Update Camera Position
@@ -478,180 +1512,120 @@ void display(void)
         cameraTarget.z = tankPosition.z;
     }
     
-    // Calculate Tank Position
-    if (!gameOver)
+    // Move the Wandering Balls, then Check Everything with a Collider Against the Coins - Tanks and Balls where the Last Update Left them
+    Profiler::beginSection("Entity Systems");
+    entities.integrate(deltaTime);
+    entities.bounce(Vector3f(-15.0, 0.0, -15.0), Vector3f(mapGrid.getWidth() * 30.0 - 15.0, 0.0, mapGrid.getDepth() * 30.0 - 15.0));
+    if (preciseHits)
     {
-        // Update Total Tank Force
-        tankForce.x += tankMass * gravity.x;
-        tankForce.y += tankMass * gravity.y;
-        tankForce.x += tankMass * gravity.x;
-
-        // Update Tank Velocity
-        tankVelocity.x += deltaTime * (tankForce.x / tankMass);
-        tankVelocity.y += deltaTime * (tankForce.y / tankMass);
-        tankVelocity.z += deltaTime * (tankForce.z / tankMass);
+        // The Turret and Wheels Turn Past the Chassis' Box, so a Tank's Box is Fitted to its Parts before its Triangles are Tested
+        for (int i = 0; i < entities.tanks.size(); i++)
+        {
+            Entity tank = entities.tanks.ownerAt(i);
+            Vector3f position = entities.transforms.get(tank).position;
+            Vector3f tankMin, tankMax;
+            tankBounds(tank, tankMin, tankMax);
+            entities.colliders.get(tank) = { tankMin - position, tankMax - position };
+        }
+    }
+    entities.collectPickups(coinCollections, preciseHits ? tankTouchesPickup : 0);
+    Profiler::endSection("Entity Systems");
+    Profiler::addCounter("Entities", entities.getEntityCount());
 
-        // Update Tank Position
-        tankPosition.x += deltaTime * tankVelocity.x * sin(tankRotationRadians);
-        tankPosition.y += deltaTime * tankVelocity.y;
-        tankPosition.z += deltaTime * tankVelocity.z * cos(tankRotationRadians);
+    for (int i = 0; i < coinCollections.size(); i++)
+    {
+        takeCoin(coinCollections[i].x, coinCollections[i].z);
+        if (entities.balls.has(coinCollections[i].collector))
+            entities.balls.get(coinCollections[i].collector).launched = false;
     }
 
-    // Draw Maze
-    for (int z = 0; z < map.size(); z++) {
-        for (int x = 0; x < map[z].size(); x++) {
-            if (map[z][x] == 1 || map[z][x] == 2)
-            {
-                // Set Material Properties of Cube
-                glUniform4f(AmbientUniformLocation, 0.1, 0.1, 0.1, 1.0);
-                glUniform4f(SpecularUniformLocation, 0.0, 0.0, 0.0, 1.0);
-                glUniform1f(SpecularPowerUniformLocation, 10);
-
-                // Set Textures of Cube
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, textureCube);
-                glUniform1i(TextureMapUniformLocation, 0);
-
-                // Set Model View Matrix of Cube
-                ModelViewMatrix.toIdentity();
-                ModelViewMatrix.lookAt(
-                    cameraPosition,
-                    cameraTarget,
-                    cameraUp
-                );
-                ModelViewMatrix.scale(15.0, 15.0, 15.0);
-                ModelViewMatrix.translate(x * 2.0, 0.0, z * 2.0);
-                glUniformMatrix4fv(ModelViewMatrixUniformLocation, 1, false, ModelViewMatrix.getPtr());
-
-                // Draw Cube
-                meshCube.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
-            }
-            if (map[z][x] == 2)
-            {
-                // Set Material Properties of Coin
-                glUniform4f(AmbientUniformLocation, 0.24725, 0.1995, 0.0745, 1.0);
-                glUniform4f(SpecularUniformLocation, 0.628281, 0.555802, 0.366065, 1.0);
-                glUniform1f(SpecularPowerUniformLocation, 51.2);
-           
-                // Set Textures of Coin
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, textureCoin);
-                glUniform1i(TextureMapUniformLocation, 0);
-
-                // Set Model View Matrix of Coin
-                ModelViewMatrix.toIdentity();
-                ModelViewMatrix.lookAt(
-                    cameraPosition,
-                    cameraTarget,
-                    cameraUp
-                );
-                ModelViewMatrix.scale(3.0, 3.0, 3.0);
-                ModelViewMatrix.translate(x * 10.0, 7.0, z * 10.0);
-                ModelViewMatrix.rotate(coinRotation, 0.0, 1.0, 0.0);
-                glUniformMatrix4fv(ModelViewMatrixUniformLocation, 1, false, ModelViewMatrix.getPtr());
-
-                // Check Tank Intersects with Coin
-                if (AABBintersectAABB(
-                    meshChassis,
-                    Vector3f(meshCoin.max.x + x * 30.0, meshCoin.min.y + 18.0, meshCoin.max.z + z * 30.0),
-                    Vector3f(meshCoin.min.x + x * 30.0, meshCoin.min.y + 18.0, meshCoin.min.z + z * 30.0))
-                    )
-                {
-                    map[z][x] = 1;
-                    coinsRemaining--;
-                }
-                
-                // Check Ball Intersects with Coin
-                if (AABBintersectAABB(
-                    meshBall,
-                    Vector3f(meshCoin.max.x + x * 30.0, meshCoin.min.y + 18.0, meshCoin.max.z + z * 30.0),
-                    Vector3f(meshCoin.min.x + x * 30.0, meshCoin.min.y + 18.0, meshCoin.min.z + z * 30.0))
-                    )
-                {
-                    map[z][x] = 1;
-                    coinsRemaining--;
-                    launchBall = false;
-                }
+    // Drive the Tanks and Roll the Launched Balls
+    updateTanks();
+    updateBalls();
 
-                // Draw Coin 
-                meshCoin.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
-            }
+    // Fire, Move and Land Shells
+    if (shells)
+        updateShells();
+
+    // Forces Last One Update
+    for (int i = 0; i < entities.bodies.size(); i++)
+        entities.bodies.at(i).force = Vector3f(0.0, 0.0, 0.0);
+
+    // Check Player has Won or Lost
+    if ((entities.pickups.size() == 0 && timeRemaining > 0) || timeRemaining == 0 || entities.transforms.get(tankEntity).position.y < -groundY)
+        gameOver = true;
+
+    Profiler::endSection("Game Update");
+}
+
+// ------------------------------- FUNCTION TO DRIVE EACH TANK ------------------------------- //
+void updateTanks()
+{
+    for (int i = 0; i < entities.tanks.size(); i++)
+    {
+        Entity tank = entities.tanks.ownerAt(i);
+        Transform& transform = entities.transforms.get(tank);
+        Vector3f& tankPosition = transform.position;
+        Vector3f& tankVelocity = entities.velocities.get(tank).linear;
+        Vector3f& tankForce = entities.bodies.get(tank).force;
+        float tankMass = entities.bodies.get(tank).mass;
+        float tankRotationRadians = (transform.rotationDegrees * PI) / 180;
+
+        // Calculate Tank Position
+        if (!gameOver)
+        {
+            // Update Total Tank Force
+            tankForce.x += tankMass * gravity.x;
+            tankForce.y += tankMass * gravity.y;
+            tankForce.x += tankMass * gravity.x;
+
+            // Update Tank Velocity
+            tankVelocity.x += deltaTime * (tankForce.x / tankMass);
+            tankVelocity.y += deltaTime * (tankForce.y / tankMass);
+            tankVelocity.z += deltaTime * (tankForce.z / tankMass);
+
+            // Update Tank Position
+            tankPosition.x += deltaTime * tankVelocity.x * sin(tankRotationRadians);
+            tankPosition.y += deltaTime * tankVelocity.y;
+            tankPosition.z += deltaTime * tankVelocity.z * cos(tankRotationRadians);
         }
-    } 
 
-    // Detect Tank On Top of Cube
-    for (int z = 0; z < map.size(); z++) {
-        for (int x = 0; x < map[z].size(); x++) {
-            if (map[z][x] != 0)
+        // Detect Tank On Top of Cube
+        int cellX, cellZ;
+        if (mapGrid.cellUnder(tankPosition, cellX, cellZ))
+        {
+            // Tank On Cube Surface
+            if (tankPosition.y < groundY)
             {
-                // Tank Inside of Cube
-                if (tankPosition.x > ((x * 30) - 15) && tankPosition.x < ((x * 30) + 15) &&
-                    tankPosition.z > ((z * 30) - 15) && tankPosition.z < ((z * 30) + 15))
-                {
-                    // Tank On Cube Surface
-                    if (tankPosition.y < groundY)
-                    {
-                        tankPosition.y = groundY;
-                        tankForce.y = 0.0;
-                        tankVelocity.y = 0.0;
-                        tankFalling = false;
-                    }
-                }
-
-                // Tank Outside of Cube
-                else if (tankPosition.y < groundY)
-                    tankFalling = true;
-               
+                tankPosition.y = groundY;
+                tankForce.y = 0.0;
+                tankVelocity.y = 0.0;
+                entities.tanks.at(i).falling = false;
             }
         }
-    }
-
-    // Set Material Properties of Tank
-    glUniform4f(AmbientUniformLocation, 0.135, 0.2225, 0.1575, 0.95);
-    glUniform4f(SpecularUniformLocation, 0.316228, 0.316228, 0.316228, 0.95);
-    glUniform1f(SpecularPowerUniformLocation, 12.8);
 
-    // Set Textures of Tank
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureTank);
-    glUniform1i(TextureMapUniformLocation, 0);
-
-    // Set Model View Matrix of Tank
-    ModelViewMatrix.toIdentity();
-    ModelViewMatrix.lookAt(
-        cameraPosition,
-        cameraTarget,
-        cameraUp
-    );
-    ModelViewMatrix.translate(tankPosition.x, tankPosition.y, tankPosition.z);
-    ModelViewMatrix.rotate(tankRotationDegrees, 0.0, 1.0, 0.0);
-    glUniformMatrix4fv(ModelViewMatrixUniformLocation, 1, false, ModelViewMatrix.getPtr());
-
-    // Update AABB of Tank after Transformations
-    meshChassis.transformAABB(tankPosition, Vector3f(1.0, 1.0, 1.0));
+        // Tank Outside of Every Cube
+        else if (tankPosition.y < groundY && mapGrid.hasWalls())
+            entities.tanks.at(i).falling = true;
+    }
+}
 
-    // Draw Tank
-    meshChassis.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
-    meshBackWheel.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
-    meshFrontWheel.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
+// ------------------------------- FUNCTION TO MOVE EACH LAUNCHED BALL ------------------------------- //
+void updateBalls()
+{
+    for (int i = 0; i < entities.balls.size(); i++)
+    {
+        Ball& ball = entities.balls.at(i);
+        if (!ball.launched)
+            continue;
 
-    // Set Model View Matrix of Turret
-    ModelViewMatrix.toIdentity();
-    ModelViewMatrix.lookAt(
-        cameraPosition,
-        cameraTarget,
-        cameraUp
-    );
-    ModelViewMatrix.translate(tankPosition.x, tankPosition.y, tankPosition.z);
-    ModelViewMatrix.rotate(turretRotationDegrees, 0.0, 1.0, 0.0);
-    glUniformMatrix4fv(ModelViewMatrixUniformLocation, 1, false, ModelViewMatrix.getPtr());
+        Entity entity = entities.balls.ownerAt(i);
+        Vector3f& ballPosition = entities.transforms.get(entity).position;
+        Vector3f& ballVelocity = entities.velocities.get(entity).linear;
+        Vector3f& ballForce = entities.bodies.get(entity).force;
+        float ballMass = entities.bodies.get(entity).mass;
+        float turretRotationRadians = (entities.tanks.get(ball.tank).turretRotationDegrees * PI) / 180;
 
-    // Draw Turret
-    meshTurret.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);
-    
-    // Launch Ball
-    if (launchBall)
-    {
         // Update Ball Force
         ballForce.x += ballMass * gravity.x;
         ballForce.y += ballMass * gravity.y;
@@ -663,120 +1637,914 @@ void display(void)
         ballVelocity.z += deltaTime * (ballForce.z / ballMass);
 
         // Update Ball Position
+        Vector3f ballStart = ballPosition;
         ballPosition.x += deltaTime * ballVelocity.x * sin(turretRotationRadians);
         ballPosition.y += deltaTime * ballVelocity.y;
         ballPosition.z += deltaTime * ballVelocity.z * cos(turretRotationRadians);
 
-        // Detect Ball On Top of Cube
-        for (int z = 0; z < map.size(); z++) {
-            for (int x = 0; x < map[z].size(); x++) {
-                if (map[z][x] != 0)
-                {
-                    // Ball Inside of Cube
-                    if (ballPosition.x > ((x * 30) - 15) && ballPosition.x < ((x * 30) + 15) &&
-                        ballPosition.z > ((z * 30) - 15) && ballPosition.z < ((z * 30) + 15))
-                    {
-                        // Ball On Cube Surface
-                        if (ballPosition.y < 15.5)
-                        {
-                            ballPosition.y = 15.5;
-                            ballForce.y = 0.0;
-                            ballVelocity.y = 0.0;
-                        }      
-                    }
-                    
-                    // Ball Outside of Cube and Below a Cube
-                    else if (ballPosition.y < -30)
-                        launchBall = false;
-                }
+        // Sweep the Step through the Cells it Crosses, so a Fast Ball Cannot Pass through a Wall or Coin
+        SweptCollision::Hit hit;
+        int cellsCrossed;
+        bool hitCoin = false;
+        if (sweptCollision && SweptCollision::sweep(mapGrid, ballStart, ballPosition,
+            Vector3f(-15.0, -15.5, -15.0), Vector3f(15.0, 15.5, 15.0),
+            Vector3f(meshCoin.min.x - meshBall.max.x, meshCoin.min.y + 18.0 - meshBall.max.y, meshCoin.min.z - meshBall.max.z),
+            Vector3f(meshCoin.max.x - meshBall.min.x, meshCoin.min.y + 18.0 - meshBall.min.y, meshCoin.max.z - meshBall.min.z),
+            hit, cellsCrossed))
+        {
+            // Stop Just Short of what was Hit
+            ballPosition = ballStart + (ballPosition - ballStart) * std::max(hit.time - 0.001f, 0.0f);
+
+            // Ball Hits a Coin, Taken Once the Ball is Done with, as Taking it Moves Components
+            if (hit.coin)
+            {
+                hitCoin = true;
+                ball.launched = false;
+            }
+
+            // Ball Lands On Cube Surface
+            else if (hit.axis == 1)
+            {
+                ballPosition.y = 15.5;
+                ballForce.y = 0.0;
+                ballVelocity.y = 0.0;
             }
+
+            // Ball Hits the Side of a Cube and Drops
+            else
+            {
+                ballVelocity.x = 0.0;
+                ballVelocity.z = 0.0;
+            }
+        }
+        if (sweptCollision)
+            Profiler::addCounter("Ball Cells Swept", cellsCrossed);
+
+        // Detect Ball On Top of Cube
+        int cellX, cellZ;
+        bool ballOverCube = mapGrid.cellUnder(ballPosition, cellX, cellZ);
+
+        // Ball Fallen Below the Maze Stops if a Cube Comes Before the Cell it is Over in Row Order, or if it is Over No Cube and Any Exists
+        if (ballPosition.y < -30 && (ballOverCube ? mapGrid.hasWallBefore(cellX, cellZ) : mapGrid.hasWalls()))
+            ball.launched = false;
+
+        // Ball On Cube Surface
+        if (ballOverCube && ballPosition.y < 15.5)
+        {
+            ballPosition.y = 15.5;
+            ballForce.y = 0.0;
+            ballVelocity.y = 0.0;
         }
 
-        // Set Material Properties of Ball
-        glUniform4f(AmbientUniformLocation, 0.02, 0.02, 0.02, 1.0);
-        glUniform4f(SpecularUniformLocation, 0.4, 0.4, 0.4, 1.0);
-        glUniform1f(SpecularPowerUniformLocation, 10.0);
-        
-        // Set Textures of Ball
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureBall);
-        glUniform1i(TextureMapUniformLocation, 0);
+        if (hitCoin)
+            takeCoin(hit.x, hit.z);
+    }
+}
+
+// ------------------------------- FUNCTION TO TAKE THE COIN IN A CELL ------------------------------- //
+void takeCoin(int x, int z)
+{
+    // Its Pickup Goes, if Not Already Collected, and its Cell Becomes a Plain Cube
+    entities.destroy(entities.getPickup(x, z));
+    map.set(x, z, 1);
+    mapChanges.push_back({ x, z, 1 });
+}
+
+// ------------------------------- FUNCTION TO FIRE, MOVE AND LAND SHELLS ------------------------------- //
+void updateShells()
+{
+    Vector3f tankPosition = entities.transforms.get(tankEntity).position;
+    float turretRotationRadians = (entities.tanks.get(tankEntity).turretRotationDegrees * PI) / 180;
+    Vector3f muzzle = Vector3f(tankPosition.x, tankPosition.y + 3, tankPosition.z);
+
+    // Fire along the Turret while E is Held
+    shellCooldown = std::max(shellCooldown - deltaTime, 0.0f);
+    if (shellTrigger && shellCooldown == 0.0)
+    {
+        Vector3f velocity = Vector3f(shellSpeed * sin(turretRotationRadians), shellLift, shellSpeed * cos(turretRotationRadians));
+        if (projectiles.fire(muzzle, velocity, shellLifetime) >= 0)
+            shellsFired++;
+        shellCooldown = shellInterval;
+    }
+    shellTrigger = false;
+
+    // Keep the Barrage Topped Up, Spread Around the Tank by the Golden Angle
+    while (projectiles.getLiveCount() < shellBarrage)
+    {
+        float angle = shellsFired * 2.39996;
+        float speed = shellSpeed * (0.25 + 0.75 * (shellsFired % 97) / 96.0);
+        if (projectiles.fire(muzzle, Vector3f(speed * sin(angle), shellLift, speed * cos(angle)), shellLifetime) < 0)
+            break;
+        shellsFired++;
+    }
+
+    Profiler::beginSection("Shells Integrate");
+    projectiles.integrate(deltaTime, gravity);
+    Profiler::endSection("Shells Integrate");
+
+    // Shells Land on Walls at the Height the Ball Rolls, and Burst on Coins Just Above
+    Profiler::beginSection("Shells Collide");
+    projectiles.collide(mapGrid, 15.5, meshCoin.max.y + 18.0, -30.0);
+    Profiler::endSection("Shells Collide");
+
+    // Shells Landing on Coins Collect them
+    for (int i = 0; i < projectiles.getLandingCount(); i++)
+    {
+        int x, z, value;
+        projectiles.getLanding(i, x, z, value);
+        if (value == 2 && entities.getPickup(x, z) != 0)
+            takeCoin(x, z);
+    }
+    Profiler::addCounter("Shells Live", projectiles.getLiveCount());
+}
+
+// ------------------------------- FUNCTION TO PLACE THE TANK'S MESHES IN THE WORLD ------------------------------- //
+void tankMatrices(Entity tank, Matrix4x4& body, Matrix4x4& turret)
+{
+    // As the Tank is Drawn, without the View
+    const Transform& transform = entities.transforms.get(tank);
+    body.toIdentity();
+    body.translate(transform.position.x, transform.position.y, transform.position.z);
+    body.rotate(transform.rotationDegrees, 0.0, 1.0, 0.0);
+
+    turret.toIdentity();
+    turret.translate(transform.position.x, transform.position.y, transform.position.z);
+    turret.rotate(entities.tanks.get(tank).turretRotationDegrees, 0.0, 1.0, 0.0);
+}
+
+// ------------------------------- FUNCTION TO FIND THE BOX AROUND THE WHOLE TANK ------------------------------- //
+void tankBounds(Entity tank, Vector3f& min, Vector3f& max)
+{
+    Matrix4x4 body, turret;
+    tankMatrices(tank, body, turret);
+
+    const MeshBVH* parts[4] = { &chassisBVH, &backWheelBVH, &frontWheelBVH, &turretBVH };
+    for (int i = 0; i < 4; i++)
+    {
+        Vector3f partMin, partMax;
+        parts[i]->getBounds(i < 3 ? body : turret, partMin, partMax);
+        min = i == 0 ? partMin : Vector3f(std::min(min.x, partMin.x), std::min(min.y, partMin.y), std::min(min.z, partMin.z));
+        max = i == 0 ? partMax : Vector3f(std::max(max.x, partMax.x), std::max(max.y, partMax.y), std::max(max.z, partMax.z));
+    }
+}
+
+// ------------------------------- FUNCTION TO TEST THE TANK'S TRIANGLES AGAINST A BOX ------------------------------- //
+bool tankTouchesBox(Entity tank, Vector3f min, Vector3f max)
+{
+    Matrix4x4 body, turret;
+    tankMatrices(tank, body, turret);
+
+    return chassisBVH.intersectsBox(body, min, max) || backWheelBVH.intersectsBox(body, min, max) ||
+        frontWheelBVH.intersectsBox(body, min, max) || turretBVH.intersectsBox(turret, min, max);
+}
+
+// ------------------------------- FUNCTION TO TEST WHAT TOUCHES A PICKUP'S BOX AGAINST THE PICKUP ------------------------------- //
+bool tankTouchesPickup(Entity collector, const Pickup& pickup)
+{
+    // Tanks by their Triangles, Anything Else by its Box Alone
+    return !entities.tanks.has(collector) || tankTouchesBox(collector, pickup.min, pickup.max);
+}
+
+// ------------------------------- FUNCTION TO MAKE THE ENTITIES FOR THE LOADED MAP ------------------------------- //
+void spawnEntities()
+{
+    // The Player's Tank and its Ball the First Time
+    if (!entities.isAlive(tankEntity))
+    {
+        tankEntity = entities.create();
+        entities.transforms.add(tankEntity, { Vector3f(0.0, 0.0, 0.0), 0.0 });
+        entities.velocities.add(tankEntity, { Vector3f(0.0, 0.0, 0.0) });
+        entities.bodies.add(tankEntity, { Vector3f(0.0, 0.0, 0.0), tankMass });
+        entities.tanks.add(tankEntity, { 0.0, false });
+        entities.colliders.add(tankEntity, { meshChassis.min, meshChassis.max });
+
+        ballEntity = entities.create();
+        entities.transforms.add(ballEntity, { Vector3f(0.0, 0.0, 0.0), 0.0 });
+        entities.velocities.add(ballEntity, { Vector3f(0.0, 0.0, 0.0) });
+        entities.bodies.add(ballEntity, { Vector3f(0.0, 0.0, 0.0), ballMass });
+        entities.balls.add(ballEntity, { tankEntity, false });
+        entities.colliders.add(ballEntity, { meshBall.min, meshBall.max });
+    }
+
+    // Everything Else is Made Again, while the Tank Keeps its Heading, Turret and Speed, and the Ball Stays where it Is
+    std::vector<Entity> others;
+    for (int i = 0; i < entities.transforms.size(); i++)
+        if (entities.transforms.ownerAt(i) != tankEntity && entities.transforms.ownerAt(i) != ballEntity)
+            others.push_back(entities.transforms.ownerAt(i));
+    for (int i = 0; i < others.size(); i++)
+        entities.destroy(others[i]);
+    entities.setPickupGrid(mapGrid.getWidth(), mapGrid.getDepth(), 30.0);
+
+    // Tank Back to the Spawn, if the Map has One
+    int spawnX, spawnZ;
+    if (map.getSpawn(spawnX, spawnZ))
+        entities.transforms.get(tankEntity).position = Vector3f(spawnX * 2 * 15, groundY, spawnZ * 2 * 15);
+
+    // A Pickup for Each Coin, its Box Flat at the Coin's Height
+    std::vector<int> coins;
+    map.getCoins(coins);
+    for (int i = 0; i < coins.size(); i++)
+    {
+        int x = coins[i] % map.getWidth();
+        int z = coins[i] / map.getWidth();
+        entities.addPickup(x, z, Vector3f(x * 30.0, 0.0, z * 30.0),
+            Vector3f(meshCoin.min.x, meshCoin.min.y + 18.0, meshCoin.min.z), Vector3f(meshCoin.max.x, meshCoin.min.y + 18.0, meshCoin.max.z));
+    }
+
+    // Wandering Balls Scattered over the Maze at Coin Height, from a Fixed Seed so Runs Match
+    unsigned int seed = 1;
+    auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for (int i = 0; i < wandererCount; i++)
+    {
+        float angle = random() * 2.0 * PI;
+        Entity wanderer = entities.create();
+        entities.transforms.add(wanderer, { Vector3f(random() * mapGrid.getWidth() * 30.0 - 15.0, meshCoin.min.y + 18.0, random() * mapGrid.getDepth() * 30.0 - 15.0), 0.0 });
+        entities.velocities.add(wanderer, { Vector3f(cos(angle) * wandererSpeed, 0.0, sin(angle) * wandererSpeed) });
+        entities.colliders.add(wanderer, { meshBall.min * 0.5, meshBall.max * 0.5 });
+        entities.renderables.add(wanderer, { ballMeshId, 0.5 });
+    }
+}
+
+// ------------------------------- FUNCTION TO COPY OUT WHAT IS DRAWN ------------------------------- //
+void takeSnapshot(WorldSnapshot& snapshot)
+{
+    static long long ticks = 0;
+    snapshot.tick = ticks++;
+    snapshot.time = Profiler::now();
+    snapshot.inputTime = lastInputTime;
+
+    // The Player's Tank and Ball
+    snapshot.tankPosition = entities.transforms.get(tankEntity).position;
+    snapshot.tankRotationDegrees = entities.transforms.get(tankEntity).rotationDegrees;
+    snapshot.turretRotationDegrees = entities.tanks.get(tankEntity).turretRotationDegrees;
+
+    snapshot.ballPosition = entities.transforms.get(ballEntity).position;
+    snapshot.launchBall = entities.balls.get(ballEntity).launched;
+    projectiles.getPositions(snapshot.shellPositions);
+    entities.gatherPositions(ballMeshId, snapshot.wandererPositions);
+
+    snapshot.cameraPosition = cameraPosition;
+    snapshot.cameraTarget = cameraTarget;
+    snapshot.thirdPersonCamera = thirdPersonCamera;
+    snapshot.firstPersonCamera = firstPersonCamera;
+    snapshot.freeThirdPersonCamera = freeThirdPersonCamera;
+
+    snapshot.coinRotation = coinRotation;
+    snapshot.coinsRemaining = entities.pickups.size();
+    snapshot.timeRemaining = timeRemaining;
+
+    snapshot.playerWon = snapshot.coinsRemaining == 0 && timeRemaining > 0;
+    snapshot.outOfTime = timeRemaining == 0;
+    snapshot.tankFell = snapshot.tankPosition.y < -groundY;
+
+    // Reuses the Vector's Capacity, so Only Grows while Coins are Collected
+    snapshot.mapVersion = mapVersion;
+    snapshot.mapChanges = mapChanges;
+}
+
+// ------------------------------- FUNCTION TO BRING THE DRAWN MAZE UP TO DATE ------------------------------- //
+void applyMapChanges(const WorldSnapshot& snapshot)
+{
+    if (snapshot.mapVersion != renderMapVersion || snapshot.mapChanges.size() < renderMapChanges)
+    {
+        renderMap.restart();
+        renderMapVersion = snapshot.mapVersion;
+        renderMapChanges = 0;
+        litCoins = -1;
+    }
+
+    for (; renderMapChanges < snapshot.mapChanges.size(); renderMapChanges++)
+    {
+        const MapChange& change = snapshot.mapChanges[renderMapChanges];
+        renderMap.set(change.x, change.z, change.value);
+    }
+}
+
+// ------------------------------- FUNCTION FOR ONE TICK OF THE SIMULATION THREAD ------------------------------- //
+void simulationTick()
+{
+    {
+        std::lock_guard<std::mutex> lock(gameMutex);
+
+        updateGame();
+        advanceTimer(fixedFrameTime);
+        takeSnapshot(snapshots.write());
+    }
+    snapshots.publish();
+}
+
+// ------------------------------- FUNCTION TO STOP THE SIMULATION THREAD WHEN THE PROGRAM EXITS ------------------------------- //
+void stopSimulationThread()
+{
+    // Runs before Any Global is Destroyed, so No Tick Outlives the State it Updates
+    simulationThread.stop();
+}
+
+// ------------------------------- FUNCTION TO BLEND THE LAST TWO TICKS FOR THIS FRAME ------------------------------- //
+void interpolateWorld()
+{
+    if (snapshots.update())
+    {
+        previousTick = latestTick;
+        latestTick = snapshots.read();
+    }
+
+    // Draw a Tick Behind, Moving from the Previous Tick to the Latest over One Tick Interval
+    float t = (Profiler::now() - latestTick.time) / simulationThread.getTickInterval();
+    if (t > 1.0 || previousTick.mapVersion != latestTick.mapVersion)
+        t = 1.0;
+
+    blendTicks(previousTick, latestTick, t, world);
+}
+
+// ------------------------------- FUNCTION TO BLEND TWO TICKS, t = 0 GIVING THE PREVIOUS ------------------------------- //
+void blendTicks(const WorldSnapshot& previous, const WorldSnapshot& latest, float t, WorldSnapshot& blended)
+{
+    auto lerp = [t](Vector3f from, Vector3f to) { return from + (to - from) * t; };
+
+    blended = latest;
+    blended.tankPosition = lerp(previous.tankPosition, latest.tankPosition);
+    blended.tankRotationDegrees = previous.tankRotationDegrees + (latest.tankRotationDegrees - previous.tankRotationDegrees) * t;
+    blended.turretRotationDegrees = previous.turretRotationDegrees + (latest.turretRotationDegrees - previous.turretRotationDegrees) * t;
+    blended.cameraPosition = lerp(previous.cameraPosition, latest.cameraPosition);
+    blended.cameraTarget = lerp(previous.cameraTarget, latest.cameraTarget);
+    blended.coinRotation = previous.coinRotation + (latest.coinRotation - previous.coinRotation) * t;
+    if (previous.launchBall)
+        blended.ballPosition = lerp(previous.ballPosition, latest.ballPosition);
+}
+
+// ------------------------------- FUNCTION TO RUN WHOLE TICKS FOR THE TIME A FRAME TOOK ------------------------------- //
+void stepSimulation(double milliseconds)
+{
+    // Each Tick Integrates, then Runs the 10 ms Timer with its Damping for the Same Simulated Time
+    tickAccumulator += milliseconds;
+    int ticks = 0;
+    while (tickAccumulator >= tickMilliseconds && ticks < maxCatchUpTicks && !replayFinished())
+    {
+        runTick();
+        tickAccumulator -= tickMilliseconds;
+        ticks++;
+    }
+
+    // A Finished Replay Holds its Last Tick
+    if (replayFinished())
+    {
+        tickAccumulator = 0.0;
+        previousTick = latestTick;
+        if (!replayChecked)
+            checkReplay();
+    }
+
+    // Too Far Behind: Drop the Time rather than Spending Ever Longer Catching Up
+    if (tickAccumulator >= tickMilliseconds)
+    {
+        Profiler::addCounter("Ticks Dropped", floor(tickAccumulator / tickMilliseconds));
+        tickAccumulator = fmod(tickAccumulator, tickMilliseconds);
+    }
+    Profiler::addCounter("Ticks per Frame", ticks);
+
+    // Draw the Part of a Tick the Accumulator has Reached, Snapping when the Map was Reloaded
+    float t = tickAccumulator / tickMilliseconds;
+    if (previousTick.mapVersion != latestTick.mapVersion)
+        t = 1.0;
+    blendTicks(previousTick, latestTick, t, world);
+}
+
+// ------------------------------- FUNCTION TO RUN ONE FIXED TICK ------------------------------- //
+void runTick()
+{
+    // Recorded Input Goes in Ahead of the Tick it was Stamped with, as it Arrived Live
+    feedRecordedInput();
+
+    double started = Profiler::now();
+    previousTick = latestTick;
+    updateGame();
+    advanceTimer(tickMilliseconds);
+    takeSnapshot(latestTick);
+    ticksRun++;
+    tickTimeSpent += Profiler::now() - started;
+}
+
+// ------------------------------- FUNCTION TO TELL WHETHER A REPLAY HAS RUN ALL ITS TICKS ------------------------------- //
+bool replayFinished()
+{
+    return inputRecorder.isPlaying() && inputRecorder.isFinished((unsigned int)ticksRun);
+}
+
+// ------------------------------- FUNCTION TO PLAY BACK RECORDED INPUT WITHOUT DRAWING ------------------------------- //
+bool replayRecording()
+{
+    double started = Profiler::now();
+    while (!replayFinished())
+    {
+        Profiler::beginFrame();
+        runTick();
+        Profiler::endFrame();
+    }
+    double elapsed = Profiler::now() - started;
+
+    std::cout << "Replay: " << ticksRun << " ticks in " << elapsed << " ms, " << (ticksRun > 0 ? elapsed / ticksRun : 0.0) << " ms per tick, "
+        << (elapsed > 0.0 ? ticksRun * tickMilliseconds / elapsed : 0.0) << " times real time" << std::endl;
+    return checkReplay();
+}
+
+// ------------------------------- FUNCTION TO COMPARE THE STATE AT THE END OF A REPLAY WITH THE RECORDING ------------------------------- //
+bool checkReplay()
+{
+    // Input after the Last Tick Still Reached the State the Recording Saved
+    feedRecordedInput();
+
+    unsigned long long checksum = stateChecksum();
+    replayChecked = true;
+    replayMatched = checksum == inputRecorder.getFinalChecksum();
+    std::cout << "Replay: " << ticksRun << " ticks, state checksum " << std::hex << checksum;
+    if (replayMatched)
+        std::cout << ", matches the recording";
+    else
+        std::cout << ", DIFFERS from the recording's " << inputRecorder.getFinalChecksum();
+    std::cout << std::dec << std::endl;
+    return replayMatched;
+}
+
+// ------------------------------- FUNCTION TO HAND RECORDED INPUT TO THE INPUT HANDLERS ------------------------------- //
+void feedRecordedInput()
+{
+    InputEvent event;
+    while (inputRecorder.next((unsigned int)ticksRun, event))
+    {
+        if (event.type == InputEvent::KeyDown)
+            keyDown(event.key, event.x, event.y);
+        else if (event.type == InputEvent::KeyUp)
+            keyUp(event.key, event.x, event.y);
+        else if (event.type == InputEvent::MouseButton)
+            mouse(event.key, event.state, event.x, event.y);
+        else
+            motion(event.x, event.y);
+    }
+}
+
+// ------------------------------- FUNCTION TO SAVE THE RECORDED INPUT WITH THE STATE IT REACHED ------------------------------- //
+void finishRecording()
+{
+    if (!inputRecorder.isRecording())
+        return;
+
+    if (inputRecorder.save(recordFile, (unsigned int)ticksRun, stateChecksum()))
+        std::cout << "Recorded " << inputRecorder.getEventCount() << " events over " << ticksRun << " ticks into " << recordFile << ", "
+            << inputRecorder.getBytes() << " bytes, state checksum " << std::hex << inputRecorder.getFinalChecksum() << std::dec << std::endl;
+    else
+        std::cout << "Failed to write " << recordFile << std::endl;
+}
+
+// ------------------------------- FUNCTION TO HASH THE SIMULATED STATE ------------------------------- //
+unsigned long long stateChecksum()
+{
+    // FNV-1a over the Exact Bits, so Any Difference in Any Tick Shows
+    unsigned long long hash = 14695981039346656037ull;
+    auto add = [&hash](const void* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            hash = (hash ^ ((const unsigned char*)data)[i]) * 1099511628211ull;
+    };
+
+    // Recordings Keep the Result, so the Fields, their Order and their Sizes are Fixed - Changing Any of them Invalidates Every Recording
+    // The Player's Tank and Ball, Field by Field
+    add(&entities.transforms.get(tankEntity).position, sizeof(Vector3f));
+    add(&entities.velocities.get(tankEntity).linear, sizeof(Vector3f));
+    add(&entities.transforms.get(tankEntity).rotationDegrees, sizeof(float));
+    add(&entities.tanks.get(tankEntity).turretRotationDegrees, sizeof(float));
+    add(&entities.tanks.get(tankEntity).falling, sizeof(bool));
+    add(&entities.transforms.get(ballEntity).position, sizeof(Vector3f));
+    add(&entities.velocities.get(ballEntity).linear, sizeof(Vector3f));
+    add(&entities.balls.get(ballEntity).launched, sizeof(bool));
+    std::vector<Vector3f> shellPositions;
+    projectiles.getPositions(shellPositions);
+    if (!shellPositions.empty())
+        add(&shellPositions[0], shellPositions.size() * sizeof(Vector3f));
+    std::vector<Vector3f> wandererPositions;
+    entities.gatherPositions(ballMeshId, wandererPositions);
+    if (!wandererPositions.empty())
+        add(&wandererPositions[0], wandererPositions.size() * sizeof(Vector3f));
+    add(&coinRotation, sizeof(coinRotation));
+    int coinsRemaining = entities.pickups.size();
+    add(&coinsRemaining, sizeof(coinsRemaining));
+    add(&timeRemaining, sizeof(timeRemaining));
+    add(&timerTime, sizeof(timerTime));
+    add(&gameOver, sizeof(gameOver));
+    // Cells Widened to Ints, Part of the Same Fixed Layout
+    std::vector<int> row(map.getWidth());
+    for (int z = 0; z < map.getDepth(); z++)
+    {
+        for (int x = 0; x < map.getWidth(); x++)
+            row[x] = map.getRow(z)[x];
+        if (!row.empty())
+            add(&row[0], row.size() * sizeof(int));
+    }
+    return hash;
+}
+
+// ------------------------------- FUNCTION TO DRAW THE SCENE ------------------------------- //
+void renderScene(Renderer& renderer, const WorldSnapshot& world)
+{
+    // Projection Matrix - Perspective Projection
+    ProjectionMatrix.perspective(90, 1.0, 0.1, 1000.0);
+    renderer.setProjection(ProjectionMatrix);
+
+    // Set Lighting of Scene
+    renderer.setLight(lightPosition);
+
+    // View Matrix
+    Matrix4x4 viewMatrix;
+    viewMatrix.lookAt(world.cameraPosition, world.cameraTarget, cameraUp);
+
+    // Assign Coin Lights to Clusters of this View
+    if (pointLights)
+    {
+        updateCoinLights(world);
+        clusteredLighting.update(viewMatrix, ProjectionMatrix, 1000.0);
+        renderer.setPointLights(clusteredLighting);
+    }
+
+    // Baked Walls Follow the Map and the Coins Left
+    if (lightmaps && &renderer == &glRenderer)
+        updateLightmap();
+
+    // Maze and Coins, Culled and Submitted by the GPU when it Can
+    Profiler::beginSection("Maze Submit");
+    if (indirectDrawing && &renderer == &glRenderer)
+        renderMazeIndirect(world, viewMatrix);
+    else
+        renderMaze(renderer, world, viewMatrix);
+    Profiler::endSection("Maze Submit");
+
+    GpuProfiler::beginSection("Tank");
+
+    // Set Material and Texture of Tank
+    renderer.setMaterial(tankMaterial);
+    renderer.setTexture(textureTank);
+
+    // Set Model View Matrix of Tank
+    ModelViewMatrix = viewMatrix;
+    ModelViewMatrix.translate(world.tankPosition.x, world.tankPosition.y, world.tankPosition.z);
+    ModelViewMatrix.rotate(world.tankRotationDegrees, 0.0, 1.0, 0.0);
+
+    // Draw Tank
+    renderer.drawMesh(meshChassis, ModelViewMatrix);
+    renderer.drawMesh(meshBackWheel, ModelViewMatrix);
+    renderer.drawMesh(meshFrontWheel, ModelViewMatrix);
+
+    // Set Model View Matrix of Turret
+    ModelViewMatrix = viewMatrix;
+    ModelViewMatrix.translate(world.tankPosition.x, world.tankPosition.y, world.tankPosition.z);
+    ModelViewMatrix.rotate(world.turretRotationDegrees, 0.0, 1.0, 0.0);
+
+    // Draw Turret
+    renderer.drawMesh(meshTurret, ModelViewMatrix);
+    GpuProfiler::endSection("Tank");
+
+    if (world.launchBall)
+    {
+        GpuProfiler::beginSection("Ball");
+
+        // Set Material and Texture of Ball
+        renderer.setMaterial(ballMaterial);
+        renderer.setTexture(textureBall);
 
         // Set Model View Matrix of Ball
-        ModelViewMatrix.toIdentity();
-        ModelViewMatrix.lookAt(
-            cameraPosition,
-            cameraTarget,
-            cameraUp
-        );       
+        ModelViewMatrix = viewMatrix;
         ModelViewMatrix.scale(0.5, 0.5, 0.5);
-        ModelViewMatrix.translate(ballPosition.x * 2, ballPosition.y * 2, ballPosition.z * 2);       
-        glUniformMatrix4fv(ModelViewMatrixUniformLocation, 1, false, ModelViewMatrix.getPtr());
+        ModelViewMatrix.translate(world.ballPosition.x * 2, world.ballPosition.y * 2, world.ballPosition.z * 2);
 
-        // Update AABB of Ball after Transformations
-        meshBall.transformAABB(ballPosition * 2, Vector3f(0.5, 0.5, 0.5));
+        // Draw Ball
+        renderer.drawMesh(meshBall, ModelViewMatrix);
+        GpuProfiler::endSection("Ball");
+    }
 
-        // Draw Ball       
-        meshBall.draw(vertexPositionAttribute, vertexNormalAttribute, vertexTexCoordAttribute);        
+    if (!world.shellPositions.empty())
+    {
+        GpuProfiler::beginSection("Shells");
+        renderBalls(renderer, world.shellPositions, viewMatrix);
+        GpuProfiler::endSection("Shells");
     }
-       
-    // 2D Text
-    char timeRemainingString[100];
-    sprintf_s(timeRemainingString, "Time: %.2f", timeRemaining);
 
-    char coinsRemainingString[100];
-    sprintf_s(coinsRemainingString, "Coins Remaining: %d", coinsRemaining);
+    if (!world.wandererPositions.empty())
+    {
+        GpuProfiler::beginSection("Wanderers");
+        renderBalls(renderer, world.wandererPositions, viewMatrix);
+        GpuProfiler::endSection("Wanderers");
+    }
+}
 
-    render2dText(timeRemainingString, 1.0, 1.0, 1.0, -0.98, 0.92);
-    render2dText(coinsRemainingString, 1.0, 1.0, 1.0, -0.98, 0.86);
+// ------------------------------- FUNCTION TO DRAW BALLS AT HALF SIZE ------------------------------- //
+void renderBalls(Renderer& renderer, const std::vector<Vector3f>& positions, Matrix4x4 viewMatrix)
+{
+    // All in One Instanced Draw through GL
+    if (&renderer == &glRenderer)
+    {
+        ballInstances.clear();
+        for (int i = 0; i < positions.size(); i++)
+        {
+            ballInstances.push_back(positions[i].x);
+            ballInstances.push_back(positions[i].y);
+            ballInstances.push_back(positions[i].z);
+            ballInstances.push_back(0.5);
+        }
+        glRenderer.setInstancing(true, viewMatrix);
+        glRenderer.setMaterial(ballMaterial);
+        glRenderer.setTexture(textureBall);
+        glRenderer.drawMeshInstanced(meshBall, ballInstances);
+        glRenderer.setInstancing(false, viewMatrix);
+    }
+    else
+    {
+        renderer.setMaterial(ballMaterial);
+        renderer.setTexture(textureBall);
+        for (int i = 0; i < positions.size(); i++)
+        {
+            Vector3f position = positions[i];
+            ModelViewMatrix = viewMatrix;
+            ModelViewMatrix.scale(0.5, 0.5, 0.5);
+            ModelViewMatrix.translate(position.x * 2, position.y * 2, position.z * 2);
+            renderer.drawMesh(meshBall, ModelViewMatrix);
+        }
+    }
+}
 
-    if (thirdPersonCamera)
-        render2dText("Camera: Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
-    else if (firstPersonCamera)
-        render2dText("Camera: First Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
-    else if (freeThirdPersonCamera)
-        render2dText("Camera: Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+// ------------------------------- FUNCTION TO DRAW THE MAZE CELL BY CELL ------------------------------- //
+void renderMaze(Renderer& renderer, const WorldSnapshot& world, Matrix4x4 viewMatrix)
+{
+    // Draw Maze Cubes Around the Camera as Occluders into the Software Depth Buffer, Any Outside the Frustum Dropped as they are Added
+    if (occlusionCulling)
+    {
+        occlusionCuller.beginFrame(ProjectionMatrix * viewMatrix);
+
+        int eyeX = (int)floor((world.cameraPosition.x + 15.0) / 30.0);
+        int eyeZ = (int)floor((world.cameraPosition.z + 15.0) / 30.0);
+        for (int z = std::max(eyeZ - occluderRange, 0); z <= std::min(eyeZ + occluderRange, renderMap.getDepth() - 1); z++) {
+            const unsigned char* cells = renderMap.getRow(z);
+            for (int x = std::max(eyeX - occluderRange, 0); x <= std::min(eyeX + occluderRange, renderMap.getWidth() - 1); x++) {
+                if (cells[x] != 0)
+                    occlusionCuller.addOccluder(Vector3f(x * 30 - 15, -15, z * 30 - 15), Vector3f(x * 30 + 15, 15, z * 30 + 15));
+            }
+        }
+        occlusionCuller.rasterise();
+    }
 
-    render2dText("Press 1 to change to First Person Camera", 1.0, 1.0, 1.0, -0.98, -0.50);
-    render2dText("Press 2 to change to Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, -0.56);
-    render2dText("Press 3 to change to Thrid Person Camera", 1.0, 1.0, 1.0, -0.98, -0.62);
-   
+    int mapWidth = renderMap.getWidth();
 
-    // Check Player has Won or Lost
-    if (coinsRemaining == 0 && timeRemaining > 0)
+    // Chunks Out of Sight of the Cell Under the Camera are Rejected before Any Other Test
+    bool pvsActive = pvsCulling && potentiallyVisible.setView(world.cameraPosition);
+    int pvsRejected = 0;
+    int cubesDrawn = 0;
+
+    // Coins in Visible Cells, Drawn after the Maze so Each Pass is Timed on its Own
+    static std::vector<std::pair<int, int>> visibleCoins;
+    visibleCoins.clear();
+
+    // Walls with Baked Lighting go Out in One Draw, Leaving Only the Coins to Find
+    bool bakedWalls = lightmaps && &renderer == &glRenderer;
+
+    // Cull Each Row of Chunks and Build its Cubes' Matrices as a Job, Skipping Chunks and Cells Hidden Behind Occluders
+    int chunkRows = (renderMap.getDepth() + chunkSize - 1) / chunkSize;
+    if (visibleRows.size() < chunkRows)
+        visibleRows.resize(chunkRows);
+
+    Profiler::beginSection("Maze Cull");
+    double cullStarted = Profiler::now();
+    jobSystem.parallelFor(chunkRows, [&](int begin, int end)
     {
-        char wonMessage[100];
-        sprintf_s(wonMessage, "You collected all the coins in %.2f seconds", 60.0 - timeRemaining);
-        render2dText("YOU WON!", 0.0, 1.0, 0.0, -0.15, 0.5);
-        render2dText(wonMessage, 0.0, 1.0, 0.0, -0.46, 0.44);
-        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.32);
-        gameOver = true;
-        
+        for (int row = begin; row < end; row++)
+        {
+            VisibleCells& visible = visibleRows[row];
+            visible.cubes.clear();
+            visible.coins.clear();
+            visible.pvsRejected = 0;
+
+            int chunkZ = row * chunkSize;
+            for (int chunkX = 0; chunkX < mapWidth; chunkX += chunkSize) {
+                if (pvsActive && !potentiallyVisible.isChunkVisible(chunkX / chunkSize, chunkZ / chunkSize))
+                {
+                    visible.pvsRejected++;
+                    continue;
+                }
+
+                bool chunkVisible = !occlusionCulling || occlusionCuller.isVisible(
+                    Vector3f(chunkX * 30 - 15, -15, chunkZ * 30 - 15),
+                    Vector3f((chunkX + chunkSize - 1) * 30 + 15, 24, (chunkZ + chunkSize - 1) * 30 + 15));
+                if (!chunkVisible)
+                    continue;
+
+                for (int z = chunkZ; z < chunkZ + chunkSize && z < renderMap.getDepth(); z++) {
+                    const unsigned char* cells = renderMap.getRow(z);
+                    for (int x = chunkX; x < chunkX + chunkSize && x < mapWidth; x++) {
+                        if (cells[x] == 0)
+                            continue;
+
+                        if (occlusionCulling && !occlusionCuller.isVisible(
+                                Vector3f(x * 30 - 15, -15, z * 30 - 15),
+                                Vector3f(x * 30 + 15, cells[x] == 2 ? 24 : 15, z * 30 + 15)))
+                            continue;
+
+                        if (!bakedWalls && (cells[x] == 1 || cells[x] == 2))
+                        {
+                            // Model View Matrix of Cube
+                            Matrix4x4 cubeMatrix = viewMatrix;
+                            cubeMatrix.scale(15.0, 15.0, 15.0);
+                            cubeMatrix.translate(x * 2.0, 0.0, z * 2.0);
+                            visible.cubes.push_back(cubeMatrix);
+                        }
+                        if (cells[x] == 2)
+                            visible.coins.push_back(std::make_pair(x, z));
+                    }
+                }
+            }
+        }
+    });
+    if (occlusionCulling)
+        occlusionCuller.addTestTime(Profiler::now() - cullStarted);     // The Whole Pass, Matrices and All, as Tests are Too Quick to Time Each
+    Profiler::endSection("Maze Cull");
+
+    // Draw Here, as Only this Thread Uses GL
+    GpuProfiler::beginSection("Maze");
+    if (bakedWalls)
+        renderBakedWalls(viewMatrix);
+    for (int row = 0; row < chunkRows; row++)
+    {
+        const VisibleCells& visible = visibleRows[row];
+        for (int i = 0; i < visible.cubes.size(); i++)
+        {
+            // Set Material and Texture of Cube
+            renderer.setMaterial(cubeMaterial);
+            renderer.setTexture(textureCube);
+
+            // Draw Cube
+            renderer.drawMesh(meshCube, visible.cubes[i]);
+        }
+        cubesDrawn += (int)visible.cubes.size();
+        pvsRejected += visible.pvsRejected;
+        visibleCoins.insert(visibleCoins.end(), visible.coins.begin(), visible.coins.end());
     }
-    if (timeRemaining == 0)
+    GpuProfiler::endSection("Maze");
+
+    if (occlusionCulling)
+        occlusionCuller.reportStats();
+    if (pvsCulling)
+        Profiler::addCounter("PVS Chunks Rejected", pvsRejected);
+    Profiler::addCounter("Maze Cubes Drawn", cubesDrawn);
+    Profiler::addCounter("Maze Coins Drawn", (double)visibleCoins.size());
+
+    GpuProfiler::beginSection("Coins");
+    for (int i = 0; i < visibleCoins.size(); i++)
     {
-        char gameOverMessage[100];
-        sprintf_s(gameOverMessage, "You run out of time and had %d coins left", coinsRemaining);
-        render2dText("GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.5);
-        render2dText(gameOverMessage, 1.0, 0.0, 0.0, -0.4, 0.44);
-        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.41, 0.32);
-        gameOver = true;
+        int x = visibleCoins[i].first;
+        int z = visibleCoins[i].second;
+
+        // Set Material and Texture of Coin
+        renderer.setMaterial(coinMaterial);
+        renderer.setTexture(textureCoin);
+
+        // Set Model View Matrix of Coin
+        ModelViewMatrix = viewMatrix;
+        ModelViewMatrix.scale(3.0, 3.0, 3.0);
+        ModelViewMatrix.translate(x * 10.0, 7.0, z * 10.0);
+        ModelViewMatrix.rotate(world.coinRotation, 0.0, 1.0, 0.0);
+
+        // Draw Coin
+        renderer.drawMesh(meshCoin, ModelViewMatrix);
     }
-    if (tankPosition.y < -groundY)
+    GpuProfiler::endSection("Coins");
+}
+
+// ------------------------------- FUNCTION TO DRAW THE MAZE WITH INDIRECT DRAWS ------------------------------- //
+void renderMazeIndirect(const WorldSnapshot& world, Matrix4x4 viewMatrix)
+{
+    // Rebuild Instances Only when the Map Changes
+    if (culledMapVersion != renderMapVersion || culledMapChanges != renderMapChanges)
     {
-        render2dText("GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.2);
-        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.14);
-        gameOver = true;
+        culledMapVersion = renderMapVersion;
+        culledMapChanges = renderMapChanges;
+
+        int mapWidth = renderMap.getWidth();
+
+        // One Chunk of Cubes and One of Coins for Each Block of Cells
+        gpuCulling.clearInstances();
+        for (int chunkZ = 0; chunkZ < renderMap.getDepth(); chunkZ += chunkSize) {
+            for (int chunkX = 0; chunkX < mapWidth; chunkX += chunkSize) {
+                for (int mesh = 0; mesh < 2; mesh++) {
+                    int chunk = -1;
+                    for (int z = chunkZ; z < chunkZ + chunkSize && z < renderMap.getDepth(); z++) {
+                        const unsigned char* cells = renderMap.getRow(z);
+                        for (int x = chunkX; x < chunkX + chunkSize && x < mapWidth; x++) {
+                            if (mesh == 0 && (cells[x] == 1 || cells[x] == 2))
+                            {
+                                if (chunk < 0)
+                                    chunk = gpuCulling.addChunk(cubeMeshIndex);
+                                gpuCulling.addInstance(chunk, Vector3f(x * 30.0, 0.0, z * 30.0), 15.0);
+                            }
+                            if (mesh == 1 && cells[x] == 2)
+                            {
+                                if (chunk < 0)
+                                    chunk = gpuCulling.addChunk(coinMeshIndex);
+                                gpuCulling.addInstance(chunk, Vector3f(x * 30.0, 21.0, z * 30.0), 3.0);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        gpuCulling.uploadInstances();
     }
 
-    tankForce = Vector3f(0.0, 0.0, 0.0);
-    ballForce = Vector3f(0.0, 0.0, 0.0);
+    // Culling Leaves its Own Program Bound, so Instancing is Set before the Material
+    gpuCulling.cull(ProjectionMatrix * viewMatrix);
 
-    // Swap Buffers and Post Redisplay
-    glutSwapBuffers();
-    glutPostRedisplay();
+    GLuint position = glRenderer.getVertexPositionAttribute();
+    GLuint normal = glRenderer.getVertexNormalAttribute();
+    GLuint texCoord = glRenderer.getVertexTexCoordAttribute();
+    GLuint instance = glRenderer.getInstanceAttribute();
+
+    GpuProfiler::beginSection("Maze");
+    if (lightmaps)
+        renderBakedWalls(viewMatrix);
+    else
+    {
+        glRenderer.setInstancing(true, viewMatrix);
+        glRenderer.setMaterial(cubeMaterial);
+        glRenderer.setTexture(textureCube);
+        gpuCulling.draw(cubeMeshIndex, position, normal, texCoord, instance);
+    }
+    GpuProfiler::endSection("Maze");
+
+    GpuProfiler::beginSection("Coins");
+    glRenderer.setInstancing(true, viewMatrix, world.coinRotation * PI / 180.0);
+    glRenderer.setMaterial(coinMaterial);
+    glRenderer.setTexture(textureCoin);
+    gpuCulling.draw(coinMeshIndex, position, normal, texCoord, instance);
+    GpuProfiler::endSection("Coins");
+
+    glRenderer.setInstancing(false, viewMatrix);
+}
+
+// ------------------------------- FUNCTION TO GATHER THE COIN LIGHTS ------------------------------- //
+void updateCoinLights(const WorldSnapshot& world)
+{
+    // Lights Only Change when a Coin is Collected or the Game Restarts
+    if (world.coinsRemaining == litCoins)
+        return;
+    litCoins = world.coinsRemaining;
+    clusteredLighting.setLights(gatherCoinLights());
+}
+
+// ------------------------------- FUNCTION TO LIST A LIGHT ABOVE EACH COIN ------------------------------- //
+std::vector<PointLight> gatherCoinLights()
+{
+    std::vector<PointLight> lights;
+    std::vector<int> coins;
+    renderMap.getCoins(coins);
+    for (int i = 0; i < coins.size(); i++)
+    {
+        PointLight light;
+        light.position = Vector3f(coins[i] % renderMap.getWidth() * 30.0, 24.0, coins[i] / renderMap.getWidth() * 30.0);
+        light.colour = coinLightColour;
+        light.radius = coinLightRadius;
+        lights.push_back(light);
+    }
+    return lights;
 }
 
+// ------------------------------- FUNCTION TO BAKE THE WALL LIGHTING ------------------------------- //
+void updateLightmap()
+{
+    // Only the Faces Near Collected Coins are Baked Again, All of them for a New Map
+    if (bakedMapVersion == renderMapVersion && bakedMapChanges == renderMapChanges)
+        return;
+    bakedMapVersion = renderMapVersion;
+    bakedMapChanges = renderMapChanges;
+
+    lightmapBaker.setSun(sunDirection, sunColour);
+    lightmapBaker.setSky(skyColour);
+    if (!lightmapBaker.update(renderMap, gatherCoinLights()))
+        return;
+    lightmapBaker.upload();
+
+    if (lightmapBaker.getBuildCount() != reportedBakes)
+    {
+        reportedBakes = lightmapBaker.getBuildCount();
+        std::cout << "Lightmap baked: " << lightmapBaker.getFaceCount() << " faces, "
+            << lightmapBaker.getAtlasWidth() << "x" << lightmapBaker.getAtlasHeight() << " atlas, "
+            << lightmapBaker.getBytes() / 1024 << " KB, " << lightmapBaker.getBakeTime() << " ms on "
+            << jobSystem.size() << " threads" << std::endl;
+    }
+}
+
+// ------------------------------- FUNCTION TO DRAW THE WALLS WITH BAKED LIGHTING ------------------------------- //
+void renderBakedWalls(Matrix4x4 viewMatrix)
+{
+    glRenderer.setLightmapped(true, viewMatrix, cubeMaterial, textureCube, lightmapBaker.getTexture());
+    lightmapBaker.draw(ProjectionMatrix * viewMatrix, glRenderer.getLightmapPositionAttribute(),
+        glRenderer.getLightmapTexCoordAttribute(), glRenderer.getLightmapAttribute());
+    glRenderer.setLightmapped(false, viewMatrix, cubeMaterial, 0, 0);
+}
 
 // ------- FUNCTION FOR KEYBOARD INTERACTION ------- //
 void keyDown(unsigned char key, int x, int y)
@@ -786,15 +2554,19 @@ void keyDown(unsigned char key, int x, int y)
         exit(0);
 
     // Set Key Satus
+    std::lock_guard<std::mutex> lock(gameMutex);
     keyStates[key] = true;
+    lastInputTime = Profiler::now();
 
-    glutPostRedisplay();
+    framePacer.requestRedisplay();
 }
 
 // ------- FUNCTION FOR KEY UP EVENTS ------- //
 void keyUp(unsigned char key, int x, int y)
 {
+    std::lock_guard<std::mutex> lock(gameMutex);
     keyStates[key] = false;
+    lastInputTime = Profiler::now();
   
 }
 
@@ -802,6 +2574,10 @@ void keyUp(unsigned char key, int x, int y)
 // ---------------- FUNCTION FOR KEYBOARD BUFFERING ---------------- //
 void handleKeys()
 {
+    // The Keys Drive the Player's Tank
+    Transform& tank = entities.transforms.get(tankEntity);
+    Vector3f& tankForce = entities.bodies.get(tankEntity).force;
+
     // Move Forward
     if (keyStates['W'] || keyStates['w'])
     {
@@ -818,22 +2594,28 @@ void handleKeys()
 
     // Rotate Tank Left
     if (keyStates['A'] || keyStates['a'])
-        tankRotationDegrees += 0.3;
+        tank.rotationDegrees += 0.3;
     
     // Rotate Tank Right
     if (keyStates['D'] || keyStates['d'])
-        tankRotationDegrees -= 0.3;
+        tank.rotationDegrees -= 0.3;
+
+    // Fire Shells
+    if ((keyStates['E'] || keyStates['e']) && shells)
+        shellTrigger = true;
 
     // Launch Ball
-    if (keyStates['E'] || keyStates['e'])
+    else if (keyStates['E'] || keyStates['e'])
     {
-        ballPosition.x = tankPosition.x;
-        ballPosition.y = tankPosition.y + 3;
-        ballPosition.z = tankPosition.z;
+        Vector3f& ballPosition = entities.transforms.get(ballEntity).position;
+        ballPosition.x = tank.position.x;
+        ballPosition.y = tank.position.y + 3;
+        ballPosition.z = tank.position.z;
 
+        Vector3f& ballForce = entities.bodies.get(ballEntity).force;
         ballForce.x = 0.0006;
         ballForce.z = 0.0006;
-        launchBall = true;
+        entities.balls.get(ballEntity).launched = true;
     }
 
     // Change to Third Person Camera
@@ -868,6 +2650,9 @@ void handleKeys()
 // ------- FUNCTION FOR MOUSE BUTTON INTERACTION ------- //
 void mouse(int button, int state, int x, int y)
 {
+    std::lock_guard<std::mutex> lock(gameMutex);
+    lastInputTime = Profiler::now();
+
     currentButton = button;
     currentState = state;
 
@@ -890,12 +2675,15 @@ void mouse(int button, int state, int x, int y)
     if (distanceFromTank < 5)
         distanceFromTank = 5;
 
-    glutPostRedisplay();
+    framePacer.requestRedisplay();
 }
 
 // --------------------- FUNCTION FOR MOUSE MOTION INTERACTION --------------------- //
 void motion(int x, int y)
 {
+    std::lock_guard<std::mutex> lock(gameMutex);
+    lastInputTime = Profiler::now();
+
     // Motion
     float xMotion = (float)x - previousMousePositionX;
     float yMotion = (float)y - previousMousePositionY;
@@ -912,7 +2700,7 @@ void motion(int x, int y)
     // Sets Turret Rotation
     if (currentButton == GLUT_RIGHT_BUTTON && currentState == GLUT_DOWN)
     {
-        turretRotationDegrees -= (xMotion * 0.1 * deltaTime);
+        entities.tanks.get(tankEntity).turretRotationDegrees -= (xMotion * 0.1 * deltaTime);
     }
 
     // Sets Turret Rotation
@@ -929,21 +2717,76 @@ void motion(int x, int y)
         cameraTiltDegrees = 0;
 
     // Camera Pan Ranges
+    float tankRotationDegrees = entities.transforms.get(tankEntity).rotationDegrees;
     if (cameraPanDegrees > 180 + tankRotationDegrees)
         cameraPanDegrees = 180 + tankRotationDegrees;
     if (cameraPanDegrees < -180 + tankRotationDegrees)
         cameraPanDegrees = -180 + tankRotationDegrees;
 
-    glutPostRedisplay();
+    framePacer.requestRedisplay();
+}
+
+// ------- FUNCTIONS FOR INPUT FROM GLUT, RECORDED, OR IGNORED WHILE A RECORDING PLAYS ------- //
+void liveKeyDown(unsigned char key, int x, int y)
+{
+    // Escape Still Quits, and is Left Out of Recordings
+    if (key != 27)
+    {
+        if (inputRecorder.isPlaying())
+            return;
+        InputEvent event = { (unsigned int)ticksRun, InputEvent::KeyDown, key, 0, 0, 0 };
+        inputRecorder.add(event);
+    }
+    keyDown(key, x, y);
+}
+
+void liveKeyUp(unsigned char key, int x, int y)
+{
+    if (inputRecorder.isPlaying())
+        return;
+    InputEvent event = { (unsigned int)ticksRun, InputEvent::KeyUp, key, 0, 0, 0 };
+    inputRecorder.add(event);
+    keyUp(key, x, y);
+}
+
+void liveMouse(int button, int state, int x, int y)
+{
+    if (inputRecorder.isPlaying())
+        return;
+    InputEvent event = { (unsigned int)ticksRun, InputEvent::MouseButton, (unsigned char)button, (unsigned char)state, x, y };
+    inputRecorder.add(event);
+    mouse(button, state, x, y);
+}
+
+void liveMotion(int x, int y)
+{
+    if (inputRecorder.isPlaying())
+        return;
+    InputEvent event = { (unsigned int)ticksRun, InputEvent::MouseMotion, 0, 0, x, y };
+    inputRecorder.add(event);
+    motion(x, y);
 }
 
 // -------------- FUNCTION FOR TIMER -------------- //
 void Timer(int value)
+{
+    // The Simulation Thread and Fixed Ticks Run their Own Timer Ticks
+    if (!simulationThread.isRunning() && !fixedStep)
+        timerTick();
+
+    // Call Function Again After 10 milliseconds
+    glutTimerFunc(10, Timer, 0);
+
+    framePacer.requestRedisplay();
+}
+
+// ------------------------------- FUNCTION FOR GAME WORK DONE EVERY 10 MILLISECONDS ------------------------------- //
+void timerTick()
 {
     if (!gameOver)
     {
         // Calculates Time Remaining
-        if (coinsRemaining > 0)
+        if (entities.pickups.size() > 0)
             timeRemaining -= 0.01;
         if (timeRemaining < 0)
             timeRemaining = 0;
@@ -952,30 +2795,162 @@ void Timer(int value)
     // Speed of Coin Rotation
     coinRotation += 1.0;
 
-    // Sets Velocity of Tank to Rest
-    if (tankVelocity.x != 0)
-        tankVelocity.x -= tankVelocity.x * (1.0 / 20.0);
-    if (tankVelocity.z != 0)
-        tankVelocity.z -= tankVelocity.z * (1.0 /20.0);
+    for (int i = 0; i < entities.tanks.size(); i++)
+    {
+        Vector3f& tankVelocity = entities.velocities.get(entities.tanks.ownerAt(i)).linear;
 
+        // Sets Velocity of Tank to Rest
+        if (tankVelocity.x != 0)
+            tankVelocity.x -= tankVelocity.x * (1.0 / 20.0);
+        if (tankVelocity.z != 0)
+            tankVelocity.z -= tankVelocity.z * (1.0 /20.0);
 
-    
-    // Sets Velocity of Tank to 0 By Higher Constant
-    if (tankFalling)
-    {
-        if (tankVelocity.x > 0)
-            tankVelocity.x -= tankVelocity.x * (1.0 / 2.0);
-        if (tankVelocity.z > 0)
-            tankVelocity.z -= tankVelocity.z * (1.0 / 2.0);
+        // Sets Velocity of Tank to 0 By Higher Constant
+        if (entities.tanks.at(i).falling)
+        {
+            if (tankVelocity.x > 0)
+                tankVelocity.x -= tankVelocity.x * (1.0 / 2.0);
+            if (tankVelocity.z > 0)
+                tankVelocity.z -= tankVelocity.z * (1.0 / 2.0);
+        }
     }
 
     // Gets Time Elapsed Since Start of Program
     currentTime += 0.01;
+}
 
-    // Call Function Again After 10 milliseconds
-    glutTimerFunc(10, Timer, 0);
+// ------------------------------- FUNCTION TO RUN TIMER TICKS FOR SIMULATED TIME ------------------------------- //
+void advanceTimer(float milliseconds)
+{
+    for (timerTime += milliseconds; timerTime >= 10.0; timerTime -= 10.0)
+        timerTick();
+}
+
+// ----------------------- FUNCTION TO CREATE THE HUD STRINGS ----------------------- //
+void initHud()
+{
+    hudTimeText = textRenderer.createString();
+    hudCoinsText = textRenderer.createString();
+    hudCameraText = textRenderer.createString();
+    for (int i = 0; i < 3; i++)
+    {
+        hudHelpText[i] = textRenderer.createString();
+        hudResultText[i] = textRenderer.createString();
+    }
+    for (int i = 0; i < 2; i++)
+        hudFallText[i] = textRenderer.createString();
+
+    // Help Never Changes
+    textRenderer.setString(hudHelpText[0], "Press 1 to change to First Person Camera", 1.0, 1.0, 1.0, -0.98, -0.50);
+    textRenderer.setString(hudHelpText[1], "Press 2 to change to Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, -0.56);
+    textRenderer.setString(hudHelpText[2], "Press 3 to change to Thrid Person Camera", 1.0, 1.0, 1.0, -0.98, -0.62);
+}
+
+// ----------------------- FUNCTION TO UPDATE THE HUD STRINGS THAT CHANGED ----------------------- //
+void updateHud(const WorldSnapshot& world)
+{
+    char text[100];
 
-    glutPostRedisplay();
+    // Only Format Numbers when their Displayed Value Changes
+    int timeCentiseconds = (int)floor(world.timeRemaining * 100.0 + 0.5);
+    if (timeCentiseconds != shownTimeCentiseconds)
+    {
+        sprintf_s(text, "Time: %.2f", world.timeRemaining);
+        textRenderer.setString(hudTimeText, text, 1.0, 1.0, 1.0, -0.98, 0.92);
+        shownTimeCentiseconds = timeCentiseconds;
+    }
+    if (world.coinsRemaining != shownCoinsRemaining)
+    {
+        sprintf_s(text, "Coins Remaining: %d", world.coinsRemaining);
+        textRenderer.setString(hudCoinsText, text, 1.0, 1.0, 1.0, -0.98, 0.86);
+        shownCoinsRemaining = world.coinsRemaining;
+    }
+
+    if (world.thirdPersonCamera)
+        textRenderer.setString(hudCameraText, "Camera: Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+    else if (world.firstPersonCamera)
+        textRenderer.setString(hudCameraText, "Camera: First Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+    else if (world.freeThirdPersonCamera)
+        textRenderer.setString(hudCameraText, "Camera: Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+
+    // Result Messages only Change when the Game Ends or Restarts
+    int result = (world.playerWon ? 1 : 0) | (world.outOfTime ? 2 : 0) | (world.tankFell ? 4 : 0);
+    if (result != shownResult)
+    {
+        for (int i = 0; i < 3; i++)
+            textRenderer.setVisible(hudResultText[i], false);
+        for (int i = 0; i < 2; i++)
+            textRenderer.setVisible(hudFallText[i], false);
+
+        if (world.playerWon)
+        {
+            sprintf_s(text, "You collected all the coins in %.2f seconds", 60.0 - world.timeRemaining);
+            textRenderer.setString(hudResultText[0], "YOU WON!", 0.0, 1.0, 0.0, -0.15, 0.5);
+            textRenderer.setString(hudResultText[1], text, 0.0, 1.0, 0.0, -0.46, 0.44);
+            textRenderer.setString(hudResultText[2], "Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.32);
+        }
+        if (world.outOfTime)
+        {
+            sprintf_s(text, "You run out of time and had %d coins left", world.coinsRemaining);
+            textRenderer.setString(hudResultText[0], "GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.5);
+            textRenderer.setString(hudResultText[1], text, 1.0, 0.0, 0.0, -0.4, 0.44);
+            textRenderer.setString(hudResultText[2], "Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.41, 0.32);
+        }
+        if (world.tankFell)
+        {
+            textRenderer.setString(hudFallText[0], "GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.2);
+            textRenderer.setString(hudFallText[1], "Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.14);
+        }
+        shownResult = result;
+    }
+
+    Profiler::addCounter("HUD Strings Rebuilt", textRenderer.getRebuiltCount());
+}
+
+// ----------------------- FUNCTION FOR RENDERING THE HUD ONE CHARACTER AT A TIME ----------------------- //
+void renderLegacyHud(const WorldSnapshot& world)
+{
+    char timeRemainingString[100];
+    sprintf_s(timeRemainingString, "Time: %.2f", world.timeRemaining);
+
+    char coinsRemainingString[100];
+    sprintf_s(coinsRemainingString, "Coins Remaining: %d", world.coinsRemaining);
+
+    render2dText(timeRemainingString, 1.0, 1.0, 1.0, -0.98, 0.92);
+    render2dText(coinsRemainingString, 1.0, 1.0, 1.0, -0.98, 0.86);
+
+    if (world.thirdPersonCamera)
+        render2dText("Camera: Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+    else if (world.firstPersonCamera)
+        render2dText("Camera: First Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+    else if (world.freeThirdPersonCamera)
+        render2dText("Camera: Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, 0.74);
+
+    render2dText("Press 1 to change to First Person Camera", 1.0, 1.0, 1.0, -0.98, -0.50);
+    render2dText("Press 2 to change to Free Third Person Camera", 1.0, 1.0, 1.0, -0.98, -0.56);
+    render2dText("Press 3 to change to Thrid Person Camera", 1.0, 1.0, 1.0, -0.98, -0.62);
+
+    if (world.playerWon)
+    {
+        char wonMessage[100];
+        sprintf_s(wonMessage, "You collected all the coins in %.2f seconds", 60.0 - world.timeRemaining);
+        render2dText("YOU WON!", 0.0, 1.0, 0.0, -0.15, 0.5);
+        render2dText(wonMessage, 0.0, 1.0, 0.0, -0.46, 0.44);
+        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.32);
+    }
+    if (world.outOfTime)
+    {
+        char gameOverMessage[100];
+        sprintf_s(gameOverMessage, "You run out of time and had %d coins left", world.coinsRemaining);
+        render2dText("GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.5);
+        render2dText(gameOverMessage, 1.0, 0.0, 0.0, -0.4, 0.44);
+        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.41, 0.32);
+    }
+    if (world.tankFell)
+    {
+        render2dText("GAME OVER", 1.0, 0.0, 0.0, -0.15, 0.2);
+        render2dText("Press R to restart or ESC to exit the game", 1.0, 1.0, 1.0, -0.45, 0.14);
+    }
 }
 
 // ----------------------- FUNCTION FOR RENDERING 2D TEXT ----------------------- //
@@ -0,0 +1,114 @@
+#include "JobSystem.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+int main()
+{
+	long long jobs = 0, steals = 0;
+
+	// Alone, then with Workers to Steal
+	unsigned int threadCounts[4] = { 1, 2, 4, 8 };
+	for (int t = 0; t < 4; t++)
+	{
+		JobSystem jobSystem;
+		jobSystem.setThreadCount(threadCounts[t]);
+		std::string threads = " (" + std::to_string(threadCounts[t]) + " threads)";
+
+		// Constructed or Set, the Count Includes the Caller
+		JobSystem constructed(threadCounts[t]);
+		check(jobSystem.size() == threadCounts[t] && constructed.size() == threadCounts[t], "thread counts include the caller" + threads);
+
+		// Every Index Run Once, in Blocks Starting on the Grain, over Counts and Grains that Do and Do Not Divide
+		bool coveredOnce = true, onGrain = true;
+		std::vector<std::atomic<int>> runs(20000);
+		for (int iteration = 0; iteration < 2000; iteration++)
+		{
+			int count = 1 + (iteration * 7919) % 20000;
+			int grainSize = 1 + iteration % 300;
+			for (int i = 0; i < count; i++)
+				runs[i].store(0, std::memory_order_relaxed);
+
+			std::atomic<bool> blockOffGrain(false);
+			jobSystem.parallelFor(count, [&](int begin, int end)
+			{
+				if (begin % grainSize != 0)
+					blockOffGrain = true;
+				for (int i = begin; i < end; i++)
+					runs[i].fetch_add(1, std::memory_order_relaxed);
+			}, grainSize);
+
+			for (int i = 0; i < count; i++)
+				coveredOnce = coveredOnce && runs[i].load(std::memory_order_relaxed) == 1;
+			onGrain = onGrain && !blockOffGrain;
+		}
+		check(coveredOnce, "parallelFor runs every index exactly once" + threads);
+		check(onGrain, "parallelFor blocks start on the grain" + threads);
+
+		// A parallelFor Inside Each Block of Another, its Waits Running the Outer One's Jobs
+		std::atomic<long long> sum(0);
+		jobSystem.parallelFor(64, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				jobSystem.parallelFor(1000, [&](int innerBegin, int innerEnd)
+				{
+					long long part = 0;
+					for (int k = innerBegin; k < innerEnd; k++)
+						part += k;
+					sum += part;
+				}, 7);
+			}
+		}, 1);
+		check(sum == 64 * 499500ll, "nested parallelFor sums every index" + threads);
+
+		// A Job Waiting on a Counter Only Goes On Once Every Job Run Against it has Finished
+		JobCounter stages, finish;
+		std::atomic<int> stage(0);
+		bool sawAllStages = false;
+		for (int i = 0; i < 100; i++)
+			jobSystem.run([&]() { stage++; }, stages);
+		jobSystem.run([&]()
+		{
+			jobSystem.wait(stages);
+			sawAllStages = stage == 100;
+			stage += 1000;
+		}, finish);
+		jobSystem.wait(finish);
+		check(sawAllStages && stage == 1100 && stages.isDone() && finish.isDone(), "a job waiting on a counter runs after every job run against it" + threads);
+
+		// Threads Other than the Workers Running their Own parallelFors at Once
+		std::atomic<long long> externalSum(0);
+		std::vector<std::thread> external;
+		for (int i = 0; i < 3; i++)
+		{
+			external.push_back(std::thread([&]()
+			{
+				for (int repeat = 0; repeat < 200; repeat++)
+					jobSystem.parallelFor(5000, [&](int begin, int end) { externalSum += end - begin; }, 64);
+			}));
+		}
+		for (int i = 0; i < external.size(); i++)
+			external[i].join();
+		check(externalSum == 3 * 200 * 5000ll, "parallelFor from other threads at once covers every range" + threads);
+
+		// Many More Jobs than a Ring Holds, so it Wraps and Some Run on the Spot
+		JobCounter ring;
+		std::atomic<int> ran(0);
+		for (int i = 0; i < JobSystem::jobsPerThread * 12; i++)
+			jobSystem.run([&]() { ran++; }, ring);
+		jobSystem.wait(ring);
+		check(ran == JobSystem::jobsPerThread * 12, "every job runs when the ring wraps" + threads);
+
+		jobs += jobSystem.getJobCount();
+		steals += jobSystem.getStealCount();
+	}
+
+	if (failures == 0)
+		std::cout << "Job system: all passed, " << jobs << " jobs, " << steals << " steals" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "MeshBVH.h"
+#include "Matrix.h"
+#include "Vector.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <vector>
+
+
+struct Point
+{
+	float v[3];
+};
+
+// Whether Anything of a Triangle is Left after Cutting Away what is Outside Each Face of the Box in Turn,
+// a Different Route to the Answer from the Separating Axes the Hierarchy Tests
+static bool clipTouches(const Point* corners, const float* minimum, const float* maximum, float grow)
+{
+	std::vector<Point> polygon(corners, corners + 3), clipped;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			float plane = side == 0 ? minimum[axis] - grow : maximum[axis] + grow;
+			float sign = side == 0 ? 1.0f : -1.0f;
+			clipped.clear();
+			for (int i = 0; i < polygon.size(); i++)
+			{
+				const Point& a = polygon[i];
+				const Point& b = polygon[(i + 1) % polygon.size()];
+				float da = (a.v[axis] - plane) * sign;
+				float db = (b.v[axis] - plane) * sign;
+				if (da >= 0.0f)
+					clipped.push_back(a);
+				if ((da >= 0.0f) != (db >= 0.0f))
+				{
+					Point crossing;
+					float t = da / (da - db);
+					for (int k = 0; k < 3; k++)
+						crossing.v[k] = a.v[k] + (b.v[k] - a.v[k]) * t;
+					crossing.v[axis] = plane;
+					clipped.push_back(crossing);
+				}
+			}
+			polygon.swap(clipped);
+			if (polygon.empty())
+				return false;
+		}
+	}
+	return true;
+}
+
+// Every Triangle Moved into the World and Clipped, 1 for a Hit, 0 for None, -1 when Growing or Shrinking the Box
+// a Little Changes the Answer, so Rounding could Decide it Either Way
+static int bruteTouches(const std::vector<float>& positions, Matrix4x4 model, Vector3f min, Vector3f max)
+{
+	const float* m = model.getPtr();
+	float minimum[3] = { min.x, min.y, min.z };
+	float maximum[3] = { max.x, max.y, max.z };
+	bool inner = false, outer = false;
+	for (int t = 0; t < positions.size() / 9; t++)
+	{
+		Point corners[3];
+		for (int v = 0; v < 3; v++)
+		{
+			const float* p = &positions[t * 9 + v * 3];
+			for (int i = 0; i < 3; i++)
+				corners[v].v[i] = m[i] * p[0] + m[4 + i] * p[1] + m[8 + i] * p[2] + m[12 + i];
+		}
+		inner = inner || clipTouches(corners, minimum, maximum, -1.0e-3f);
+		outer = outer || clipTouches(corners, minimum, maximum, 1.0e-3f);
+		if (inner)
+			return 1;
+	}
+	return outer ? -1 : 0;
+}
+
+
+int main()
+{
+	unsigned int seed = 11;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+	auto uniform = [&random](float low, float high) { return low + (high - low) * (random() / 16777216.0f); };
+
+	// Nothing Built Touches Nothing
+	MeshBVH empty;
+	empty.build(std::vector<float>());
+	Matrix4x4 identity;
+	check(!empty.intersectsBox(identity, Vector3f(-1.0, -1.0, -1.0), Vector3f(1.0, 1.0, 1.0)), "empty hierarchy touches no box");
+
+	// A Soup of Small Triangles with a Few Long Slivers Across it
+	std::vector<float> positions;
+	for (int t = 0; t < 1500; t++)
+	{
+		float size = t % 50 == 0 ? 15.0f : 1.5f;
+		Vector3f centre(uniform(-10.0, 10.0), uniform(-10.0, 10.0), uniform(-10.0, 10.0));
+		for (int v = 0; v < 3; v++)
+		{
+			positions.push_back(centre.x + uniform(-size, size));
+			positions.push_back(centre.y + uniform(-size, size));
+			positions.push_back(centre.z + uniform(-size, size));
+		}
+	}
+	MeshBVH bvh;
+	bvh.build(positions);
+	check(bvh.getTriangleCount() == 1500, "every triangle is kept");
+	check(bvh.getLeafCount() > 1500 / MeshBVH::maxLeafTriangles / 2, "triangles are split into leaves");
+
+	// Moved, Turned and Scaled, Boxes Touch what Testing Every Triangle Says they Do, and the Bounds Hold Every Corner
+	int mismatches = 0, boxes = 0, hits = 0, ambiguous = 0;
+	bool boundsHold = true;
+	for (int i = 0; i < 10; i++)
+	{
+		Matrix4x4 model;
+		model.translate(uniform(-20.0, 20.0), uniform(-20.0, 20.0), uniform(-20.0, 20.0));
+		model.rotate(uniform(0.0, 360.0), uniform(-1.0, 1.0), uniform(0.1, 1.0), uniform(-1.0, 1.0));
+		model.scale(uniform(0.5, 2.0), uniform(0.5, 2.0), uniform(0.5, 2.0));
+		if (i == 0)
+			model.toIdentity();
+
+		Vector3f boundsMin, boundsMax;
+		bvh.getBounds(model, boundsMin, boundsMax);
+		const float* m = model.getPtr();
+		for (int p = 0; p < positions.size(); p += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				float world = m[k] * positions[p] + m[4 + k] * positions[p + 1] + m[8 + k] * positions[p + 2] + m[12 + k];
+				float low = k == 0 ? boundsMin.x : (k == 1 ? boundsMin.y : boundsMin.z);
+				float high = k == 0 ? boundsMax.x : (k == 1 ? boundsMax.y : boundsMax.z);
+				boundsHold = boundsHold && world >= low - 1.0e-3f && world <= high + 1.0e-3f;
+			}
+		}
+
+		Vector3f centre = (boundsMin + boundsMax) * 0.5f;
+		Vector3f reach = (boundsMax - boundsMin) * 0.5f;
+		for (int k = 0; k < 300; k++)
+		{
+			Vector3f middle(centre.x + uniform(-reach.x, reach.x), centre.y + uniform(-reach.y, reach.y), centre.z + uniform(-reach.z, reach.z));
+			Vector3f half(uniform(0.1, 5.0), uniform(0.1, 5.0), uniform(0.1, 5.0));
+			int expected = bruteTouches(positions, model, middle - half, middle + half);
+			if (expected < 0)
+			{
+				ambiguous++;
+				continue;
+			}
+			bool found = bvh.intersectsBox(model, middle - half, middle + half);
+			boxes++;
+			if (found != (expected == 1))
+				mismatches++;
+			if (found)
+				hits++;
+		}
+	}
+	check(boundsHold, "bounds hold every corner of the moved mesh");
+	check(mismatches == 0, std::to_string(mismatches) + " of " + std::to_string(boxes) + " random boxes differ from testing every triangle");
+	check(hits > boxes / 10 && hits < boxes * 9 / 10, "random boxes hit and miss often enough to test");
+
+	if (failures == 0)
+		std::cout << "Mesh BVH: all passed, " << boxes << " random boxes, " << hits << " hits, " << ambiguous << " too close to call" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Matrix.h"
+#include "Vector.h"
+#include "TestCheck.h"
+
+#include <iostream>
+
+
+int main()
+{
+	// Camera at the Origin Looking Down -z, as the Game Projects
+	Matrix4x4 projection;
+	projection.perspective(90, 1.0, 0.1, 1000.0);
+	Matrix4x4 view;
+	view.lookAt(Vector3f(0.0, 0.0, 0.0), Vector3f(0.0, 0.0, -1.0), Vector3f(0.0, 1.0, 0.0));
+	Matrix4x4 viewProjection = projection * view;
+
+	// Rasterised in One Band and in Several, which Must Agree
+	unsigned int threadCounts[2] = { 1, 4 };
+	for (int i = 0; i < 2; i++)
+	{
+		JobSystem jobSystem;
+		jobSystem.setThreadCount(threadCounts[i]);
+		OcclusionCuller culler(jobSystem);
+		std::string threads = " (" + std::to_string(threadCounts[i]) + " threads)";
+
+		// Nothing Drawn Hides Nothing
+		culler.beginFrame(viewProjection);
+		culler.rasterise();
+		check(culler.isVisible(Vector3f(-1.0, -1.0, -41.0), Vector3f(1.0, 1.0, -40.0)), "box with no occluders is visible" + threads);
+
+		// A Wall 20 Wide, 20 Away, Covering the Middle Half of the Screen
+		culler.beginFrame(viewProjection);
+		culler.addOccluder(Vector3f(-10.0, -10.0, -21.0), Vector3f(10.0, 10.0, -20.0));
+		culler.rasterise();
+
+		int centre = culler.getWidth() / 2;
+		check(culler.depthAt(centre, centre) < 1.0f, "wall is drawn into the middle of the depth buffer" + threads);
+		check(culler.depthAt(0, 0) >= 1.0f, "corner of the depth buffer is left clear" + threads);
+
+		check(culler.isVisible(Vector3f(-1.0, -1.0, -6.0), Vector3f(1.0, 1.0, -5.0)), "box in front of the wall is visible" + threads);
+		check(culler.isVisible(Vector3f(-15.0, -15.0, -19.0), Vector3f(15.0, 15.0, -18.0)), "box in front, larger than the wall, is visible" + threads);
+		check(!culler.isVisible(Vector3f(-1.0, -1.0, -41.0), Vector3f(1.0, 1.0, -40.0)), "box behind the wall is occluded" + threads);
+		check(!culler.isVisible(Vector3f(-15.0, -15.0, -61.0), Vector3f(15.0, 15.0, -60.0)), "large box far behind the wall is occluded" + threads);
+		check(culler.isVisible(Vector3f(-25.0, -1.0, -41.0), Vector3f(-15.0, 1.0, -40.0)), "box behind, past the wall's edge, is visible" + threads);
+		check(culler.isVisible(Vector3f(-35.0, -1.0, -41.0), Vector3f(-25.0, 1.0, -40.0)), "box behind, beside the wall, is visible" + threads);
+		check(!culler.isVisible(Vector3f(-1.0, -1.0, 5.0), Vector3f(1.0, 1.0, 6.0)), "box behind the camera is culled" + threads);
+		check(culler.isVisible(Vector3f(-1.0, -1.0, -1.0), Vector3f(1.0, 1.0, 1.0)), "box around the camera is visible" + threads);
+
+		OcclusionCuller::Stats stats = culler.getStats();
+		check(stats.occluders == 1, "one occluder counted" + threads);
+		check(stats.tested == 8, "every test counted" + threads);
+		check(stats.occluded == 2, "two boxes counted as occluded" + threads);
+		check(stats.frustumCulled == 1, "one box counted as outside the frustum" + threads);
+	}
+
+	if (failures == 0)
+		std::cout << "Occlusion culler: all passed" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include "SweptCollision.h"
+#include "GridIndex.h"
+#include "LevelGrid.h"
+#include "Vector.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <vector>
+
+
+static bool near(float a, float b)
+{
+	return fabsf(a - b) <= 1.0e-5f;
+}
+
+// Wall and Coin Boxes the Ball Sweeps Against in the Game, Already Grown by the Ball
+static const Vector3f wallMin(-15.0, -15.5, -15.0), wallMax(15.0, 15.5, 15.0);
+static const Vector3f coinMin(-2.0, 16.0, -1.15), coinMax(2.0, 18.0, 1.15);
+
+
+/* Slab test of the step against a box, entered through a face, written apart from the one under test */
+static bool bruteEnters(const float* origin, const float* delta, const float* minimum, const float* maximum, float& time)
+{
+	float tEnter = 0.0, tExit = 1.0;
+	bool entered = false;
+	for (int a = 0; a < 3; a++)
+	{
+		if (fabsf(delta[a]) < 1.0e-8f)
+		{
+			if (origin[a] < minimum[a] || origin[a] > maximum[a])
+				return false;
+			continue;
+		}
+		float t0 = (minimum[a] - origin[a]) / delta[a];
+		float t1 = (maximum[a] - origin[a]) / delta[a];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > tEnter)
+		{
+			tEnter = t0;
+			entered = true;
+		}
+		tExit = std::min(tExit, t1);
+		if (tEnter > tExit)
+			return false;
+	}
+	time = tEnter;
+	return entered;
+}
+
+/* Earliest hit over every box of every cell, a coin winning a tie as in the sweep, time above 1 for none */
+static float bruteSweep(const LevelGrid& map, Vector3f from, Vector3f to, bool& coin)
+{
+	float o[3] = { from.x, from.y, from.z };
+	float d[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+	float best = 2.0;
+	coin = false;
+	for (int z = 0; z < map.getDepth(); z++)
+	{
+		for (int x = 0; x < map.getWidth(); x++)
+		{
+			int value = map.get(x, z);
+			if (value == 0)
+				continue;
+
+			float time;
+			float minimum[3] = { x * 30.0f + wallMin.x, wallMin.y, z * 30.0f + wallMin.z };
+			float maximum[3] = { x * 30.0f + wallMax.x, wallMax.y, z * 30.0f + wallMax.z };
+			if (bruteEnters(o, d, minimum, maximum, time) && time < best)
+			{
+				best = time;
+				coin = false;
+			}
+			float coinMinimum[3] = { x * 30.0f + coinMin.x, coinMin.y, z * 30.0f + coinMin.z };
+			float coinMaximum[3] = { x * 30.0f + coinMax.x, coinMax.y, z * 30.0f + coinMax.z };
+			if (value == 2 && bruteEnters(o, d, coinMinimum, coinMaximum, time) && time <= best)
+			{
+				best = time;
+				coin = true;
+			}
+		}
+	}
+	return best;
+}
+
+static void makeMap(LevelGrid& map, int width, int depth, const std::vector<int>& walls, const std::vector<int>& coins)
+{
+	std::vector<unsigned char> cells(width * depth, 0);
+	for (int i = 0; i < walls.size(); i++)
+		cells[walls[i]] = 1;
+	for (int i = 0; i < coins.size(); i++)
+		cells[coins[i]] = 2;
+	map.setLevel(width, depth, &cells[0]);
+}
+
+
+int main()
+{
+	SweptCollision::Hit hit;
+	int cellsCrossed;
+	LevelGrid map;
+	GridIndex grid;
+
+	// A Row of 20 Cells with a Wall at x = 10, Centred on 300, and a Wall with a Coin at x = 15
+	makeMap(map, 20, 1, { 10 }, { 15 });
+	grid.build(map);
+
+	// A Step of 100000 Units, Over 3000 Cells, still Stops at the Wall's Near Face
+	check(SweptCollision::sweep(grid, Vector3f(0.0, 0.0, 0.0), Vector3f(100000.0, 0.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme step along x hits the wall");
+	check(!hit.coin && hit.x == 10 && hit.z == 0 && hit.axis == 0 && near(hit.time, 285.0f / 100000.0f), "extreme step along x stops at x = 285");
+
+	// The Same Step at Coin Height Passes Over the Wall and Collects the Coin
+	check(SweptCollision::sweep(grid, Vector3f(0.0, 17.0, 0.0), Vector3f(100000.0, 17.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme step at coin height hits the coin");
+	check(hit.coin && hit.x == 15 && hit.axis == 0 && near(hit.time, 448.0f / 100000.0f), "extreme step at coin height stops at x = 448");
+
+	// Backwards, Starting Beyond the Map, into the Wall Under the Coin
+	check(SweptCollision::sweep(grid, Vector3f(50000.0, 0.0, 0.0), Vector3f(-50000.0, 0.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme step from beyond the map hits the wall");
+	check(!hit.coin && hit.x == 15 && near(hit.time, (50000.0f - 465.0f) / 100000.0f), "extreme step backwards stops at x = 465");
+	check(cellsCrossed <= 20, "cells crossed are those of the map, not of the whole step");
+
+	// Falling onto the Top of a Wall
+	check(SweptCollision::sweep(grid, Vector3f(300.0, 1000.0, 0.0), Vector3f(300.0, -100000.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme fall lands on the wall");
+	check(!hit.coin && hit.x == 10 && hit.axis == 1 && near(hit.time, (1000.0f - 15.5f) / 101000.0f), "extreme fall stops at the wall's top");
+
+	// A Step Ending Short of the Wall, or Starting Inside it, Hits Nothing
+	check(!SweptCollision::sweep(grid, Vector3f(200.0, 0.0, 0.0), Vector3f(284.0, 0.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"step ending short of the wall misses");
+	check(!SweptCollision::sweep(grid, Vector3f(300.0, 0.0, 0.0), Vector3f(400.0, 0.0, 0.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"step leaving the wall it starts inside misses");
+
+	// Diagonally Across a 16 x 16 Map to a Lone Wall at (7, 7)
+	makeMap(map, 16, 16, { 7 * 16 + 7 }, {});
+	grid.build(map);
+	check(SweptCollision::sweep(grid, Vector3f(0.0, 0.0, 0.0), Vector3f(3000.0, 0.0, 3000.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme diagonal step hits the wall");
+	check(hit.x == 7 && hit.z == 7 && near(hit.time, 195.0f / 3000.0f), "extreme diagonal step stops at the wall's corner");
+	check(!SweptCollision::sweep(grid, Vector3f(0.0, 0.0, 30.0), Vector3f(3000.0, 0.0, 3030.0), wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed),
+		"extreme diagonal step beside the wall misses");
+
+	// Random Maps and Steps of up to 46 Cells Match Testing Every Box
+	unsigned int seed = 7;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+	auto uniform = [&random](float low, float high) { return low + (high - low) * (random() / 16777216.0f); };
+	int mismatches = 0, hits = 0, sweeps = 0;
+	for (int i = 0; i < 100; i++)
+	{
+		int width = 1 + random() % 40, depth = 1 + random() % 40;
+		std::vector<unsigned char> cells(width * depth);
+		for (int c = 0; c < cells.size(); c++)
+			cells[c] = random() % 3 == 0 ? 0 : (random() % 3 == 0 ? 2 : 1);
+		map.setLevel(width, depth, &cells[0]);
+		grid.build(map);
+
+		for (int k = 0; k < 1000; k++)
+		{
+			Vector3f from(uniform(-100.0, 1300.0), uniform(-40.0, 60.0), uniform(-100.0, 1300.0));
+			Vector3f to(uniform(-100.0, 1300.0), uniform(-40.0, 60.0), uniform(-100.0, 1300.0));
+			if (k % 3 == 0)
+				to = from + (to - from) * 0.01f;
+
+			bool coin;
+			float expected = bruteSweep(map, from, to, coin);
+			bool found = SweptCollision::sweep(grid, from, to, wallMin, wallMax, coinMin, coinMax, hit, cellsCrossed);
+			sweeps++;
+			if (found != (expected <= 1.0f) || (found && fabsf(hit.time - expected) > 1.0e-4f))
+				mismatches++;
+			if (found)
+				hits++;
+		}
+	}
+	check(mismatches == 0, std::to_string(mismatches) + " of " + std::to_string(sweeps) + " random sweeps differ from testing every box");
+	check(hits > sweeps / 10, "random sweeps hit something often enough to test");
+
+	if (failures == 0)
+		std::cout << "Swept collision: all passed, " << sweeps << " random sweeps, " << hits << " hits" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#ifndef TESTCHECK_H_
+#define TESTCHECK_H_
+
+#include <iostream>
+#include <string>
+
+/*
+ * Checks Shared by the Tests
+ * Each test is a program of its own, so the failures are counted per program and main returns
+ * non zero if any check failed.
+ */
+static int failures = 0;
+
+static void check(bool passed, const std::string& what)
+{
+	if (!passed)
+	{
+		std::cout << "FAILED: " << what << std::endl;
+		failures++;
+	}
+}
+
+#endif